@@ -0,0 +1,30 @@
+/**
+ * arena.h
+ * Copyright (C) 2024 Paul Passeron
+ * ARENA header file
+ * Paul Passeron <paul.passeron2@gmail.com>
+ */
+
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+
+typedef struct arena_block_t arena_block_t;
+
+// Bump allocator: allocations are never freed one by one, the whole arena is
+// released at once.
+typedef struct arena_t {
+  arena_block_t *blocks; // most recent first
+} arena_t;
+
+void *arena_alloc(arena_t *a, size_t size);
+
+// Frees every allocation of the arena, which can then be reused.
+void arena_release(arena_t *a);
+
+// Moves the allocations of from to a, to be released with it. from is left
+// empty.
+void arena_adopt(arena_t *a, arena_t *from);
+
+#endif // ARENA_H
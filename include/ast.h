@@ -8,6 +8,7 @@
 #ifndef AST_H
 #define AST_H
 
+#include "arena.h"
 #include "lexer.h"
 
 typedef struct ast_t ast_t;
@@ -230,6 +231,15 @@ struct ast_t {
   ast_as_t as;
 };
 
+// Nodes, and the arrays and tokens they are built from, are allocated in the
+// current AST arena of the thread and never freed one by one: a tree goes away
+// when the arena it was parsed into is released. Returns the previous arena.
+arena_t *set_ast_arena(arena_t *arena);
+
+arena_t *get_ast_arena(void);
+
+void *ast_alloc(size_t size);
+
 ast_t *new_return(ast_t *expr);
 
 ast_t *new_while_stmt(ast_t *cond, ast_t *body);
@@ -255,10 +265,8 @@ ast_t *new_fundef(token_t name, size_t param_count, ast_t **param_types,
                   token_t *param_names, ast_t *body, ast_t *return_type);
 
 ast_t *new_compound(ast_t **elems);
-void free_compound(ast_t *ast);
 
 ast_t *new_program(ast_t **elems);
-void free_program(ast_t *ast);
 
 ast_t *new_unop(token_t op, ast_t *operand);
 
@@ -274,46 +282,32 @@ ast_t *new_fundef_from_parser(token_t id, tmp_param_t **arglist,
                               ast_t *stmt_list, ast_t *return_type);
 
 ast_t *new_identifier(token_t tok);
-void free_identifier(ast_t *iden);
 
 ast_t *new_floatlit(token_t tok);
-void free_floatlit(ast_t *iden);
 
 ast_t *new_charlit(token_t tok);
-void free_charlit(ast_t *iden);
 
 ast_t *new_stringlit(token_t tok);
-void free_stringlit(ast_t *iden);
 
 ast_t *new_intlit(token_t tok);
-void free_intlit(ast_t *iden);
 
 ast_t *new_boollit(int val);
-void free_boollit(ast_t *iden);
 
 ast_t *new_as_dir(ast_t *type, ast_t *expr);
-void free_as_dir(ast_t *ast);
 
 ast_t *new_new_dir(ast_t *type, ast_t *expr);
-void free_new_dir(ast_t *ast);
 
 ast_t *new_include_dir(ast_t *expr);
-void free_include_dir(ast_t *ast);
 
 ast_t *new_size_dir(ast_t *type);
-void free_size_dir(ast_t *ast);
 
 ast_t *new_tempelem(ast_t *t, ast_t *interface);
-void free_tempelem(ast_t *ast);
 
 ast_t *new_interface(token_t type, token_t name, ast_t **protos,
                      size_t protos_count);
-void free_interface(ast_t *ast);
 
 ast_t *new_template(ast_t **elems);
-void free_template(ast_t *ast);
 
 void dump_ast(ast_t *ast);
-void free_ast(ast_t *ast);
 
 #endif // AST_H
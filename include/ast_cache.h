@@ -0,0 +1,42 @@
+/**
+ * ast_cache.h
+ * Copyright (C) 2024 Paul Passeron
+ * AST_CACHE header file
+ * Paul Passeron <paul.passeron2@gmail.com>
+ */
+
+#ifndef AST_CACHE_H
+#define AST_CACHE_H
+
+#include "ast.h"
+#include "source.h"
+
+// Parsed includes are cached on disk as flat ASTs, in $XDG_CACHE_HOME/unilang
+// or ~/.cache/unilang. An entry is keyed by a hash of the bytes of the source
+// and is only read back by a compiler of the same AST_CACHE_VERSION.
+#define AST_CACHE_VERSION 3
+
+// 64-bit FNV-1a of some bytes, that differs between versions of the cache.
+uint64_t ast_cache_hash(string_view_t bytes);
+
+// Same, going on from the hash h of the bytes before them.
+uint64_t ast_cache_hash_more(uint64_t h, const void *bytes, size_t size);
+
+// Directory of the cache, false if there is none.
+bool ast_cache_dir(char *dir, size_t size);
+
+// Same, creating the directory if needed.
+bool create_ast_cache_dir(char *dir, size_t size);
+
+// Set to false by --no-ast-cache.
+extern bool ast_cache_enabled;
+
+// Tree of a source, built in the current AST arena from its cache entry. NULL
+// if there is no valid entry, in which case the source has to be parsed.
+ast_t *load_cached_ast(source_t *src);
+
+// Writes the cache entry of a parsed source. Failing to write it is not an
+// error: the source is just parsed again next time.
+void store_cached_ast(source_t *src, ast_t *prog);
+
+#endif // AST_CACHE_H
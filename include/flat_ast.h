@@ -0,0 +1,87 @@
+/**
+ * flat_ast.h
+ * Copyright (C) 2024 Paul Passeron
+ * FLAT_AST header file
+ * Paul Passeron <paul.passeron2@gmail.com>
+ */
+
+#ifndef FLAT_AST_H
+#define FLAT_AST_H
+
+#include "ast.h"
+#include <stdint.h>
+
+// Index of a node in a flat AST, FLAT_NONE for a missing child.
+typedef uint32_t flat_id_t;
+
+#define FLAT_NONE 0
+
+// Node flags, by kind.
+#define FLAT_TEMPLATE 1 // AST_TYPE: is_template
+#define FLAT_ABSTRACT 1 // AST_METHOD: is_abstract
+#define FLAT_STATIC 2   // AST_METHOD, AST_MEMBER: is_static
+#define FLAT_TRUE 1     // AST_BOOLLIT: val
+
+// 36 bytes whatever the kind, against sizeof(ast_t) for the tree. Nodes are
+// laid out in pre-order, so a function body is one contiguous run of nodes.
+//
+// tok:  identifier and literal token, name (fundef, type, vardef, ct_cte,
+//       class, interface), operator (unop, binop), specifier (method, member)
+// kids: in the order of the fields of the matching ast_*_t, e.g. cond, body,
+//       other_body for AST_IFSTMT, return_type, body for AST_FUNDEF
+// list: elements (compound, program, template), args (funcall), fields
+//       (class), protos (interface) or params (fundef)
+//
+// A fundef parameter is an AST_VARDEF node without a value, and the type
+// token of an interface is an AST_IDENTIFIER node in kids[0].
+typedef struct flat_node_t {
+  token_t tok;
+  uint8_t kind;
+  uint8_t flags;
+  uint16_t ptr_n;
+  flat_id_t kids[3];
+  uint32_t first; // list of children, in the lists of the flat AST
+  uint32_t count;
+} flat_node_t;
+
+typedef struct flat_nodes_t {
+  flat_node_t *items;
+  size_t count;
+  size_t capacity;
+} flat_nodes_t;
+
+typedef struct flat_lists_t {
+  flat_id_t *items;
+  size_t count;
+  size_t capacity;
+} flat_lists_t;
+
+typedef struct flat_ast_t {
+  flat_nodes_t nodes; // nodes.items[FLAT_NONE] is a placeholder
+  flat_lists_t lists;
+  bool failed; // set by the last flatten_ast() or unflatten_ast() that failed
+} flat_ast_t;
+
+// Appends a tree to a flat AST and returns the id of its root. FLAT_NONE if
+// the tree has a node of an unknown kind or has too many nodes, in which case
+// the flat AST is left with a partial copy of it.
+flat_id_t flatten_ast(flat_ast_t *f, ast_t *ast);
+
+// Builds back the tree of a node, in the current AST arena. NULL if it has a
+// node of an unknown kind. Only memory safe on a flat AST that passes
+// valid_flat_ast().
+ast_t *unflatten_ast(flat_ast_t *f, flat_id_t id);
+
+// Whether root and the nodes after it are one tree laid out as by
+// flatten_ast(), with in-range kids and lists, known kinds, and tokens within
+// a source of source_length bytes. To check a flat AST read from a file.
+bool valid_flat_ast(flat_ast_t *f, flat_id_t root, size_t source_length);
+
+void free_flat_ast(flat_ast_t *f);
+
+flat_node_t *flat_node(flat_ast_t *f, flat_id_t id);
+
+// Id of the i-th element of the list of a node.
+flat_id_t flat_list_at(flat_ast_t *f, flat_node_t *n, size_t i);
+
+#endif // FLAT_AST_H
@@ -10,6 +10,8 @@
 
 #include "ast.h"
 #include "dynarr.h"
+#include "intern.h"
+#include "symbol_index.h"
 #include <llvm-c/Types.h>
 
 typedef struct type_t type_t;
@@ -64,7 +66,7 @@ typedef struct strings {
 } strings;
 
 struct type_t {
-  const char *name;
+  symbol_t name; // NO_SYMBOL for pointer and incomplete types
   typekind_t kind;
   LLVMTypeRef type;
   type_t *pointed_by;
@@ -72,6 +74,26 @@ struct type_t {
   ast_t *ast;
 };
 
+// Canonical copy of a type: two equal types, field by field, have the same
+// node. Pointer types point to the node of their pointee.
+typedef struct type_node_t {
+  type_t t; // first, so that a node is pointed to as a type
+  LLVMTypeRef ptr_type; // of pointers to it, NULL until needed or if unstable
+} type_node_t;
+
+typedef struct type_nodes {
+  type_node_t **items;
+  size_t count;
+  size_t capacity;
+} type_nodes;
+
+// Type of an expression, as found while types_epoch was epoch.
+typedef struct expr_type_t {
+  ast_t *expr; // NULL for an empty slot
+  size_t epoch;
+  type_t t;
+} expr_type_t;
+
 typedef struct defer_elem_t {
   int scope;
   type_t t;
@@ -87,7 +109,7 @@ typedef struct defers {
 typedef enum specifier_t { PUBLIC, PRIVATE } specifier_t;
 
 struct method_t {
-  char *name;
+  symbol_t name;
   specifier_t specifier;
   strings arg_names;
   types arg_types;
@@ -138,7 +160,7 @@ typedef struct interfaces {
 } interfaces;
 
 struct class_entry_t {
-  const char *name;
+  symbol_t name;
   methods methods;
   constructors constructors;
   members members;
@@ -170,9 +192,10 @@ struct function_entry_t {
 };
 
 struct named_value_entry_t {
-  char *name;
+  symbol_t name; // NO_SYMBOL for a scope mark
   type_t t;
   LLVMValueRef value;
+  size_t shadowed; // index + 1 of the value it hides, 0 if none
 };
 
 typedef struct ptrs {
@@ -192,6 +215,40 @@ typedef struct templates {
   size_t capacity;
 } templates;
 
+// Binop chains are walked in post-order with explicit stacks, whatever their
+// depth: a frame is visited once to push its operands, once to combine them.
+typedef struct expr_walk_frame_t {
+  ast_t *expr;
+  bool expanded;
+} expr_walk_frame_t;
+
+typedef struct expr_walk {
+  expr_walk_frame_t *items;
+  size_t count;
+  size_t capacity;
+} expr_walk;
+
+// Value of an operand, if generated, and the types its own operands had.
+typedef struct operand_t {
+  LLVMValueRef value;
+  ast_t *expr;
+  type_t lt;
+  type_t rt;
+  bool is_leaf; // typed as an expression, lt and rt are unknown
+} operand_t;
+
+typedef struct operands {
+  operand_t *items;
+  size_t count;
+  size_t capacity;
+} operands;
+
+typedef struct indices {
+  size_t *items;
+  size_t count;
+  size_t capacity;
+} indices;
+
 typedef struct generator_t generator_t;
 struct generator_t {
   LLVMContextRef context;
@@ -211,6 +268,39 @@ struct generator_t {
   struct interfaces interfaces;
   struct inst_classes inst_classes;
   struct strings included_files;
+  struct expr_walk expr_walk;
+  struct operands operands;
+  // Hash indices of the tables above, see index_type(). Types can be removed
+  // from anywhere in their table: their indices are rebuilt on the next
+  // lookup after that.
+  bool types_indexed;
+  symbol_index_t type_names;
+  symbol_index_t type_llvms;
+  struct indices unstable_types; // whose LLVM type depends on the context
+  struct type_nodes type_nodes;
+  type_node_t **type_slots; // hash table of type_nodes, NULL for empty slots
+  size_t type_slot_count;
+  // Types of the expressions typed so far, by address. They stay valid until
+  // the epoch changes, i.e. until a type is added or removed, e.g. when a
+  // template instantiation binds or unbinds its aliases, or until a scope of
+  // named values is left.
+  size_t types_epoch;
+  expr_type_t *expr_types; // hash table
+  size_t expr_type_slots;
+  size_t expr_types_used;
+  symbol_index_t function_names;
+  symbol_index_t class_names;
+  // Index + 1 of the newest named value of each symbol, 0 if none. Values
+  // are pushed and popped with their scopes, and only the newest one of a
+  // name is ever looked up.
+  struct indices value_of_symbol;
+  // Names of the builtin types that typing and lowering ask for.
+  symbol_t void_name;
+  symbol_t float_name;
+  symbol_t int_name;
+  symbol_t i32_name;
+  symbol_t bool_name;
+  symbol_t char_name;
 };
 
 typedef struct ltypes {
@@ -231,11 +321,13 @@ void generator_free(generator_t *generator);
 void set_global_generator(generator_t *g);
 generator_t *get_global_generator(void);
 
+type_node_t *intern_type(type_t t);
 type_t get_ptr_of(type_t t);
-type_t get_type_from_name(const char *name);
+type_t get_type_from_name(symbol_t name);
 type_t get_type_from_llvm(LLVMTypeRef type);
 
 void add_type(type_t t);
+void remove_type(size_t index);
 void add_class(class_entry_t c);
 void add_function(function_entry_t f);
 void add_named_value(named_value_entry_t n);
@@ -275,7 +367,7 @@ type_t dereference_type(type_t t);
 
 class_entry_t entry_from_cdef(ast_class_t cdef);
 
-int get_named_value(char *name);
+int get_named_value(symbol_t name);
 
 LLVMValueRef get_lm_pointer(ast_t *lm);
 
@@ -289,9 +381,9 @@ LLVMTypeRef ftype_from_method(method_t method, class_entry_t cdef);
 
 type_t get_return_type(ast_t *funcall);
 
-class_entry_t get_class_by_name(const char *name);
-method_t get_method_by_name(class_entry_t cdef, const char *name);
-int does_method_exist(class_entry_t c, char *name);
+class_entry_t get_class_by_name(symbol_t name);
+method_t get_method_by_name(class_entry_t cdef, symbol_t name);
+int does_method_exist(class_entry_t c, symbol_t name);
 
 function_entry_t entry_from_fundef(ast_t *fundef);
 void add_function_from_entry(function_entry_t entry);
@@ -300,7 +392,7 @@ bool are_types_equal(type_t a, type_t b);
 type_t t_from_cdef(class_entry_t cdef);
 type_t sanitize_type(type_t t);
 
-type_t get_aliased_with_name(const char *name, void *ref);
+type_t get_aliased_with_name(symbol_t name, void *ref);
 
 void print_types(void);
 type_t get_type_used_in_class(class_entry_t cdef, type_t t);
@@ -314,7 +406,7 @@ int get_constructor_with_single_arg_matching_type(class_entry_t cdef,
 
 bool is_integer_type(type_t t);
 
-bool does_type_exist(const char *name);
+bool does_type_exist(symbol_t name);
 int get_class_instance_index(const char *class_name, types ts);
 
 bool is_ast_constructor(ast_t *ast);
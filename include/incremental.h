@@ -0,0 +1,30 @@
+/**
+ * incremental.h
+ * Copyright (C) 2024 Paul Passeron
+ * INCREMENTAL header file
+ * Paul Passeron <paul.passeron2@gmail.com>
+ */
+
+#ifndef INCREMENTAL_H
+#define INCREMENTAL_H
+
+#include "ast.h"
+#include "lexer.h"
+
+// Declarations of the last incremental parse reused as they were, and
+// declarations parsed again.
+typedef struct incremental_stats_t {
+  size_t reused;
+  size_t parsed;
+} incremental_stats_t;
+
+extern incremental_stats_t incremental_stats;
+
+// Same result as parse_program(). The tokens, the source and the tree of the
+// last incremental parse of the same file are kept next to the AST cache, and
+// the top-level declarations that only depended on tokens that did not change
+// since are taken from there instead of being parsed. l must have been
+// tokenized.
+ast_t *parse_program_incremental(lexer_t *l, int *worked);
+
+#endif // INCREMENTAL_H
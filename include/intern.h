@@ -0,0 +1,34 @@
+/**
+ * intern.h
+ * Copyright (C) 2024 Paul Passeron
+ * INTERN header file
+ * Paul Passeron <paul.passeron2@gmail.com>
+ */
+
+#ifndef INTERN_H
+#define INTERN_H
+
+#include "string_view.h"
+#include <stdint.h>
+
+// Identifier of an interned string: two strings have the same symbol iff they
+// have the same bytes, so names are compared as integers.
+typedef uint32_t symbol_t;
+
+// Symbol of the empty string, also used where there is no name at all, e.g.
+// for the scope marks among named values.
+#define NO_SYMBOL ((symbol_t)0)
+
+// Symbol of some bytes, that are copied the first time they are interned.
+// Only the generator interns strings: this is not thread-safe.
+symbol_t intern(string_view_t s);
+
+symbol_t intern_cstr(const char *s);
+
+// NUL-terminated bytes of a symbol, valid until the end of the program.
+const char *symbol_name(symbol_t sym);
+
+// Symbols interned so far, NO_SYMBOL included.
+size_t symbol_count(void);
+
+#endif // INTERN_H
@@ -8,21 +8,24 @@
 #ifndef LEXER_H
 #define LEXER_H
 
+#include "source.h"
 #include "string_view.h"
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
 
 typedef struct location_t {
-  const char *filename;
-  int line;
-  int col;
+  source_t *source;
+  size_t offset; // in bytes from the start of the source
   bool is_expanded;
 } location_t;
 
+// 12 bytes: the lexeme and the location are found through the source.
 typedef struct token_t {
-  location_t location;
-  string_view_t lexeme;
-  int kind;
+  uint32_t offset; // in bytes from the start of the source
+  uint32_t length;
+  int16_t kind;    // negative for the error token
+  uint16_t file;   // source id, 0 for the error token
 } token_t;
 
 typedef enum lexer_rule_kind_t {
@@ -42,27 +45,81 @@ typedef struct lexer_rule_t {
   lexer_rule_as_t as;
 } lexer_rule_t;
 
+// Gives the final kind of a scanned token, e.g. keywords among identifiers.
+typedef int (*token_classifier_t)(string_view_t lexeme, int kind);
+
 typedef struct lexer_rules_t {
   lexer_rule_t *data;
   size_t count;
   size_t size;
+  struct lexer_dfa_t *dfa; // compiled rules, NULL until compile_rules()
+  token_classifier_t classify;
 } lexer_rules_t;
 
+typedef struct tokens_t {
+  token_t *items;
+  size_t count;
+  size_t capacity;
+} tokens_t;
+
+// What every copy of a lexer shares: the rules, that are never modified once
+// compiled, and the source with its token buffer.
+typedef struct lexer_state_t {
+  const lexer_rules_t *rules;
+  source_t *source;
+  tokens_t *tokens; // filled by tokenize(), NULL to lex on the fly
+} lexer_state_t;
+
+// A position in a source. Parsers copy it to try an alternative and copy it
+// back to backtrack, which is cheap as long as it stays this small.
 typedef struct lexer_t {
-  location_t current_loc;
-  string_view_t remaining;
-  lexer_rules_t rules;
-  size_t eaten;
+  lexer_state_t *state;
+  size_t offset; // in bytes from the start of the source
+  size_t token_index;
 } lexer_t;
 
+// Tokens scanned from the source vs tokens returned by next(). Without a token
+// buffer every read is a scan, so the difference is the re-lexing avoided.
+// Counted per thread.
+typedef struct lexer_stats_t {
+  size_t scanned;
+  size_t read;
+} lexer_stats_t;
+
+extern _Thread_local lexer_stats_t lexer_stats;
+
+// One past the furthest token of the buffer looked at by next() or
+// peek_kind(), the count of tokens plus one past the end of the buffer: what a
+// parse depended on. Only ever raised, per thread.
+extern _Thread_local size_t lexer_lookahead;
+
 void print_location_t(FILE *f, location_t loc);
 
-void add_rule_to_lexer(lexer_t *l, string_view_t regexp, int value);
+// Resolves the line and column of a location. Only diagnostics need them.
+void location_line_col(location_t loc, int *line, int *col);
+
+void add_lexer_rule(lexer_rules_t *rules, string_view_t regexp, int value);
+
+void add_bad_lexer_rule(lexer_rules_t *rules, string_view_t regexp,
+                        string_view_t error);
+
+void add_skip_lexer_rule(lexer_rules_t *rules, string_view_t regexp);
+
+void set_rules_classifier(lexer_rules_t *rules, token_classifier_t classify);
 
-void add_bad_rule_to_lexer(lexer_t *l, string_view_t regexp,
-                           string_view_t error);
+void compile_rules(lexer_rules_t *rules);
 
-void add_skip_rule_to_lexer(lexer_t *l, string_view_t regexp);
+// A lexer with no source yet. The rules are compiled if needed, and must not
+// change afterwards: every lexer built from them shares them.
+lexer_t new_lexer(lexer_rules_t *rules);
+
+// Starts lexing a source from its beginning.
+void set_lexer_source(lexer_t *l, source_t *src);
+
+location_t lexer_location(lexer_t *l);
+
+// What is left of the source after the lexer.
+string_view_t lexer_remaining(lexer_t *l);
 
 bool is_done(lexer_t *l);
 
@@ -70,6 +127,12 @@ bool is_next(lexer_t *l);
 
 token_t next(lexer_t *l);
 
+void tokenize(lexer_t *l);
+
+// Skips forward to a later position of the token buffer, as if the tokens in
+// between had been read with next().
+void lexer_seek(lexer_t *l, size_t token_index);
+
 void print_error(FILE *f, lexer_t *l, string_view_t error_message);
 
 string_view_t location_to_sv(location_t loc);
@@ -80,6 +143,13 @@ bool is_error_tok(token_t tok);
 
 token_t error_token(void);
 
+string_view_t token_lexeme(token_t tok);
+
+location_t token_location(token_t tok);
+
 token_t peek_token(lexer_t *l);
 
+// Kind of the next token, without building it when it is buffered.
+int peek_kind(lexer_t *l);
+
 #endif // LEXER_H
@@ -0,0 +1,57 @@
+/**
+ * lexer_dfa.h
+ * Copyright (C) 2024 Paul Passeron
+ * LEXER_DFA header file
+ * Paul Passeron <paul.passeron2@gmail.com>
+ */
+
+#ifndef LEXER_DFA_H
+#define LEXER_DFA_H
+
+#include "string_view.h"
+#include <stddef.h>
+
+typedef struct lexer_rules_t lexer_rules_t;
+
+#define LEXER_DFA_SPAN_MAX 8
+
+// A small set of bytes, scanned for with vector compares.
+typedef struct lexer_dfa_span_t {
+  unsigned char bytes[LEXER_DFA_SPAN_MAX];
+  size_t count; // 0 if the set is unused
+} lexer_dfa_span_t;
+
+// A single deterministic automaton recognizing every rule of a lexer at once.
+//
+// Rules are matched with maximal munch: the longest prefix accepted by any
+// rule wins, ties going to SKIP rules first and then to the rule that was
+// added first. A rule whose pattern has a '*' wildcard that is not at its very
+// end (comments, string literals) stops at its shortest match, like the
+// backtracking matcher does.
+//
+// Two shortcuts let the matcher skip over runs of bytes: blanks are the bytes
+// that make up a whole SKIP token on their own (spaces, newlines, ...), and a
+// non-accepting state that loops on itself for every byte but a few (the body
+// of a comment or of a string literal) records those few exit bytes.
+typedef struct lexer_dfa_t {
+  unsigned char classes[256]; // byte -> equivalence class
+  size_t class_count;
+  int *transitions; // state * class_count + class -> state, -1 if dead
+  int *accept;      // state -> rule index, -1 if not accepting
+  lexer_dfa_span_t *exits; // state -> bytes leaving its self loop
+  size_t state_count;
+  lexer_dfa_span_t blanks;
+} lexer_dfa_t;
+
+lexer_dfa_t *compile_lexer_dfa(lexer_rules_t rules);
+
+void free_lexer_dfa(lexer_dfa_t *dfa);
+
+// Returns the index of the matching rule and sets *length to the length of
+// the match, or returns -1 if no rule matches a non-empty prefix of s.
+int lexer_dfa_match(const lexer_dfa_t *dfa, string_view_t s, size_t *length);
+
+// Length of the run of blanks at the start of s.
+size_t lexer_dfa_skip_blanks(const lexer_dfa_t *dfa, string_view_t s);
+
+#endif // LEXER_DFA_H
@@ -0,0 +1,19 @@
+/**
+ * parallel_parser.h
+ * Copyright (C) 2024 Paul Passeron
+ * PARALLEL_PARSER header file
+ * Paul Passeron <paul.passeron2@gmail.com>
+ */
+
+#ifndef PARALLEL_PARSER_H
+#define PARALLEL_PARSER_H
+
+#include "ast.h"
+#include "lexer.h"
+
+// Same result as parse_program(), with the top-level declarations split
+// between up to jobs threads. l must have been tokenized; small programs, or
+// jobs < 2, are parsed on the calling thread.
+ast_t *parse_program_parallel(lexer_t *l, int *worked, int jobs);
+
+#endif // PARALLEL_PARSER_H
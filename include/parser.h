@@ -43,6 +43,32 @@ parser_t new_chain_parser(parser_t *children, size_t count,
 parser_t new_choice_parser(parser_t *children, size_t count,
                            string_view_t error);
 
+// Where a rule failed while alternatives were being tried. Only the positions
+// and the messages are kept: nothing is formatted unless the parse fails.
+typedef struct parse_failure_t {
+  lexer_t rule_start;
+  string_view_t rule_message;
+  lexer_t at; // where the child of the rule failed
+  string_view_t message;
+} parse_failure_t;
+
+// The furthest failure since the last clear_parse_diagnostics(). Kept per
+// thread.
+typedef struct parse_diagnostics_t {
+  bool failed;
+  parse_failure_t furthest;
+} parse_diagnostics_t;
+
+extern _Thread_local parse_diagnostics_t parse_diagnostics;
+
+void clear_parse_diagnostics(void);
+
+// Keeps the failure if it is further into the source than the recorded one.
+void record_parse_failure(parse_failure_t failure);
+
+// Prints the furthest failure, if any, the way print_error() does.
+void report_parse_failure(FILE *f);
+
 void *chain_rule(lexer_t *l, parser_t self);
 
 void *choice_rule(lexer_t *l, parser_t self);
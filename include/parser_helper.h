@@ -13,8 +13,8 @@
 #include "ast.h"
 
 ast_t *parse_expression_aux(lexer_t *l, int min_precedence);
-
-ast_t *parse_increasing_precedence(lexer_t *l, ast_t *left, int min_precedence);
+// Releases the expression stack of the calling thread.
+void free_expr_frames(void);
 
 int get_precedence_aux(int kind);
 int get_precedence(int kind);
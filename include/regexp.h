@@ -10,6 +10,56 @@
 
 #include "string_view.h"
 #include <stdbool.h>
+#include <stdint.h>
+
+typedef enum regexp_op_t {
+  RE_END,   // end of the pattern or of a group body
+  RE_CHAR,  // arg: the byte
+  RE_ANY,   // '?'
+  RE_CLASS, // arg: index in classes
+  RE_GROUP, // '(...)', arg: size of the body, END included
+  RE_STAR,  // '*', shortest match unless it ends the pattern
+} regexp_op_t;
+
+typedef struct regexp_inst_t {
+  regexp_op_t op;
+  int arg;
+} regexp_inst_t;
+
+typedef struct regexp_class_t {
+  uint64_t bits[4];
+} regexp_class_t;
+
+// A pattern compiled once, that can then be matched without allocating.
+typedef struct regexp_t {
+  struct {
+    regexp_inst_t *items;
+    size_t count;
+    size_t capacity;
+  } code;
+  struct {
+    regexp_class_t *items;
+    size_t count;
+    size_t capacity;
+  } classes;
+} regexp_t;
+
+regexp_t *compile_regexp(string_view_t pattern);
+
+void free_regexp(regexp_t *re);
+
+// Returns whether the whole pattern matched a prefix of string, and sets
+// *matched to the length of that prefix.
+bool regexp_match(const regexp_t *re, string_view_t string, size_t *matched);
+
+// Reads a possibly escaped pattern byte at *i and moves past it.
+char regexp_pattern_char(string_view_t p, size_t *i);
+
+// Reads the body of a '[...]' class starting at *i, right after the '[', and
+// moves past the ']'.
+regexp_class_t regexp_parse_class(string_view_t p, size_t *i);
+
+// The functions below compile their pattern on first use and keep it.
 
 void regexp(const char *pattern, const char *string, bool *pattern_finished,
             int *string_matched);
@@ -0,0 +1,44 @@
+/**
+ * source.h
+ * Copyright (C) 2024 Paul Passeron
+ * SOURCE header file
+ * Paul Passeron <paul.passeron2@gmail.com>
+ */
+
+#ifndef SOURCE_H
+#define SOURCE_H
+
+#include "string_view.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// A source file being compiled. Positions in it are byte offsets, turned into
+// lines and columns only when they are printed.
+typedef struct source_t {
+  uint16_t id; // index in the source registry, from 1
+  const char *filename;
+  string_view_t contents;
+  size_t *line_starts; // offset of the first byte of each line, built lazily
+  size_t line_count;
+  bool mapped; // contents is a read-only mapping of the file
+} source_t;
+
+// Registers a new source. It stays valid for the whole compilation.
+source_t *new_source(const char *filename, string_view_t contents);
+
+// Loads a file as a new source. A regular file is mapped read-only, anything
+// else (a pipe, a terminal) is read into memory. Returns NULL with errno set if
+// the file cannot be opened or read.
+source_t *load_source(const char *filename);
+
+// Releases every source. Views into them are invalid afterwards.
+void free_sources(void);
+
+// Source with a given id, NULL for id 0.
+source_t *get_source(uint16_t id);
+
+// Line and column (both from 1) of a byte offset of the source.
+void source_line_col(source_t *src, size_t offset, int *line, int *col);
+
+#endif // SOURCE_H
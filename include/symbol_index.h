@@ -0,0 +1,51 @@
+/**
+ * symbol_index.h
+ * Copyright (C) 2024 Paul Passeron
+ * SYMBOL_INDEX header file
+ * Paul Passeron <paul.passeron2@gmail.com>
+ */
+
+#ifndef SYMBOL_INDEX_H
+#define SYMBOL_INDEX_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// Entry index returned when no entry has a key.
+#define SYMBOL_NONE ((size_t)-1)
+
+typedef struct symbol_slot_t {
+  const void *key;
+  size_t newest; // entry index + 1, 0 for an empty slot
+  size_t oldest; // entry index + 1
+} symbol_slot_t;
+
+// Hash index over the entries of a dynamic array, that stays the owner of the
+// keys. Several entries may have the same key: each one links to the previous
+// entry with that key, so that lookups can go from the newest to the oldest
+// like the linear searches they replace.
+typedef struct symbol_index_t {
+  bool by_address; // keys are compared as pointers, not as C strings
+  symbol_slot_t *slots;
+  size_t slot_count; // power of two, 0 before the first insertion
+  size_t used;
+  size_t *older; // entry index -> index + 1 of the previous entry with its key
+  size_t older_capacity;
+} symbol_index_t;
+
+// Indexes an entry, newer than every entry indexed so far.
+void symbol_index_add(symbol_index_t *ix, const void *key, size_t entry);
+
+size_t symbol_index_newest(symbol_index_t *ix, const void *key);
+
+size_t symbol_index_oldest(symbol_index_t *ix, const void *key);
+
+// Previous entry with the same key as entry.
+size_t symbol_index_older(symbol_index_t *ix, size_t entry);
+
+// Forgets every entry, keeping the memory.
+void symbol_index_clear(symbol_index_t *ix);
+
+void symbol_index_free(symbol_index_t *ix);
+
+#endif // SYMBOL_INDEX_H
@@ -22,6 +22,10 @@ typedef enum token_kind_t {
   KEY_DEFER,
   KEY_SUM,
   KEY_CLASS,
+  KEY_TRUE,
+  KEY_FALSE,
+  KEY_PUBLIC,
+  KEY_PRIVATE,
   MULT,
   PLUS,
   DIV,
@@ -60,6 +64,7 @@ typedef enum token_kind_t {
 } token_kind_t;
 
 lexer_t new_unilang_lexer();
+int unilang_keyword_kind(string_view_t lexeme, int kind);
 const char *human_token_kind(int kind);
 void dump_token(token_t token);
 void fdump_token(FILE *f, token_t token);
@@ -9,8 +9,56 @@
 #include "unilang_lexer.h"
 #include <stdint.h>
 
+// Packrat memoization of every parse_* call, see memo_parse()
+#define PPARSER_MEMO
+// Per-rule counters, collected once pparser_stats_enabled is set. Needs
+// PPARSER_MEMO.
+#ifdef PPARSER_MEMO
+#define PPARSER_STATS
+#endif
+
 token_t *parse_token_lexeme(lexer_t *l, int *worked, string_view_t lexeme);
 token_t *parse_token_kind(lexer_t *l, int *worked, int kind);
+#ifdef PPARSER_MEMO
+void pparser_memo_clear(void);
+#endif
+
+#ifdef PPARSER_STATS
+// Calls of a parse_* rule, those answered by the memo table, how they ended,
+// the tokens failing calls looked at before giving up, and the time spent in
+// the rule including (total) or excluding (self) the rules it called.
+typedef struct pparser_rule_stats_t {
+  size_t calls;
+  size_t memo_hits;
+  size_t successes;
+  size_t failures;
+  size_t failed_tokens;
+  uint64_t total_ns;
+  uint64_t self_ns;
+} pparser_rule_stats_t;
+
+extern bool pparser_stats_enabled;
+// Indexed by rule, per thread
+extern _Thread_local pparser_rule_stats_t pparser_rule_stats[];
+
+size_t pparser_rule_count(void);
+const char *pparser_rule_name(size_t rule);
+#endif
+
+// Lists built by the @list rules, their elements in total, and the times the
+// shared element stack grew to reach its peak size.
+typedef struct pparser_list_stats_t {
+  size_t lists;
+  size_t elems;
+  size_t grows;
+  size_t peak;
+} pparser_list_stats_t;
+
+extern _Thread_local pparser_list_stats_t pparser_list_stats;
+
+// Frees the memo table, the list stack and the expression stack of the
+// calling thread, for threads that are done parsing.
+void pparser_free_thread_buffers(void);
 // RULE identifier
 void *parse_identifier(lexer_t *l, int *worked);
 
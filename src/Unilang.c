@@ -5,7 +5,11 @@
  * Paul Passeron <paul.passeron2@gmail.com>
  */
 
+#include "../include/ast_cache.h"
 #include "../include/generator.h"
+#include "../include/incremental.h"
+#include "../include/parallel_parser.h"
+#include "../include/parser.h"
 #include "../include/string_view.h"
 #include "../include/unilang_lexer.h"
 #include "../include/unilang_parser.h"
@@ -17,6 +21,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
 
 void usage(const char *str) {
   printf("Usage: %s [options] <input file>\n", str);
@@ -33,6 +38,80 @@ void dump_tokens(lexer_t l) {
   }
 }
 
+void dump_lex_stats(void) {
+  // A parse that stops early, or reuses declarations, reads fewer tokens
+  // than were scanned.
+  size_t avoided = lexer_stats.read > lexer_stats.scanned
+                       ? lexer_stats.read - lexer_stats.scanned
+                       : 0;
+  fprintf(stderr, "[LEXER] %zu tokens scanned for %zu tokens read (%zu re-lexes "
+          "avoided)\n",
+          lexer_stats.scanned, lexer_stats.read, avoided);
+}
+
+void dump_list_stats(void) {
+  fprintf(stderr,
+          "[PARSER] %zu lists of %zu elements, element stack grown %zu "
+          "times to %zu\n",
+          pparser_list_stats.lists, pparser_list_stats.elems,
+          pparser_list_stats.grows, pparser_list_stats.peak);
+}
+
+void dump_incremental_stats(void) {
+  fprintf(stderr, "[INCREMENTAL] %zu declarations reused, %zu parsed\n",
+          incremental_stats.reused, incremental_stats.parsed);
+}
+
+#ifdef PPARSER_STATS
+int by_self_time(const void *a, const void *b) {
+  uint64_t x = pparser_rule_stats[*(const size_t *)a].self_ns;
+  uint64_t y = pparser_rule_stats[*(const size_t *)b].self_ns;
+  return (x < y) - (x > y);
+}
+
+// Rules that were called, the most expensive first.
+void dump_rule_stats(bool json) {
+  size_t count = pparser_rule_count();
+  size_t *rules = malloc(count * sizeof(size_t));
+  size_t called = 0;
+  for (size_t i = 0; i < count; i++) {
+    if (pparser_rule_stats[i].calls > 0)
+      rules[called++] = i;
+  }
+  qsort(rules, called, sizeof(size_t), by_self_time);
+  if (json) {
+    fprintf(stderr, "[\n");
+  } else {
+    fprintf(stderr, "[PARSER] %-22s %10s %10s %10s %10s %10s %10s %10s\n",
+            "rule", "calls", "memo hits", "successes", "failures",
+            "tok/fail", "total ms", "self ms");
+  }
+  for (size_t i = 0; i < called; i++) {
+    pparser_rule_stats_t s = pparser_rule_stats[rules[i]];
+    const char *name = pparser_rule_name(rules[i]);
+    double tokens_per_failure =
+        s.failures == 0 ? 0 : (double)s.failed_tokens / s.failures;
+    if (json) {
+      fprintf(stderr,
+              "  {\"rule\": \"%s\", \"calls\": %zu, \"memo_hits\": %zu, "
+              "\"successes\": %zu, \"failures\": %zu, \"failed_tokens\": "
+              "%zu, \"total_ns\": %llu, \"self_ns\": %llu}%s\n",
+              name, s.calls, s.memo_hits, s.successes, s.failures,
+              s.failed_tokens, (unsigned long long)s.total_ns,
+              (unsigned long long)s.self_ns, i + 1 < called ? "," : "");
+    } else {
+      fprintf(stderr,
+              "[PARSER] %-22s %10zu %10zu %10zu %10zu %10.2f %10.2f %10.2f\n",
+              name, s.calls, s.memo_hits, s.successes, s.failures,
+              tokens_per_failure, s.total_ns / 1e6, s.self_ns / 1e6);
+    }
+  }
+  if (json)
+    fprintf(stderr, "]\n");
+  free(rules);
+}
+#endif
+
 void print_cmd(int argc, char **argv) {
   printf("[CMD] ");
   for (int i = 0; i < argc; i++) {
@@ -49,6 +128,16 @@ int main(int argc, char **argv) {
   }
   char *fn = NULL;
   char *out = NULL;
+  bool lex_stats = false;
+  bool list_stats = false;
+  bool incremental = false;
+  bool incr_stats = false;
+#ifdef PPARSER_STATS
+  bool rule_stats = false;
+  bool rule_stats_json = false;
+#endif
+  // Threads parsing the top-level declarations
+  int jobs = sysconf(_SC_NPROCESSORS_ONLN);
   for (int i = 1; i < argc; i++) {
     if (argv[i][0] == '-') {
       if (strcmp(argv[i], "-o") == 0) {
@@ -60,6 +149,34 @@ int main(int argc, char **argv) {
         }
         printf("TODO: output to \'%s\'\n", argv[i]);
         out = argv[i];
+      } else if (strcmp(argv[i], "--lex-stats") == 0) {
+        lex_stats = true;
+      } else if (strcmp(argv[i], "--list-stats") == 0) {
+        list_stats = true;
+      } else if (strcmp(argv[i], "--parser-stats") == 0 ||
+                 strcmp(argv[i], "--parser-stats=json") == 0) {
+#ifdef PPARSER_STATS
+        rule_stats = true;
+        rule_stats_json = strcmp(argv[i], "--parser-stats=json") == 0;
+        pparser_stats_enabled = true;
+#else
+        printf("Parser statistics were not built in (PPARSER_STATS).\n");
+        return 3;
+#endif
+      } else if (strcmp(argv[i], "--incremental") == 0) {
+        incremental = true;
+      } else if (strcmp(argv[i], "--incremental-stats") == 0) {
+        incr_stats = true;
+      } else if (strcmp(argv[i], "--no-ast-cache") == 0) {
+        ast_cache_enabled = false;
+      } else if (strcmp(argv[i], "-j") == 0) {
+        i++;
+        if (i == argc) {
+          printf("Expected number of threads after \'-j\' flag.\n");
+          usage(argv[0]);
+          return 3;
+        }
+        jobs = atoi(argv[i]);
       }
     } else if (fn == NULL) {
       fn = argv[i];
@@ -79,8 +196,8 @@ int main(int argc, char **argv) {
   if (out == NULL) {
     out = "a.out";
   }
-  FILE *f = fopen(fn, "r");
-  if (!f) {
+  source_t *src = load_source(fn);
+  if (src == NULL) {
     printf("Error opening file \'%s\': ", fn);
     fflush(stdout);
     perror("");
@@ -88,16 +205,30 @@ int main(int argc, char **argv) {
     usage(argv[0]);
     return 5;
   }
-  string_view_t s = from_file(f);
-  fclose(f);
+  // Included modules are parsed into the same arena: the generator keeps
+  // pointers into their trees until the module is emitted.
+  arena_t ast_arena = {0};
+  set_ast_arena(&ast_arena);
   lexer_t l = new_unilang_lexer();
-  l.remaining = s;
-  l.current_loc = (location_t){fn, 1, 1, false};
+  set_lexer_source(&l, src);
+  tokenize(&l);
 
   int worked = 0;
-  ast_t *prog = parse_program(&l, &worked);
+  ast_t *prog = incremental ? parse_program_incremental(&l, &worked)
+                            : parse_program_parallel(&l, &worked, jobs);
   if (!worked) {
     printf("Parsing failed\n");
+    report_parse_failure(stderr);
+    if (lex_stats)
+      dump_lex_stats();
+    if (list_stats)
+      dump_list_stats();
+    if (incr_stats)
+      dump_incremental_stats();
+#ifdef PPARSER_STATS
+    if (rule_stats)
+      dump_rule_stats(rule_stats_json);
+#endif
     exit(1);
   }
 
@@ -106,6 +237,16 @@ int main(int argc, char **argv) {
 
   generate_program(prog);
   fflush(stdout);
+  if (lex_stats)
+    dump_lex_stats();
+  if (list_stats)
+    dump_list_stats();
+  if (incr_stats)
+    dump_incremental_stats();
+#ifdef PPARSER_STATS
+  if (rule_stats)
+    dump_rule_stats(rule_stats_json);
+#endif
 
   // LLVMDumpModule(g.module);
 
@@ -142,6 +283,8 @@ int main(int argc, char **argv) {
     return 1;
   }
   LLVMDisposeModule(g.module);
+  arena_release(&ast_arena);
+  free_sources();
 
   printf("\n");
   return 0;
@@ -0,0 +1,76 @@
+/**
+ * arena.c
+ * Copyright (C) 2024 Paul Passeron
+ * ARENA source file
+ * Paul Passeron <paul.passeron2@gmail.com>
+ */
+
+#include "../include/arena.h"
+#include <stdalign.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define ARENA_BLOCK_SIZE (64 * 1024)
+#define ARENA_ALIGN alignof(max_align_t)
+
+struct arena_block_t {
+  arena_block_t *next;
+  size_t used;
+  size_t size;
+  alignas(ARENA_ALIGN) char data[];
+};
+
+void *arena_alloc(arena_t *a, size_t size) {
+  size = (size + ARENA_ALIGN - 1) & ~(ARENA_ALIGN - 1);
+  arena_block_t *b = a->blocks;
+  if (b == NULL || b->size - b->used < size) {
+    size_t block_size = size > ARENA_BLOCK_SIZE ? size : ARENA_BLOCK_SIZE;
+    b = malloc(sizeof(arena_block_t) + block_size);
+    if (b == NULL) {
+      perror("Arena allocation failed");
+      exit(1);
+    }
+    b->used = 0;
+    b->size = block_size;
+    // An oversized block goes after the current one, which may still have
+    // room for small allocations.
+    if (a->blocks != NULL && block_size > ARENA_BLOCK_SIZE) {
+      b->next = a->blocks->next;
+      a->blocks->next = b;
+    } else {
+      b->next = a->blocks;
+      a->blocks = b;
+    }
+  }
+  void *res = b->data + b->used;
+  b->used += size;
+  return res;
+}
+
+void arena_adopt(arena_t *a, arena_t *from) {
+  if (from->blocks == NULL)
+    return;
+  if (a->blocks == NULL) {
+    a->blocks = from->blocks;
+    from->blocks = NULL;
+    return;
+  }
+  // Behind the current block of a, that keeps serving new allocations.
+  arena_block_t *last = from->blocks;
+  while (last->next != NULL) {
+    last = last->next;
+  }
+  last->next = a->blocks->next;
+  a->blocks->next = from->blocks;
+  from->blocks = NULL;
+}
+
+void arena_release(arena_t *a) {
+  arena_block_t *b = a->blocks;
+  while (b != NULL) {
+    arena_block_t *next = b->next;
+    free(b);
+    b = next;
+  }
+  a->blocks = NULL;
+}
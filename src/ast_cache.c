@@ -0,0 +1,197 @@
+/**
+ * ast_cache.c
+ * Copyright (C) 2024 Paul Passeron
+ * AST_CACHE source file
+ * Paul Passeron <paul.passeron2@gmail.com>
+ */
+
+#include "../include/ast_cache.h"
+#include "../include/flat_ast.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+bool ast_cache_enabled = true;
+
+#define AST_CACHE_MAGIC "ULASTC"
+
+// An entry is this header, the nodes and the lists of the flat AST.
+typedef struct ast_cache_header_t {
+  char magic[8];
+  uint32_t version;
+  uint32_t node_size;
+  uint64_t hash;
+  uint64_t source_length;
+  uint32_t node_count;
+  uint32_t list_count;
+  flat_id_t root;
+  uint16_t file; // source id in the tokens of the nodes
+  uint16_t padding;
+  uint64_t checksum; // ast_cache_hash() of the nodes and the lists
+} ast_cache_header_t;
+
+uint64_t ast_cache_hash_more(uint64_t h, const void *bytes, size_t size) {
+  const unsigned char *p = bytes;
+  for (size_t i = 0; i < size; i++) {
+    h = (h ^ p[i]) * 1099511628211ULL;
+  }
+  return h;
+}
+
+uint64_t ast_cache_hash(string_view_t bytes) {
+  return ast_cache_hash_more(14695981039346656037ULL ^ AST_CACHE_VERSION,
+                             bytes.contents, bytes.length);
+}
+
+bool ast_cache_dir(char *dir, size_t size) {
+  const char *xdg = getenv("XDG_CACHE_HOME");
+  const char *home = getenv("HOME");
+  int n;
+  if (xdg != NULL && xdg[0] != '\0')
+    n = snprintf(dir, size, "%s/unilang", xdg);
+  else if (home != NULL)
+    n = snprintf(dir, size, "%s/.cache/unilang", home);
+  else
+    return false;
+  return n > 0 && (size_t)n < size;
+}
+
+bool create_ast_cache_dir(char *dir, size_t size) {
+  if (!ast_cache_dir(dir, size))
+    return false;
+  // The parent directory too, for ~/.cache.
+  char *slash = strrchr(dir, '/');
+  if (slash != NULL) {
+    *slash = '\0';
+    mkdir(dir, 0755);
+    *slash = '/';
+  }
+  return mkdir(dir, 0755) == 0 || errno == EEXIST;
+}
+
+bool ast_cache_path(char *path, size_t size, uint64_t hash) {
+  char dir[PATH_MAX];
+  if (!ast_cache_dir(dir, sizeof(dir)))
+    return false;
+  int n = snprintf(path, size, "%s/%016llx.ast", dir, (unsigned long long)hash);
+  return n > 0 && (size_t)n < size;
+}
+
+bool valid_entry(ast_cache_header_t *h, size_t size, source_t *src,
+                 uint64_t hash) {
+  if (size < sizeof(ast_cache_header_t))
+    return false;
+  if (memcmp(h->magic, AST_CACHE_MAGIC, sizeof(AST_CACHE_MAGIC)) != 0 ||
+      h->version != AST_CACHE_VERSION ||
+      h->node_size != sizeof(flat_node_t) || h->hash != hash ||
+      h->source_length != src->contents.length)
+    return false;
+  size_t payload = size - sizeof(ast_cache_header_t);
+  return payload == (size_t)h->node_count * sizeof(flat_node_t) +
+                        (size_t)h->list_count * sizeof(flat_id_t) &&
+         h->root < h->node_count &&
+         ast_cache_hash((string_view_t){(char *)(h + 1), payload}) ==
+             h->checksum;
+}
+
+ast_t *load_cached_ast(source_t *src) {
+  if (!ast_cache_enabled)
+    return NULL;
+  uint64_t hash = ast_cache_hash(src->contents);
+  char path[PATH_MAX];
+  if (!ast_cache_path(path, sizeof(path), hash))
+    return NULL;
+  int fd = open(path, O_RDONLY);
+  if (fd < 0)
+    return NULL;
+  struct stat st;
+  if (fstat(fd, &st) < 0 || st.st_size == 0) {
+    close(fd);
+    return NULL;
+  }
+  // Private and writable: the source ids of the tokens may need patching,
+  // which copies only the pages touched.
+  void *p = mmap(NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (p == MAP_FAILED)
+    return NULL;
+  ast_cache_header_t *h = p;
+  if (!valid_entry(h, st.st_size, src, hash)) {
+    munmap(p, st.st_size);
+    return NULL;
+  }
+  flat_node_t *nodes = (flat_node_t *)(h + 1);
+  flat_id_t *lists = (flat_id_t *)(nodes + h->node_count);
+  flat_ast_t f = {{nodes, h->node_count, h->node_count},
+                  {lists, h->list_count, h->list_count},
+                  false};
+  // A corrupted entry is parsed again, like a missing one.
+  if (!valid_flat_ast(&f, h->root, src->contents.length)) {
+    munmap(p, st.st_size);
+    return NULL;
+  }
+  if (h->file != src->id) {
+    for (size_t i = 0; i < h->node_count; i++) {
+      if (nodes[i].tok.file != 0)
+        nodes[i].tok.file = src->id;
+    }
+  }
+  ast_t *prog = unflatten_ast(&f, h->root);
+  munmap(p, st.st_size);
+  return prog;
+}
+
+void store_cached_ast(source_t *src, ast_t *prog) {
+  if (!ast_cache_enabled)
+    return;
+  uint64_t hash = ast_cache_hash(src->contents);
+  char path[PATH_MAX];
+  char dir[PATH_MAX];
+  if (!ast_cache_path(path, sizeof(path), hash) ||
+      !create_ast_cache_dir(dir, sizeof(dir)))
+    return;
+
+  flat_ast_t f = {0};
+  flat_id_t root = flatten_ast(&f, prog);
+  if (root == FLAT_NONE) {
+    free_flat_ast(&f);
+    return;
+  }
+  uint64_t checksum = ast_cache_hash((string_view_t){
+      (char *)f.nodes.items, f.nodes.count * sizeof(flat_node_t)});
+  checksum = ast_cache_hash_more(checksum, f.lists.items,
+                                 f.lists.count * sizeof(flat_id_t));
+  ast_cache_header_t h = {AST_CACHE_MAGIC,
+                          AST_CACHE_VERSION,
+                          sizeof(flat_node_t),
+                          hash,
+                          src->contents.length,
+                          f.nodes.count,
+                          f.lists.count,
+                          root,
+                          src->id,
+                          0,
+                          checksum};
+
+  // Written aside and renamed, so that a concurrent compiler never maps a
+  // partial entry.
+  char tmp[PATH_MAX + 32];
+  snprintf(tmp, sizeof(tmp), "%s.%d", path, (int)getpid());
+  FILE *file = fopen(tmp, "wb");
+  if (file != NULL) {
+    bool ok = fwrite(&h, sizeof(h), 1, file) == 1 &&
+              fwrite(f.nodes.items, sizeof(flat_node_t), f.nodes.count,
+                     file) == f.nodes.count &&
+              fwrite(f.lists.items, sizeof(flat_id_t), f.lists.count,
+                     file) == f.lists.count;
+    if (fclose(file) != 0 || !ok || rename(tmp, path) != 0)
+      remove(tmp);
+  }
+  free_flat_ast(&f);
+}
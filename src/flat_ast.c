@@ -0,0 +1,551 @@
+/**
+ * flat_ast.c
+ * Copyright (C) 2024 Paul Passeron
+ * FLAT_AST source file
+ * Paul Passeron <paul.passeron2@gmail.com>
+ */
+
+#include "../include/flat_ast.h"
+#include "../include/dynarr.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+flat_node_t *flat_node(flat_ast_t *f, flat_id_t id) {
+  return &f->nodes.items[id];
+}
+
+flat_id_t flat_list_at(flat_ast_t *f, flat_node_t *n, size_t i) {
+  return f->lists.items[n->first + i];
+}
+
+flat_id_t new_flat_node(flat_ast_t *f, ast_kind_t kind, token_t tok) {
+  if (f->nodes.count == 0)
+    da_append(&f->nodes, (flat_node_t){0});
+  if (f->nodes.count > UINT32_MAX) {
+    f->failed = true;
+    return FLAT_NONE;
+  }
+  flat_node_t n = {0};
+  n.tok = tok;
+  n.kind = kind;
+  da_append(&f->nodes, n);
+  return f->nodes.count - 1;
+}
+
+// What is left to flatten, the next step on top. The id a step creates goes to
+// kids[kid] of node, or to the lists at slot when kid is FLAT_IN_LIST.
+typedef enum flat_step_kind_t {
+  FLAT_STEP_TREE,   // ast and its children
+  FLAT_STEP_LIST,   // reserves the list of node, then its index elems
+  FLAT_STEP_PARAMS, // reserves the list of node, then the params of ast
+  FLAT_STEP_PARAM,  // param index of the fundef ast, then its type
+} flat_step_kind_t;
+
+#define FLAT_IN_LIST -1
+
+typedef struct flat_step_t {
+  flat_step_kind_t kind;
+  ast_t *ast;
+  ast_t **elems;
+  size_t index;
+  flat_id_t node; // FLAT_NONE for the root
+  int kid;
+  size_t slot;
+} flat_step_t;
+
+typedef struct flat_steps_t {
+  flat_step_t *items;
+  size_t count;
+  size_t capacity;
+} flat_steps_t;
+
+void push_flat_kid(flat_steps_t *steps, flat_id_t id, int kid, ast_t *ast) {
+  flat_step_t step = {FLAT_STEP_TREE, ast, NULL, 0, id, kid, 0};
+  da_append(steps, step);
+}
+
+// Pushed last to first, to be flattened first to last.
+void push_flat_kids(flat_steps_t *steps, flat_id_t id, int count,
+                    ast_t **kids) {
+  for (int i = count; i-- > 0;) {
+    push_flat_kid(steps, id, i, kids[i]);
+  }
+}
+
+void push_flat_list(flat_steps_t *steps, flat_id_t id, ast_t **elems,
+                    size_t count) {
+  flat_step_t step = {FLAT_STEP_LIST, NULL, elems, count, id, 0, 0};
+  da_append(steps, step);
+}
+
+// Makes room for the list of a node, so that it stays contiguous while its
+// elements add lists of their own.
+uint32_t reserve_flat_list(flat_ast_t *f, flat_id_t id, size_t count) {
+  size_t first = f->lists.count;
+  for (size_t i = 0; i < count; i++) {
+    da_append(&f->lists, FLAT_NONE);
+  }
+  flat_node(f, id)->first = first;
+  flat_node(f, id)->count = count;
+  return first;
+}
+
+// The node array can move while a tree is flattened: nodes are only written
+// through their id.
+void set_flat_dest(flat_ast_t *f, flat_step_t step, flat_id_t id) {
+  if (step.node == FLAT_NONE)
+    return;
+  if (step.kid == FLAT_IN_LIST)
+    f->lists.items[step.slot] = id;
+  else
+    flat_node(f, step.node)->kids[step.kid] = id;
+}
+
+// Creates the node of a tree step, and pushes the steps of its children in
+// the order the layout needs. FLAT_NONE if it cannot.
+flat_id_t flatten_step(flat_ast_t *f, flat_steps_t *steps, ast_t *ast) {
+  flat_id_t id = new_flat_node(f, ast->kind, error_token());
+  if (id == FLAT_NONE)
+    return FLAT_NONE;
+  flat_node_t *n = flat_node(f, id);
+  switch (ast->kind) {
+  case AST_IDENTIFIER:
+  case AST_INTLIT:
+  case AST_FLOATLIT:
+  case AST_CHARLIT:
+  case AST_STRINGLIT:
+    n->tok = ast->as.identifier.tok;
+    break;
+  case AST_BOOLLIT:
+    n->flags = ast->as.boollit.val ? FLAT_TRUE : 0;
+    break;
+  case AST_FUNDEF: {
+    // Return type, params, body.
+    n->tok = ast->as.fundef.name;
+    push_flat_kid(steps, id, 1, ast->as.fundef.body);
+    flat_step_t params = {FLAT_STEP_PARAMS, ast, NULL, 0, id, 0, 0};
+    da_append(steps, params);
+    push_flat_kid(steps, id, 0, ast->as.fundef.return_type);
+  } break;
+  case AST_COMPOUND:
+    push_flat_list(steps, id, ast->as.compound.elems,
+                   ast->as.compound.elem_count);
+    break;
+  case AST_FUNCALL:
+    push_flat_list(steps, id, ast->as.funcall.args, ast->as.funcall.arg_count);
+    push_flat_kids(steps, id, 2,
+                   (ast_t *[]){ast->as.funcall.called, ast->as.funcall.templ});
+    break;
+  case AST_UNOP:
+    n->tok = ast->as.unop.op;
+    push_flat_kid(steps, id, 0, ast->as.unop.operand);
+    break;
+  case AST_BINOP:
+    n->tok = ast->as.binop.op;
+    push_flat_kids(steps, id, 2,
+                   (ast_t *[]){ast->as.binop.lhs, ast->as.binop.rhs});
+    break;
+  case AST_TYPE:
+    n->tok = ast->as.type.name;
+    n->ptr_n = ast->as.type.ptr_n;
+    n->flags = ast->as.type.is_template ? FLAT_TEMPLATE : 0;
+    push_flat_kid(steps, id, 0, ast->as.type.inst_template);
+    break;
+  case AST_VARDEF:
+    n->tok = ast->as.vardef.name;
+    push_flat_kids(steps, id, 2,
+                   (ast_t *[]){ast->as.vardef.type, ast->as.vardef.value});
+    break;
+  case AST_CT_CTE:
+    n->tok = ast->as.ct_cte.name;
+    push_flat_kid(steps, id, 0, ast->as.ct_cte.value);
+    break;
+  case AST_METHOD:
+    n->tok = ast->as.method.specifier;
+    n->flags = (ast->as.method.is_abstract ? FLAT_ABSTRACT : 0) |
+               (ast->as.method.is_static ? FLAT_STATIC : 0);
+    push_flat_kid(steps, id, 0, ast->as.method.fdef);
+    break;
+  case AST_MEMBER:
+    n->tok = ast->as.member.specifier;
+    n->flags = ast->as.member.is_static ? FLAT_STATIC : 0;
+    push_flat_kid(steps, id, 0, ast->as.member.var);
+    break;
+  case AST_CLASS:
+    n->tok = ast->as.clazz.name;
+    push_flat_list(steps, id, ast->as.clazz.fields, ast->as.clazz.field_count);
+    push_flat_kid(steps, id, 0, ast->as.clazz.temp);
+    break;
+  case AST_IFSTMT:
+    push_flat_kids(steps, id, 3,
+                   (ast_t *[]){ast->as.if_stmt.cond, ast->as.if_stmt.body,
+                               ast->as.if_stmt.other_body});
+    break;
+  case AST_INDEX:
+    push_flat_kids(steps, id, 2,
+                   (ast_t *[]){ast->as.index.subscripted,
+                               ast->as.index.index});
+    break;
+  case AST_WHILE:
+    push_flat_kids(steps, id, 2,
+                   (ast_t *[]){ast->as.while_stmt.cond,
+                               ast->as.while_stmt.body});
+    break;
+  case AST_ASSIGN:
+    push_flat_kids(steps, id, 2,
+                   (ast_t *[]){ast->as.assign.lhs, ast->as.assign.rhs});
+    break;
+  case AST_RETURN:
+    push_flat_kid(steps, id, 0, ast->as.return_stmt.expr);
+    break;
+  case AST_AS_DIR:
+  case AST_NEW_DIR:
+    push_flat_kids(steps, id, 2,
+                   (ast_t *[]){ast->as.as_dir.type, ast->as.as_dir.expr});
+    break;
+  case AST_INCLUDE_DIR:
+    push_flat_kid(steps, id, 0, ast->as.include_dir.expr);
+    break;
+  case AST_SIZE_DIR:
+    push_flat_kid(steps, id, 0, ast->as.size_dir.type);
+    break;
+  case AST_TEMPELEM:
+    push_flat_kids(steps, id, 2,
+                   (ast_t *[]){ast->as.tempelem.type_iden,
+                               ast->as.tempelem.interface});
+    break;
+  case AST_INTERFACE: {
+    n->tok = ast->as.interface.name;
+    flat_id_t type =
+        new_flat_node(f, AST_IDENTIFIER, ast->as.interface.type);
+    flat_node(f, id)->kids[0] = type;
+    push_flat_list(steps, id, ast->as.interface.protos,
+                   ast->as.interface.protos_count);
+  } break;
+  case AST_TEMPLATE:
+    push_flat_list(steps, id, ast->as.temp.tempelems, ast->as.temp.count);
+    break;
+  default:
+    f->failed = true;
+    return FLAT_NONE;
+  }
+  return id;
+}
+
+// Iterative, with the steps on the heap: a chain of binary operators is as
+// deep as it is long.
+flat_id_t flatten_ast(flat_ast_t *f, ast_t *ast) {
+  f->failed = false;
+  flat_steps_t steps = {0};
+  flat_id_t root = FLAT_NONE;
+  if (ast != NULL) {
+    root = f->nodes.count == 0 ? 1 : f->nodes.count;
+    push_flat_kid(&steps, FLAT_NONE, 0, ast);
+  }
+  while (steps.count > 0 && !f->failed) {
+    flat_step_t step = steps.items[--steps.count];
+    switch (step.kind) {
+    case FLAT_STEP_TREE:
+      if (step.ast != NULL)
+        set_flat_dest(f, step, flatten_step(f, &steps, step.ast));
+      break;
+    case FLAT_STEP_LIST: {
+      uint32_t first = reserve_flat_list(f, step.node, step.index);
+      for (size_t i = step.index; i-- > 0;) {
+        flat_step_t elem = {FLAT_STEP_TREE, step.elems[i], NULL, 0,
+                            step.node, FLAT_IN_LIST, first + i};
+        da_append(&steps, elem);
+      }
+    } break;
+    case FLAT_STEP_PARAMS: {
+      size_t count = step.ast->as.fundef.param_count;
+      uint32_t first = reserve_flat_list(f, step.node, count);
+      for (size_t i = count; i-- > 0;) {
+        flat_step_t param = {FLAT_STEP_PARAM, step.ast, NULL, i,
+                             step.node, FLAT_IN_LIST, first + i};
+        da_append(&steps, param);
+      }
+    } break;
+    case FLAT_STEP_PARAM: {
+      ast_fundef_t fundef = step.ast->as.fundef;
+      flat_id_t param =
+          new_flat_node(f, AST_VARDEF, fundef.param_names[step.index]);
+      if (param == FLAT_NONE)
+        break;
+      set_flat_dest(f, step, param);
+      push_flat_kid(&steps, param, 0, fundef.param_types[step.index]);
+    } break;
+    }
+  }
+  da_free(steps);
+  return f->failed ? FLAT_NONE : root;
+}
+// Kids of the nodes of a kind, -1 for an unknown kind. The type of an
+// interface is a kid: its AST_IDENTIFIER node.
+int flat_kid_count(uint8_t kind) {
+  switch (kind) {
+  case AST_IDENTIFIER:
+  case AST_INTLIT:
+  case AST_FLOATLIT:
+  case AST_CHARLIT:
+  case AST_STRINGLIT:
+  case AST_BOOLLIT:
+  case AST_COMPOUND:
+  case AST_TEMPLATE:
+    return 0;
+  case AST_UNOP:
+  case AST_TYPE:
+  case AST_CT_CTE:
+  case AST_METHOD:
+  case AST_MEMBER:
+  case AST_CLASS:
+  case AST_RETURN:
+  case AST_INCLUDE_DIR:
+  case AST_SIZE_DIR:
+  case AST_INTERFACE:
+    return 1;
+  case AST_FUNDEF:
+  case AST_FUNCALL:
+  case AST_BINOP:
+  case AST_VARDEF:
+  case AST_INDEX:
+  case AST_WHILE:
+  case AST_ASSIGN:
+  case AST_AS_DIR:
+  case AST_NEW_DIR:
+  case AST_TEMPELEM:
+    return 2;
+  case AST_IFSTMT:
+    return 3;
+  default:
+    return -1;
+  }
+}
+
+bool has_flat_list(uint8_t kind) {
+  return kind == AST_FUNDEF || kind == AST_COMPOUND || kind == AST_FUNCALL ||
+         kind == AST_CLASS || kind == AST_INTERFACE || kind == AST_TEMPLATE;
+}
+
+typedef struct flat_ids_t {
+  flat_id_t *items;
+  size_t count;
+  size_t capacity;
+} flat_ids_t;
+
+bool valid_flat_node(flat_ast_t *f, flat_node_t *n, size_t source_length) {
+  int kids = flat_kid_count(n->kind);
+  if (kids < 0)
+    return false;
+  for (int i = 0; i < 3; i++) {
+    if (n->kids[i] >= f->nodes.count || (i >= kids && n->kids[i] != FLAT_NONE))
+      return false;
+  }
+  if ((!has_flat_list(n->kind) && n->count != 0) ||
+      (size_t)n->first + n->count > f->lists.count)
+    return false;
+  for (size_t i = 0; i < n->count; i++) {
+    flat_id_t elem = flat_list_at(f, n, i);
+    if (elem == FLAT_NONE || elem >= f->nodes.count)
+      return false;
+    flat_node_t *param = flat_node(f, elem);
+    if (n->kind == AST_FUNDEF &&
+        (param->kind != AST_VARDEF || param->kids[1] != FLAT_NONE))
+      return false;
+  }
+  if (n->kind == AST_INTERFACE &&
+      (n->kids[0] == FLAT_NONE ||
+       flat_node(f, n->kids[0])->kind != AST_IDENTIFIER))
+    return false;
+  return n->tok.file == 0 ||
+         (uint64_t)n->tok.offset + n->tok.length <= source_length;
+}
+
+// Walks the nodes in the order flatten_ast() lays them out, each one being
+// the next one in the array.
+bool valid_flat_ast(flat_ast_t *f, flat_id_t root, size_t source_length) {
+  if (root == FLAT_NONE || root >= f->nodes.count)
+    return false;
+  flat_ids_t ids = {0};
+  flat_id_t next = root;
+  bool ok = true;
+  da_append(&ids, root);
+  while (ok && ids.count > 0) {
+    flat_id_t id = ids.items[--ids.count];
+    flat_node_t *n = flat_node(f, id);
+    ok = id == next++ && valid_flat_node(f, n, source_length);
+    if (!ok)
+      break;
+    // Pushed last to first: kids then list, or return type, params and body
+    // for a fundef.
+    int kids = flat_kid_count(n->kind);
+    if (n->kind == AST_FUNDEF && n->kids[1] != FLAT_NONE)
+      da_append(&ids, n->kids[1]);
+    for (size_t i = n->count; i-- > 0;) {
+      da_append(&ids, flat_list_at(f, n, i));
+    }
+    for (int i = kids; i-- > 0;) {
+      if (n->kids[i] != FLAT_NONE && !(n->kind == AST_FUNDEF && i == 1))
+        da_append(&ids, n->kids[i]);
+    }
+  }
+  da_free(ids);
+  return ok && next == f->nodes.count;
+}
+
+// A node to build once the trees of its children are on the results.
+typedef struct unflat_frame_t {
+  flat_id_t id;
+  bool ready;
+} unflat_frame_t;
+
+typedef struct unflat_frames_t {
+  unflat_frame_t *items;
+  size_t count;
+  size_t capacity;
+} unflat_frames_t;
+
+typedef struct unflat_results_t {
+  ast_t **items;
+  size_t count;
+  size_t capacity;
+} unflat_results_t;
+
+// NULL-terminated, as built by the parser.
+ast_t **copy_flat_list(ast_t **elems, size_t count) {
+  ast_t **res = ast_alloc((count + 1) * sizeof(ast_t *));
+  memcpy(res, elems, count * sizeof(ast_t *));
+  res[count] = NULL;
+  return res;
+}
+
+// kids are the trees of the kids of n, followed by those of its list.
+ast_t *build_flat_node(flat_ast_t *f, flat_node_t *n, ast_t **kids) {
+  switch (n->kind) {
+  case AST_IDENTIFIER:
+    return new_identifier(n->tok);
+  case AST_INTLIT:
+    return new_intlit(n->tok);
+  case AST_FLOATLIT:
+    return new_floatlit(n->tok);
+  case AST_CHARLIT:
+    return new_charlit(n->tok);
+  case AST_STRINGLIT:
+    return new_stringlit(n->tok);
+  case AST_BOOLLIT:
+    return new_boollit(n->flags & FLAT_TRUE);
+  case AST_FUNDEF: {
+    ast_t **param_types = ast_alloc(n->count * sizeof(ast_t *));
+    token_t *param_names = ast_alloc(n->count * sizeof(token_t));
+    for (size_t i = 0; i < n->count; i++) {
+      param_types[i] = kids[2 + i];
+      param_names[i] = flat_node(f, flat_list_at(f, n, i))->tok;
+    }
+    return new_fundef(n->tok, n->count, param_types, param_names, kids[1],
+                      kids[0]);
+  }
+  case AST_COMPOUND:
+    return new_compound(copy_flat_list(kids, n->count));
+  case AST_FUNCALL: {
+    ast_t *res =
+        new_funcall(kids[0], n->count, copy_flat_list(kids + 2, n->count));
+    res->as.funcall.templ = kids[1];
+    return res;
+  }
+  case AST_UNOP:
+    return new_unop(n->tok, kids[0]);
+  case AST_BINOP:
+    return new_binop(n->tok, kids[0], kids[1]);
+  case AST_TYPE:
+    return new_type(n->tok, n->ptr_n, n->flags & FLAT_TEMPLATE, kids[0]);
+  case AST_VARDEF:
+    return new_vardef(n->tok, kids[0], kids[1]);
+  case AST_CT_CTE:
+    return new_ct_cte(n->tok, kids[0]);
+  case AST_METHOD:
+    return new_method(kids[0], n->tok, (n->flags & FLAT_ABSTRACT) != 0,
+                      (n->flags & FLAT_STATIC) != 0);
+  case AST_MEMBER:
+    return new_member(kids[0], n->tok, (n->flags & FLAT_STATIC) != 0);
+  case AST_CLASS:
+    return new_class(n->tok, n->count, copy_flat_list(kids + 1, n->count),
+                     kids[0]);
+  case AST_IFSTMT:
+    return new_if_stmt(kids[0], kids[1], kids[2]);
+  case AST_INDEX:
+    return new_index(kids[0], kids[1]);
+  case AST_WHILE:
+    return new_while_stmt(kids[0], kids[1]);
+  case AST_ASSIGN:
+    return new_assignement(kids[0], kids[1]);
+  case AST_RETURN:
+    return new_return(kids[0]);
+  case AST_AS_DIR:
+    return new_as_dir(kids[0], kids[1]);
+  case AST_NEW_DIR:
+    return new_new_dir(kids[0], kids[1]);
+  case AST_INCLUDE_DIR:
+    return new_include_dir(kids[0]);
+  case AST_SIZE_DIR:
+    return new_size_dir(kids[0]);
+  case AST_TEMPELEM:
+    return new_tempelem(kids[0], kids[1]);
+  case AST_INTERFACE:
+    return new_interface(flat_node(f, n->kids[0])->tok, n->tok,
+                         copy_flat_list(kids, n->count), n->count);
+  case AST_TEMPLATE:
+    return new_template(copy_flat_list(kids, n->count));
+  default:
+    f->failed = true;
+    return NULL;
+  }
+}
+
+// Post-order, with the nodes waiting for their children on the heap.
+ast_t *unflatten_ast(flat_ast_t *f, flat_id_t id) {
+  f->failed = false;
+  unflat_frames_t frames = {0};
+  unflat_results_t results = {0};
+  da_append(&frames, ((unflat_frame_t){id, false}));
+  while (frames.count > 0 && !f->failed) {
+    unflat_frame_t frame = frames.items[--frames.count];
+    if (frame.id == FLAT_NONE) {
+      da_append(&results, NULL);
+      continue;
+    }
+    flat_node_t *n = flat_node(f, frame.id);
+    int kids = n->kind == AST_INTERFACE ? 0 : flat_kid_count(n->kind);
+    if (kids < 0) {
+      f->failed = true;
+      break;
+    }
+    if (frame.ready) {
+      size_t count = kids + n->count;
+      ast_t *res = build_flat_node(f, n, results.items + results.count - count);
+      results.count -= count;
+      da_append(&results, res);
+      continue;
+    }
+    da_append(&frames, ((unflat_frame_t){frame.id, true}));
+    for (size_t i = n->count; i-- > 0;) {
+      flat_id_t elem = flat_list_at(f, n, i);
+      if (n->kind == AST_FUNDEF)
+        elem = flat_node(f, elem)->kids[0];
+      da_append(&frames, ((unflat_frame_t){elem, false}));
+    }
+    for (int i = kids; i-- > 0;) {
+      da_append(&frames, ((unflat_frame_t){n->kids[i], false}));
+    }
+  }
+  ast_t *res = f->failed || results.count == 0 ? NULL : results.items[0];
+  da_free(frames);
+  da_free(results);
+  return res;
+}
+
+void free_flat_ast(flat_ast_t *f) {
+  da_free(f->nodes);
+  da_free(f->lists);
+  *f = (flat_ast_t){0};
+}
@@ -6,6 +6,7 @@
  */
 
 #include "../include/generator.h"
+#include "../include/ast_cache.h"
 #include "../include/regexp.h"
 #include "../include/unilang_lexer.h"
 #include "../include/unilang_parser.h"
@@ -17,6 +18,7 @@
 #include <llvm-c/Transforms/PassBuilder.h>
 #include <llvm-c/Types.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -49,23 +51,95 @@ void set_global_generator(generator_t *g) { gen = g; }
 
 generator_t *get_global_generator() { return gen; }
 
+// Whether the LLVM type of a type is known once and for all: templated
+// types depend on the aliases in scope.
+bool is_stable_type(type_t t) {
+  if (t.kind == PTR || t.kind == ALIAS)
+    return is_stable_type(*t.pointed_by);
+  return t.kind == BUILTIN || t.kind == CLASS || t.kind == INTERFACE;
+}
+
+size_t hash_type(type_t t) {
+  uintptr_t fields[] = {(uintptr_t)t.name,       (uintptr_t)t.kind,
+                        (uintptr_t)t.type,       (uintptr_t)t.pointed_by,
+                        (uintptr_t)t.interface, (uintptr_t)t.ast};
+  uint64_t h = 14695981039346656037ULL;
+  for (size_t i = 0; i < sizeof(fields) / sizeof(fields[0]); i++) {
+    h = (h ^ fields[i]) * 1099511628211ULL;
+  }
+  return h ^ (h >> 32);
+}
+
+// The interface is compared as a pointer: a node keeps the string of the
+// first type it was made of, which must stay the string of the types equal
+// to it.
+bool are_types_identical(type_t a, type_t b) {
+  return a.name == b.name && a.kind == b.kind && a.type == b.type &&
+         a.pointed_by == b.pointed_by && a.interface == b.interface &&
+         a.ast == b.ast;
+}
+
+type_node_t **type_slot(type_t t) {
+  size_t mask = gen->type_slot_count - 1;
+  size_t i = hash_type(t) & mask;
+  while (gen->type_slots[i] != NULL &&
+         !are_types_identical(gen->type_slots[i]->t, t))
+    i = (i + 1) & mask;
+  return &gen->type_slots[i];
+}
+
+void rehash_type_nodes(void) {
+  free(gen->type_slots);
+  gen->type_slot_count =
+      gen->type_slot_count == 0 ? 256 : gen->type_slot_count * 2;
+  gen->type_slots = calloc(gen->type_slot_count, sizeof(type_node_t *));
+  if (gen->type_slots == NULL) {
+    perror("Allocation failed");
+    exit(1);
+  }
+  for (size_t i = 0; i < gen->type_nodes.count; i++) {
+    *type_slot(gen->type_nodes.items[i]->t) = gen->type_nodes.items[i];
+  }
+}
+
+// Nodes are never freed nor modified, but for the pointer types they cache.
+type_node_t *intern_type(type_t t) {
+  if (2 * (gen->type_nodes.count + 1) > gen->type_slot_count)
+    rehash_type_nodes();
+  type_node_t **slot = type_slot(t);
+  if (*slot == NULL) {
+    *slot = malloc(sizeof(type_node_t));
+    if (*slot == NULL) {
+      perror("Allocation failed");
+      exit(1);
+    }
+    **slot = (type_node_t){t, NULL};
+    da_append(&gen->type_nodes, *slot);
+  }
+  return *slot;
+}
+
 type_t get_ptr_of(type_t t) {
-  type_t *ptr = malloc(sizeof(type_t));
-  *ptr = t;
+  type_node_t *node = intern_type(t);
   type_t res = {0};
   res.type = NULL;
   if (t.kind != TEMPLATED) {
-    res.type = LLVMPointerType(type_to_llvm(t), 0);
+    // The LLVM type of the pointee is only known once and for all if the
+    // pointee is stable.
+    if (node->ptr_type == NULL || !is_stable_type(t)) {
+      node->ptr_type = LLVMPointerType(type_to_llvm(t), 0);
+    }
+    res.type = node->ptr_type;
   }
-  res.name = NULL;
+  res.name = NO_SYMBOL;
   res.kind = PTR;
-  res.pointed_by = ptr;
+  res.pointed_by = &node->t;
   return res;
 }
 
 char *get_include_postfix(ast_t *expr) {
   if (expr->kind == AST_IDENTIFIER) {
-    return sv_to_cstr(expr->as.identifier.tok.lexeme);
+    return sv_to_cstr(token_lexeme(expr->as.identifier.tok));
   } else if (expr->kind != AST_BINOP || expr->as.binop.op.kind != ACCESS) {
     printf("Bad include expression: ");
     dump_ast(expr);
@@ -86,35 +160,72 @@ char *get_include_postfix(ast_t *expr) {
   return res;
 }
 
-type_t get_type_from_name(const char *name) {
+// Symbols are indexed by the address of their interned string, which is
+// unique to each of them.
+const void *name_key(symbol_t name) { return symbol_name(name); }
+
+// Incomplete types have no name, but the one of their class.
+symbol_t type_key(type_t t) {
+  return t.name != NO_SYMBOL ? t.name
+                             : ((class_entry_t *)(t.pointed_by))->name;
+}
+
+void index_type(size_t index) {
+  type_t t = gen->types.items[index];
+  symbol_t key = type_key(t);
+  if (key != NO_SYMBOL)
+    symbol_index_add(&gen->type_names, name_key(key), index);
+  if (is_stable_type(t))
+    symbol_index_add(&gen->type_llvms, type_to_llvm(t), index);
+  else
+    da_append(&gen->unstable_types, index);
+}
+
+void index_types(void) {
+  if (gen->types_indexed)
+    return;
+  symbol_index_clear(&gen->type_names);
+  symbol_index_clear(&gen->type_llvms);
+  gen->unstable_types.count = 0;
   for (size_t i = 0; i < gen->types.count; i++) {
-    int index = gen->types.count - i - 1;
-    type_t t = gen->types.items[index];
-    if (t.name == NULL) {
-      if (strcmp(((class_entry_t *)(t.pointed_by))->name, name)) {
-        continue;
-      }
+    index_type(i);
+  }
+  gen->types_indexed = true;
+}
+
+// Newest type first, so that template aliases shadow the types they name.
+type_t get_type_from_name(symbol_t name) {
+  index_types();
+  size_t i = symbol_index_newest(&gen->type_names, name_key(name));
+  if (i != SYMBOL_NONE) {
+    type_t t = gen->types.items[i];
+    if (t.name == NO_SYMBOL)
       printf("Found Incomplete type\n");
-      return t;
-    }
-    if (strcmp(t.name, name) == 0) {
-      return t;
-    }
+    return t;
   }
-  printf("Type %s does not exist in the current context\n", name);
+  printf("Type %s does not exist in the current context\n",
+         symbol_name(name));
   printf("Context: ");
   print_types();
   EXIT;
 }
 
+// Oldest type first. The LLVM type of an unstable type is only computed if
+// it comes before the indexed match.
 type_t get_type_from_llvm(LLVMTypeRef type) {
-  for (size_t i = 0; i < gen->types.count; i++) {
-    type_t t = gen->types.items[i];
-    t = sanitize_type(t);
+  index_types();
+  size_t found = symbol_index_oldest(&gen->type_llvms, type);
+  for (size_t i = 0; i < gen->unstable_types.count; i++) {
+    size_t index = gen->unstable_types.items[i];
+    if (index > found)
+      break;
+    type_t t = sanitize_type(gen->types.items[index]);
     if (type_to_llvm(t) == type) {
       return t;
     }
   }
+  if (found != SYMBOL_NONE)
+    return sanitize_type(gen->types.items[found]);
   printf("Could not find match for type ");
   fflush(stdout);
   LLVMDumpType(type);
@@ -123,8 +234,8 @@ type_t get_type_from_llvm(LLVMTypeRef type) {
 }
 
 void print_type(type_t type) {
-  if (type.name != NULL) {
-    printf("%s = ", type.name);
+  if (type.name != NO_SYMBOL) {
+    printf("%s = ", symbol_name(type.name));
   }
   if (type.kind == BUILTIN) {
     printf("<builtin type>");
@@ -146,71 +257,69 @@ void print_type(type_t type) {
 
 void add_type(type_t t) {
   if (t.kind == CLASS) {
-    printf("Class name being added as a type is %s\n", t.name);
+    printf("Class name being added as a type is %s\n", symbol_name(t.name));
   }
   da_append(&gen->types, t);
+  if (gen->types_indexed)
+    index_type(gen->types.count - 1);
+  gen->types_epoch++;
+}
+
+void remove_type(size_t index) {
+  da_remove(&gen->types, index);
+  gen->types_indexed = false;
+  gen->types_epoch++;
 }
 
 void add_class(class_entry_t c) {
-  printf("Adding class %s\n", c.name);
+  printf("Adding class %s\n", symbol_name(c.name));
   da_append(&gen->classes, c);
+  symbol_index_add(&gen->class_names, name_key(c.name),
+                   gen->classes.count - 1);
 }
 
-void add_function(function_entry_t f) { da_append(&gen->functions, f); }
+void add_function(function_entry_t f) {
+  da_append(&gen->functions, f);
+  symbol_index_add(&gen->function_names, f.name, gen->functions.count - 1);
+}
 
 void add_named_value(named_value_entry_t n) {
+  if (n.name != NO_SYMBOL) {
+    while (gen->value_of_symbol.count < symbol_count())
+      da_append(&gen->value_of_symbol, 0);
+    n.shadowed = gen->value_of_symbol.items[n.name];
+    gen->value_of_symbol.items[n.name] = gen->named_values.count + 1;
+  }
   da_append(&gen->named_values, n);
 }
 
+void add_builtin_type(const char *name, LLVMTypeRef type) {
+  type_t t = {intern_cstr(name), BUILTIN, type, NULL, NULL, NULL};
+  add_type(t);
+}
+
 void add_builtin_types() {
-  type_t int_t = {"int", BUILTIN, LLVMInt32TypeInContext(gen->context),
-                  NULL,  NULL,    NULL};
-  type_t char_t = {"char", BUILTIN, LLVMInt8TypeInContext(gen->context),
-                   NULL,   NULL,    NULL};
-  type_t i64_t = {"i64", BUILTIN, LLVMInt64TypeInContext(gen->context),
-                  NULL,  NULL,    NULL};
-  type_t i32_t = {"i32", BUILTIN, LLVMInt32TypeInContext(gen->context),
-                  NULL,  NULL,    NULL};
-  type_t i16_t = {"i16", BUILTIN, LLVMInt16TypeInContext(gen->context),
-                  NULL,  NULL,    NULL};
-  type_t i8_t = {"i8", BUILTIN, LLVMInt8TypeInContext(gen->context),
-                 NULL, NULL,    NULL};
-  type_t u64_t = {"u64", BUILTIN, LLVMInt64TypeInContext(gen->context),
-                  NULL,  NULL,    NULL};
-  type_t u32_t = {"u32", BUILTIN, LLVMInt32TypeInContext(gen->context),
-                  NULL,  NULL,    NULL};
-  type_t u16_t = {"u16", BUILTIN, LLVMInt16TypeInContext(gen->context),
-                  NULL,  NULL,    NULL};
-  type_t u8_t = {"u8", BUILTIN, LLVMInt8TypeInContext(gen->context),
-                 NULL, NULL,    NULL};
-  type_t void_t = {"void", BUILTIN, LLVMVoidTypeInContext(gen->context),
-                   NULL,   NULL,    NULL};
-  type_t bool_t = {"bool", BUILTIN, LLVMInt1TypeInContext(gen->context),
-                   NULL,   NULL,    NULL};
-  type_t float_t = {"float", BUILTIN, LLVMFloatTypeInContext(gen->context),
-                    NULL,    NULL,    NULL};
-
-  add_type(int_t);
-  add_type(char_t);
-  add_type(i64_t);
-  add_type(i32_t);
-  add_type(i16_t);
-  add_type(i8_t);
-  add_type(u64_t);
-  add_type(u32_t);
-  add_type(u16_t);
-  add_type(u8_t);
-  add_type(void_t);
-  add_type(bool_t);
-  add_type(float_t);
+  add_builtin_type("int", LLVMInt32TypeInContext(gen->context));
+  add_builtin_type("char", LLVMInt8TypeInContext(gen->context));
+  add_builtin_type("i64", LLVMInt64TypeInContext(gen->context));
+  add_builtin_type("i32", LLVMInt32TypeInContext(gen->context));
+  add_builtin_type("i16", LLVMInt16TypeInContext(gen->context));
+  add_builtin_type("i8", LLVMInt8TypeInContext(gen->context));
+  add_builtin_type("u64", LLVMInt64TypeInContext(gen->context));
+  add_builtin_type("u32", LLVMInt32TypeInContext(gen->context));
+  add_builtin_type("u16", LLVMInt16TypeInContext(gen->context));
+  add_builtin_type("u8", LLVMInt8TypeInContext(gen->context));
+  add_builtin_type("void", LLVMVoidTypeInContext(gen->context));
+  add_builtin_type("bool", LLVMInt1TypeInContext(gen->context));
+  add_builtin_type("float", LLVMFloatTypeInContext(gen->context));
 }
 
 function_entry_t get_putstring() {
   strings ss = {0};
   types ts = {0};
   da_append(&ss, "s");
-  da_append(&ts, get_ptr_of(get_type_from_name("char")));
-  type_t void_t = get_type_from_name("void");
+  da_append(&ts, get_ptr_of(get_type_from_name(gen->char_name)));
+  type_t void_t = get_type_from_name(gen->void_name);
   function_entry_t putstring = {"put_string", ss, ts, void_t, 0};
   return putstring;
 }
@@ -219,8 +328,8 @@ function_entry_t get_putchar() {
   strings ss = {0};
   types ts = {0};
   da_append(&ss, "c");
-  da_append(&ts, get_type_from_name("char"));
-  type_t void_t = get_type_from_name("void");
+  da_append(&ts, get_type_from_name(gen->char_name));
+  type_t void_t = get_type_from_name(gen->void_name);
   function_entry_t res = {"put_character", ss, ts, void_t, 0};
   return res;
 }
@@ -229,7 +338,7 @@ function_entry_t get_malloc() {
   strings ss = {0};
   types ts = {0};
   da_append(&ss, "size");
-  type_t void_ptr_t = get_ptr_of(get_type_from_name("void"));
+  type_t void_ptr_t = get_ptr_of(get_type_from_name(gen->void_name));
   da_append(&ts, get_ptr_of(void_ptr_t));
   function_entry_t res = {"malloc", ss, ts, void_ptr_t, 0};
   return res;
@@ -238,7 +347,7 @@ function_entry_t get_malloc() {
 function_entry_t get_syscall() {
   strings ss = {0};
   types ts = {0};
-  type_t int_t = get_type_from_name("int");
+  type_t int_t = get_type_from_name(gen->int_name);
   da_append(&ss, "sysno");
   da_append(&ts, int_t);
   function_entry_t res = {"syscall", ss, ts, int_t, 1};
@@ -248,7 +357,7 @@ function_entry_t get_syscall() {
 function_entry_t get_free() {
   strings ss = {0};
   types ts = {0};
-  type_t void_t = get_type_from_name("void");
+  type_t void_t = get_type_from_name(gen->void_name);
   da_append(&ss, "ptr");
   da_append(&ts, get_ptr_of(void_t));
   function_entry_t res = {"free", ss, ts, void_t, 0};
@@ -293,6 +402,28 @@ void generator_init(generator_t *g) {
   g->interfaces = (interfaces){0};
   g->inst_classes = (inst_classes){0};
   g->included_files = (strings){0};
+  g->expr_walk = (expr_walk){0};
+  g->operands = (operands){0};
+  g->types_indexed = true;
+  g->type_names = (symbol_index_t){.by_address = true};
+  g->type_llvms = (symbol_index_t){.by_address = true};
+  g->unstable_types = (indices){0};
+  g->function_names = (symbol_index_t){0};
+  g->class_names = (symbol_index_t){.by_address = true};
+  g->value_of_symbol = (indices){0};
+  g->type_nodes = (type_nodes){0};
+  g->type_slots = NULL;
+  g->type_slot_count = 0;
+  g->types_epoch = 1;
+  g->expr_types = NULL;
+  g->expr_type_slots = 0;
+  g->expr_types_used = 0;
+  g->void_name = intern_cstr("void");
+  g->float_name = intern_cstr("float");
+  g->int_name = intern_cstr("int");
+  g->i32_name = intern_cstr("i32");
+  g->bool_name = intern_cstr("bool");
+  g->char_name = intern_cstr("char");
   set_global_generator(g);
   add_builtin_types();
   add_builtin_functions();
@@ -300,7 +431,8 @@ void generator_init(generator_t *g) {
 
 int get_named_values_scope(bool d) {
   if (d) {
-    named_value_entry_t dummy = {strdup(""), get_type_from_name("void"), NULL};
+    named_value_entry_t dummy = {NO_SYMBOL, get_type_from_name(gen->void_name),
+                                 NULL, 0};
     add_named_value(dummy);
   }
   return gen->named_values.count;
@@ -315,10 +447,11 @@ void generate_defer(defer_elem_t elem) {
     EXIT;
   }
   class_entry_t c = get_class_by_name(elem.t.name);
-  if (does_method_exist(c, "destroy") < 0) {
+  symbol_t destroy = intern_cstr("destroy");
+  if (does_method_exist(c, destroy) < 0) {
     return; // no destroy method
   }
-  method_t m = get_method_by_name(c, "destroy");
+  method_t m = get_method_by_name(c, destroy);
   LLVMValueRef fptr = fptr_from_method(m, c);
   LLVMTypeRef ftype = ftype_from_method(m, c);
   LLVMValueRef args[] = {elem.ptr};
@@ -356,30 +489,28 @@ void generate_defers(int scope) {
 
 void reset_named_values_to_scope(int scope) {
   generate_defers(scope);
-  for (size_t index = scope + 1; index < gen->named_values.count; index++) {
-    int i = index;
-    free(gen->named_values.items[i].name);
+  // Newest first, so that each name gets its shadowed value back.
+  for (size_t i = gen->named_values.count; i > (size_t)scope; i--) {
+    named_value_entry_t n = gen->named_values.items[i - 1];
+    if (n.name != NO_SYMBOL)
+      gen->value_of_symbol.items[n.name] = n.shadowed;
   }
   gen->named_values.count = scope;
+  gen->types_epoch++;
 }
 
-void overwrite_pushed_value(LLVMValueRef value, char *name, type_t t) {
-  bool worked = false;
-  named_value_entry_t entry = {name, t, value};
-  for (int i = gen->named_values.count - 1; i >= 0; --i) {
-    if (strcmp(gen->named_values.items[i].name, name) == 0) {
-      gen->named_values.items[i].value = value;
-      worked = true;
-      break;
-    }
-  }
-  if (!worked) {
+void overwrite_pushed_value(LLVMValueRef value, symbol_t name, type_t t) {
+  named_value_entry_t entry = {name, t, value, 0};
+  int index = get_named_value(name);
+  if (index >= 0) {
+    gen->named_values.items[index].value = value;
+  } else {
     add_named_value(entry);
   }
 }
 
 type_t generate_templated_class_type(ast_t *type) {
-  char *class_name = sv_to_cstr(type->as.type.name.lexeme);
+  char *class_name = sv_to_cstr(token_lexeme(type->as.type.name));
 
   ast_t *template = NULL;
   for (size_t i = 0; i < gen->templates.count; ++i) {
@@ -400,8 +531,8 @@ type_t generate_templated_class_type(ast_t *type) {
   types ts = {0};
   for (size_t i = 0; i < temp.count; ++i) {
     void *mark = malloc(1);
-    char *type_name = sv_to_cstr(
-        temp.tempelems[i]->as.tempelem.type_iden->as.identifier.tok.lexeme);
+    symbol_t type_name = intern(token_lexeme(
+        temp.tempelems[i]->as.tempelem.type_iden->as.identifier.tok));
     // TODO: actually handle interfaces constraints
     // alias it
     type_t *ref = malloc(sizeof(type_t));
@@ -420,7 +551,7 @@ type_t generate_templated_class_type(ast_t *type) {
   if (inst_id >= 0) {
     char instance_name[256];
     sprintf(instance_name, "%sZ%d", class_name, inst_id);
-    type_t t = get_type_from_name(instance_name);
+    type_t t = get_type_from_name(intern_cstr(instance_name));
     free(class_name);
     return t;
   }
@@ -452,7 +583,7 @@ type_t generate_templated_class_type(ast_t *type) {
     for (int i = gen->types.count - 1; i >= 0; --i) {
       type_t current = gen->types.items[i];
       if (current.kind == ALIAS && current.ast == ptr) {
-        da_remove(&gen->types, i);
+        remove_type(i);
         break;
       }
     }
@@ -467,11 +598,7 @@ type_t get_type_from_ast(ast_t *type) {
     if (type->as.type.is_template) {
       return generate_templated_class_type(type);
     }
-    string_view_t tok = type->as.type.name.lexeme;
-    char *name = strndup(tok.contents, tok.length);
-    type_t res = get_type_from_name(name);
-    free(name);
-    return res;
+    return get_type_from_name(intern(token_lexeme(type->as.type.name)));
   }
   ast_t new = *type;
   new.as.type.ptr_n = 0;
@@ -493,7 +620,7 @@ bool is_file_included(const char *path) {
 
 bool is_include_std(ast_t *include) {
   if (include->kind == AST_IDENTIFIER) {
-    return sv_eq(SV("std"), include->as.identifier.tok.lexeme);
+    return sv_eq(SV("std"), token_lexeme(include->as.identifier.tok));
   }
   if (include->kind != AST_BINOP) {
     printf("Wrong include stmt: ");
@@ -522,21 +649,24 @@ void generate_include(ast_t *include) {
   free(postfix);
   if (!is_file_included(include_path)) {
     da_append(&gen->included_files, strdup(include_path));
-    FILE *f = fopen(include_path, "r");
-    if (f == NULL) {
+    // The source outlives include_path, it gets its own copy.
+    source_t *src = load_source(strdup(include_path));
+    if (src == NULL) {
       printf("Could not include %s\n", include_path);
       EXIT;
     }
-    string_view_t s = from_file(f);
-    fclose(f);
-    lexer_t l = new_unilang_lexer();
-    l.remaining = s;
-    l.current_loc = (location_t){include_path, 1, 1, false};
-    int worked = 0;
-    ast_t *prog = parse_program(&l, &worked);
-    if (!worked) {
-      printf("Could not include %s\n", include_path);
-      EXIT;
+    ast_t *prog = load_cached_ast(src);
+    if (prog == NULL) {
+      lexer_t l = new_unilang_lexer();
+      set_lexer_source(&l, src);
+      tokenize(&l);
+      int worked = 0;
+      prog = parse_program(&l, &worked);
+      if (!worked) {
+        printf("Could not include %s\n", include_path);
+        EXIT;
+      }
+      store_cached_ast(src, prog);
     }
     // TODO: generate all entries from it !
     // no need to actually geenrate ir because the library will be linked
@@ -564,11 +694,11 @@ void generate_include(ast_t *include) {
 }
 
 void generate_interface(ast_t *interface) {
-  char *name = sv_to_cstr(interface->as.interface.name.lexeme);
-  char *type = sv_to_cstr(interface->as.interface.type.lexeme);
+  char *name = sv_to_cstr(token_lexeme(interface->as.interface.name));
+  char *type = sv_to_cstr(token_lexeme(interface->as.interface.type));
   interface_entry_t entry = {name, type, (functions){0}};
   void *marker = malloc(1);
-  type_t tmp_type = {.name = type,
+  type_t tmp_type = {.name = intern_cstr(type),
                      .pointed_by = marker,
                      .kind = INTERFACE,
                      .ast = NULL,
@@ -582,7 +712,7 @@ void generate_interface(ast_t *interface) {
   for (int i = gen->types.count - 1; i >= 0; --i) {
     type_t current = gen->types.items[i];
     if (current.pointed_by == marker) {
-      da_remove(&gen->types, i);
+      remove_type(i);
       break;
     }
   }
@@ -660,12 +790,12 @@ function_entry_t entry_from_fundef(ast_t *fundef) {
   types arg_types = {0};
   ast_fundef_t f = fundef->as.fundef;
   for (size_t i = 0; i < f.param_count; ++i) {
-    char *arg_name = sv_to_cstr(f.param_names[i].lexeme);
+    char *arg_name = sv_to_cstr(token_lexeme(f.param_names[i]));
     type_t arg_type = get_type_from_ast(f.param_types[i]);
     da_append(&arg_names, arg_name);
     da_append(&arg_types, arg_type);
   }
-  char *name = sv_to_cstr(f.name.lexeme);
+  char *name = sv_to_cstr(token_lexeme(f.name));
   type_t ret = get_type_from_ast(f.return_type);
   function_entry_t entry = {.name = name,
                             .arg_names = arg_names,
@@ -680,7 +810,7 @@ LLVMValueRef fptr_from_entry(function_entry_t f) {
   return LLVMGetNamedFunction(gen->module, f.name);
 }
 
-type_t get_aliased_with_name(const char *name, void *ref) {
+type_t get_aliased_with_name(symbol_t name, void *ref) {
   int start_index = -1;
 
   // for (int i = gen->types.count - 1; i>= 0; --i) {
@@ -702,7 +832,7 @@ type_t get_aliased_with_name(const char *name, void *ref) {
     if (t.kind != ALIAS) {
       continue;
     }
-    if (strcmp(t.name, name) == 0) {
+    if (t.name == name) {
       if (t.pointed_by == ref) {
         continue;
       }
@@ -710,7 +840,7 @@ type_t get_aliased_with_name(const char *name, void *ref) {
     }
   }
   printf("Could not retrieve alias type with name %s in current context.\n",
-         name);
+         symbol_name(name));
   printf("Current context:\n");
   print_types();
   EXIT;
@@ -753,8 +883,8 @@ void push_params(function_entry_t entry, LLVMValueRef fptr) {
     type_t t = entry.arg_types.items[i];
     LLVMValueRef ptr = LLVMBuildAlloca(gen->builder, type_to_llvm(t), "ptr");
     LLVMBuildStore(gen->builder, arg, ptr);
-    named_value_entry_t nv = {name, t, ptr};
-    da_append(&gen->named_values, nv);
+    named_value_entry_t nv = {intern_cstr(name), t, ptr, 0};
+    add_named_value(nv);
   }
 }
 
@@ -803,7 +933,7 @@ void generate_function_body(function_entry_t entry, ast_t *body) {
   reset_named_values_to_scope(scope);
 
   if (LLVMGetBasicBlockTerminator(gen->last_bb) == NULL) {
-    if (strcmp(entry.return_type.name, "void") == 0) {
+    if (entry.return_type.name == gen->void_name) {
       LLVMBuildRetVoid(gen->builder);
     } else {
       LLVMBuildUnreachable(gen->builder);
@@ -812,7 +942,7 @@ void generate_function_body(function_entry_t entry, ast_t *body) {
 }
 
 int token_to_int(token_t tok) {
-  string_view_t l = tok.lexeme;
+  string_view_t l = token_lexeme(tok);
   int res = 0;
   int mult = 1;
   if (l.contents[0] == '-') {
@@ -827,13 +957,14 @@ int token_to_int(token_t tok) {
 }
 
 LLVMValueRef generate_intlit(token_t tok) {
-  return LLVMConstInt(get_type_from_name("i32").type, token_to_int(tok), 1);
+  return LLVMConstInt(get_type_from_name(gen->i32_name).type, token_to_int(tok),
+                      1);
 }
 
 LLVMValueRef generate_stringlit(token_t tok) {
   string_view_t actual;
-  actual.contents = tok.lexeme.contents + 1;
-  actual.length = tok.lexeme.length - 2;
+  actual.contents = token_lexeme(tok).contents + 1;
+  actual.length = token_lexeme(tok).length - 2;
   char *cstr = strndup(actual.contents, actual.length);
   char *cstr2 = unescape_string(cstr);
   LLVMValueRef str = LLVMBuildGlobalStringPtr(gen->builder, cstr2, "");
@@ -849,10 +980,9 @@ void generate_fundef(ast_t *fundef) {
 }
 
 function_entry_t f_by_name(const char *name) {
-  for (size_t i = 0; i < gen->functions.count; i++) {
-    if (strcmp(gen->functions.items[i].name, name) == 0) {
-      return gen->functions.items[i];
-    }
+  size_t i = symbol_index_oldest(&gen->function_names, name);
+  if (i != SYMBOL_NONE) {
+    return gen->functions.items[i];
   }
 
   printf("%s:%d : error: undefined function '%s'\n", __FILE__, __LINE__, name);
@@ -860,20 +990,20 @@ function_entry_t f_by_name(const char *name) {
 }
 
 function_entry_t get_global_function(ast_t *called) {
-  string_view_t lexeme = called->as.identifier.tok.lexeme;
+  string_view_t lexeme = token_lexeme(called->as.identifier.tok);
   char *name = sv_to_cstr(lexeme);
   function_entry_t entry = f_by_name(name);
   free(name);
   return entry;
 }
 
-method_t get_method_by_name(class_entry_t cdef, const char *name) {
-  for (size_t i = 0; i < cdef.methods.count; i++) {
-    if (strcmp(cdef.methods.items[i].name, name) == 0) {
-      return cdef.methods.items[i];
-    }
+method_t get_method_by_name(class_entry_t cdef, symbol_t name) {
+  int index = does_method_exist(cdef, name);
+  if (index >= 0) {
+    return cdef.methods.items[index];
   }
-  printf("error: undefined method '%s' in class %s.\n", name, cdef.name);
+  printf("error: undefined method '%s' in class %s.\n", symbol_name(name),
+         symbol_name(cdef.name));
   EXIT;
 }
 
@@ -901,26 +1031,22 @@ int get_class_instance_index(const char *class_name, types ts) {
   return -1; // Not found
 }
 
-class_entry_t get_class_by_name(const char *name) {
-  for (size_t i = 0; i < gen->classes.count; i++) {
-    if (strcmp(gen->classes.items[i].name, name) == 0) {
-      return gen->classes.items[i];
-    }
+class_entry_t get_class_by_name(symbol_t name) {
+  size_t i = symbol_index_oldest(&gen->class_names, name_key(name));
+  if (i != SYMBOL_NONE) {
+    return gen->classes.items[i];
   }
-  printf("No class named %s found.\n", name);
+  printf("No class named %s found.\n", symbol_name(name));
   EXIT;
 }
 
 type_t get_return_type(ast_t *funcall) {
   if (funcall->as.funcall.called->kind == AST_IDENTIFIER) {
-    char *funname =
-        sv_to_cstr(funcall->as.funcall.called->as.identifier.tok.lexeme);
+    symbol_t funname =
+        intern(token_lexeme(funcall->as.funcall.called->as.identifier.tok));
     if (does_type_exist(funname)) {
-      type_t res = get_type_from_name(funname);
-      free(funname);
-      return res;
+      return get_type_from_name(funname);
     }
-    free(funname);
     function_entry_t entry = get_global_function(funcall->as.funcall.called);
     return entry.return_type;
   }
@@ -947,7 +1073,8 @@ type_t get_return_type(ast_t *funcall) {
       printf("error: cannot call method with non-identifier name\n");
       EXIT;
     }
-    char *name = sv_to_cstr(called->as.binop.rhs->as.identifier.tok.lexeme);
+    symbol_t name =
+        intern(token_lexeme(called->as.binop.rhs->as.identifier.tok));
     method_t m = get_method_by_name(cdef, name);
     return get_type_used_in_class(cdef, m.return_type);
   }
@@ -955,7 +1082,7 @@ type_t get_return_type(ast_t *funcall) {
   EXIT;
 }
 
-int get_matching_constructor(const char *class_name, types arg_types) {
+int get_matching_constructor(symbol_t class_name, types arg_types) {
   // Get the class entry
   class_entry_t cdef = get_class_by_name(class_name);
 
@@ -998,8 +1125,8 @@ int get_matching_constructor(const char *class_name, types arg_types) {
         continue; // Can cast between pointer types
       }
       // Check float to int and int to float
-      if ((strcmp(expected.name, "float") == 0 && is_integer_type(provided)) ||
-          (is_integer_type(expected) && strcmp(provided.name, "float") == 0)) {
+      if ((expected.name == gen->float_name && is_integer_type(provided)) ||
+          (is_integer_type(expected) && provided.name == gen->float_name)) {
         continue;
       }
       // If we get here, we can't cast this argument
@@ -1015,8 +1142,8 @@ int get_matching_constructor(const char *class_name, types arg_types) {
 
 LLVMValueRef generate_funcall(ast_t *funcall) {
   if (funcall->as.funcall.called->kind == AST_IDENTIFIER) {
-    char *name =
-        sv_to_cstr(funcall->as.funcall.called->as.identifier.tok.lexeme);
+    symbol_t name =
+        intern(token_lexeme(funcall->as.funcall.called->as.identifier.tok));
     if (does_type_exist(name)) {
       // try and find a suitable constructor !
       types ts = {0};
@@ -1027,7 +1154,8 @@ LLVMValueRef generate_funcall(ast_t *funcall) {
       int cons = get_matching_constructor(name, ts);
       da_free(ts);
       if (cons < 0) {
-        printf("Could not find matching constructor for %s(", name);
+        printf("Could not find matching constructor for %s(",
+               symbol_name(name));
         for (size_t i = 0; i < ts.count; ++i) {
           if (i > 0) {
             printf(", ");
@@ -1114,7 +1242,8 @@ LLVMValueRef generate_funcall(ast_t *funcall) {
       printf("error: cannot call method with non-identifier name\n");
       EXIT;
     }
-    char *name = sv_to_cstr(called->as.binop.rhs->as.identifier.tok.lexeme);
+    symbol_t name =
+        intern(token_lexeme(called->as.binop.rhs->as.identifier.tok));
     method_t m = get_method_by_name(cdef, name);
     LLVMValueRef left = get_lm_pointer(called->as.binop.lhs);
     lvalues args = {0};
@@ -1122,7 +1251,8 @@ LLVMValueRef generate_funcall(ast_t *funcall) {
     if (funcall->as.funcall.arg_count != m.arg_names.count) {
       printf("error: expected %ld arguments for method %s of class %s but got "
              "%ld.\n",
-             m.arg_names.count, name, cdef.name, funcall->as.funcall.arg_count);
+             m.arg_names.count, symbol_name(name), symbol_name(cdef.name),
+             funcall->as.funcall.arg_count);
       EXIT;
     }
     for (size_t i = 0; i < m.arg_names.count; ++i) {
@@ -1140,7 +1270,6 @@ LLVMValueRef generate_funcall(ast_t *funcall) {
     LLVMValueRef res =
         LLVMBuildCall2(gen->builder, ftype, fptr, args.items, args.count, "");
     da_free(args);
-    free(name);
     return res;
   }
   printf("Unreachable 2\n");
@@ -1155,7 +1284,7 @@ int get_index_of_field(const char *field_name, class_entry_t cdef) {
       return i;
     }
   }
-  printf("No field %s in class %s.\n", field_name, cdef.name);
+  printf("No field %s in class %s.\n", field_name, symbol_name(cdef.name));
   EXIT;
 }
 
@@ -1179,7 +1308,7 @@ int get_binop_method_index(token_kind_t op, class_entry_t cdef) {
     EXIT;
   }
   }
-  return does_method_exist(cdef, name);
+  return does_method_exist(cdef, intern_cstr(name));
 }
 
 bool is_cmp(token_kind_t k) {
@@ -1218,13 +1347,170 @@ type_t sanitize_type(type_t t) {
   return t;
 }
 
+// Type of a binop given the types of its operands.
+type_t t_of_binop(ast_t *expr, type_t lt, type_t rt) {
+  if (is_cmp(expr->as.binop.op.kind)) {
+    return get_type_from_name(gen->bool_name);
+  }
+  if (lt.kind == CLASS) {
+    class_entry_t cdef = get_class_by_name(lt.name);
+    int index = get_binop_method_index(expr->as.binop.op.kind, cdef);
+    if (index < 0) {
+      printf("No method for '" SF "' binop in class %s\n",
+             SA(token_lexeme(expr->as.binop.op)), symbol_name(lt.name));
+      EXIT;
+    }
+    method_t m = cdef.methods.items[index];
+    return get_type_used_in_class(cdef, m.return_type);
+  }
+  if (type_to_llvm(lt) == type_to_llvm(rt)) {
+    return lt;
+  }
+  if (lt.kind == PTR) {
+    return lt;
+  }
+  if (rt.kind == PTR) {
+    return rt;
+  }
+  if (LLVMSizeOf(type_to_llvm(lt)) > LLVMSizeOf(type_to_llvm(rt))) {
+    return lt;
+  }
+  return rt;
+}
+
+expr_type_t *expr_type_slot(ast_t *expr) {
+  size_t mask = gen->expr_type_slots - 1;
+  size_t i = (((uintptr_t)expr >> 4) * 2654435761u) & mask;
+  while (gen->expr_types[i].expr != NULL && gen->expr_types[i].expr != expr)
+    i = (i + 1) & mask;
+  return &gen->expr_types[i];
+}
+
+// Cached type of an expression, NULL if it has to be found again.
+type_t *cached_expr_type(ast_t *expr) {
+  if (gen->expr_type_slots == 0)
+    return NULL;
+  expr_type_t *e = expr_type_slot(expr);
+  if (e->expr == NULL || e->epoch != gen->types_epoch)
+    return NULL;
+  return &e->t;
+}
+
+// Grows the table if needed, dropping the types of past epochs.
+void rehash_expr_types(void) {
+  expr_type_t *old = gen->expr_types;
+  size_t old_count = gen->expr_type_slots;
+  size_t live = 0;
+  for (size_t i = 0; i < old_count; i++) {
+    if (old[i].expr != NULL && old[i].epoch == gen->types_epoch)
+      live++;
+  }
+  gen->expr_type_slots = old_count == 0 ? 1024 : old_count;
+  if (4 * (live + 1) > gen->expr_type_slots)
+    gen->expr_type_slots *= 2;
+  gen->expr_types = calloc(gen->expr_type_slots, sizeof(expr_type_t));
+  if (gen->expr_types == NULL) {
+    perror("Allocation failed");
+    exit(1);
+  }
+  for (size_t i = 0; i < old_count; i++) {
+    if (old[i].expr != NULL && old[i].epoch == gen->types_epoch)
+      *expr_type_slot(old[i].expr) = old[i];
+  }
+  gen->expr_types_used = live;
+  free(old);
+}
+
+void cache_expr_type(ast_t *expr, type_t t) {
+  if (2 * (gen->expr_types_used + 1) > gen->expr_type_slots)
+    rehash_expr_types();
+  expr_type_t *e = expr_type_slot(expr);
+  if (e->expr == NULL)
+    gen->expr_types_used++;
+  *e = (expr_type_t){expr, gen->types_epoch, t};
+}
+
+// Field accesses are lvalues and handled as leaves of a binop chain.
+bool is_walked_binop(ast_t *expr) {
+  return expr->kind == AST_BINOP && expr->as.binop.op.kind != ACCESS;
+}
+
+type_t operand_type(operand_t o) {
+  if (o.is_leaf) {
+    return t_of_expr(o.expr);
+  }
+  return sanitize_type(t_of_binop(o.expr, o.lt, o.rt));
+}
+
+LLVMValueRef generate_binop_values(ast_t *binop, LLVMValueRef lhs,
+                                   LLVMValueRef rhs, type_t lt, type_t rt);
+
+void push_walk(ast_t *expr, bool expanded) {
+  da_append(&gen->expr_walk, ((expr_walk_frame_t){expr, expanded}));
+}
+
+// Post-order walk of a binop chain, generating its value or only finding the
+// types of its operands. Nested walks, e.g. from a function call argument,
+// run above the frames of the walk that started them.
+operand_t walk_binop(ast_t *binop, bool generate) {
+  size_t walk_base = gen->expr_walk.count;
+  size_t operand_base = gen->operands.count;
+  push_walk(binop, false);
+  while (gen->expr_walk.count > walk_base) {
+    expr_walk_frame_t f = gen->expr_walk.items[--gen->expr_walk.count];
+    // When only typing, operands typed before are not walked again.
+    bool is_typed =
+        !generate && f.expr != binop && cached_expr_type(f.expr) != NULL;
+    bool is_leaf = !is_walked_binop(f.expr) ||
+                   (!generate && is_cmp(f.expr->as.binop.op.kind)) || is_typed;
+    if (is_leaf) {
+      LLVMValueRef value = generate ? generate_expression(f.expr) : NULL;
+      da_append(&gen->operands, ((operand_t){value, f.expr, {0}, {0}, true}));
+      continue;
+    }
+    if (!f.expanded) {
+      push_walk(f.expr, true);
+      push_walk(f.expr->as.binop.rhs, false);
+      push_walk(f.expr->as.binop.lhs, false);
+      continue;
+    }
+    gen->operands.count -= 2;
+    operand_t lhs = gen->operands.items[gen->operands.count];
+    operand_t rhs = gen->operands.items[gen->operands.count + 1];
+    type_t lt = operand_type(lhs);
+    type_t rt = operand_type(rhs);
+    LLVMValueRef value = NULL;
+    if (generate) {
+      value = generate_binop_values(f.expr, lhs.value, rhs.value, lt, rt);
+    } else if (f.expr != binop) {
+      cache_expr_type(f.expr, t_of_binop(f.expr, lt, rt));
+    }
+    da_append(&gen->operands, ((operand_t){value, f.expr, lt, rt, false}));
+  }
+  gen->operands.count = operand_base;
+  return gen->operands.items[operand_base];
+}
+
+type_t find_expr_type(ast_t *expr);
+
+// Typing an expression types its subexpressions: each one is only typed once
+// per epoch, instead of once per enclosing expression.
 type_t t_of_expr_unsafe(ast_t *expr) {
+  type_t *cached = cached_expr_type(expr);
+  if (cached != NULL)
+    return *cached;
+  type_t t = find_expr_type(expr);
+  cache_expr_type(expr, t);
+  return t;
+}
+
+type_t find_expr_type(ast_t *expr) {
   switch (expr->kind) {
   case AST_INTLIT: {
-    return get_type_from_name("i32");
+    return get_type_from_name(gen->i32_name);
   } break;
   case AST_STRINGLIT: {
-    return get_ptr_of(get_type_from_name("char"));
+    return get_ptr_of(get_type_from_name(gen->char_name));
   } break;
   case AST_BINOP: {
     if (expr->as.binop.op.kind == ACCESS) {
@@ -1233,7 +1519,8 @@ type_t t_of_expr_unsafe(ast_t *expr) {
         lhs = dereference_type(lhs);
       }
       if (lhs.kind != CLASS) {
-        printf("Cannot access field of non-class type %s\n", lhs.name);
+        printf("Cannot access field of non-class type %s\n",
+               symbol_name(lhs.name));
         EXIT;
       }
       class_entry_t c = get_class_by_name(lhs.name);
@@ -1242,55 +1529,29 @@ type_t t_of_expr_unsafe(ast_t *expr) {
         EXIT;
       }
       char *field_name =
-          sv_to_cstr(expr->as.binop.rhs->as.identifier.tok.lexeme);
+          sv_to_cstr(token_lexeme(expr->as.binop.rhs->as.identifier.tok));
       int index = get_index_of_field(field_name, c);
       free(field_name);
       return sanitize_type(c.members.items[index].type);
     }
     if (is_cmp(expr->as.binop.op.kind)) {
-      return get_type_from_name("bool");
+      return get_type_from_name(gen->bool_name);
     }
-    type_t lt = t_of_expr(expr->as.binop.lhs);
-    type_t rt = t_of_expr(expr->as.binop.rhs);
-    if (lt.kind == CLASS) {
-      class_entry_t cdef = get_class_by_name(lt.name);
-      int index = get_binop_method_index(expr->as.binop.op.kind, cdef);
-      if (index < 0) {
-        printf("No method for '" SF "' binop in class %s\n",
-               SA(expr->as.binop.op.lexeme), lt.name);
-        EXIT;
-      }
-      method_t m = cdef.methods.items[index];
-      return get_type_used_in_class(cdef, m.return_type);
-    }
-    if (type_to_llvm(lt) == type_to_llvm(rt)) {
-      return lt;
-    }
-    if (lt.kind == PTR) {
-      return lt;
-    }
-    if (rt.kind == PTR) {
-      return rt;
-    }
-    if (LLVMSizeOf(type_to_llvm(lt)) > LLVMSizeOf(type_to_llvm(rt))) {
-      return lt;
-    }
-    return rt;
+    operand_t o = walk_binop(expr, false);
+    return t_of_binop(expr, o.lt, o.rt);
   } break;
   case AST_IDENTIFIER: {
-    char *name = sv_to_cstr(expr->as.identifier.tok.lexeme);
-
+    symbol_t name = intern(token_lexeme(expr->as.identifier.tok));
     int index = get_named_value(name);
     if (index < 0) {
-      printf("Identifier %s not declared in the current scope\n", name);
+      printf("Identifier %s not declared in the current scope\n",
+             symbol_name(name));
       EXIT;
     }
-    type_t res = gen->named_values.items[index].t;
-    free(name);
-    return res;
+    return gen->named_values.items[index].t;
   } break;
   case AST_BOOLLIT: {
-    return get_type_from_name("bool");
+    return get_type_from_name(gen->bool_name);
   }
   case AST_FUNCALL: {
     return get_return_type(expr);
@@ -1316,10 +1577,10 @@ type_t t_of_expr_unsafe(ast_t *expr) {
     return dereference_type(t_of_expr(expr->as.index.subscripted));
   }
   case AST_CHARLIT: {
-    return get_type_from_name("char");
+    return get_type_from_name(gen->char_name);
   } break;
   case AST_FLOATLIT: {
-    return get_type_from_name("float");
+    return get_type_from_name(gen->float_name);
   } break;
   case AST_SIZE_DIR: {
     return get_type_from_llvm(LLVMTypeOf(
@@ -1345,10 +1606,12 @@ void add_defer(defer_elem_t d) {
 }
 
 LLVMValueRef generate_binop(ast_t *binop) {
-  LLVMValueRef lhs = generate_expression(binop->as.binop.lhs);
-  LLVMValueRef rhs = generate_expression(binop->as.binop.rhs);
-  type_t lt = t_of_expr(binop->as.binop.lhs);
-  type_t rt = t_of_expr(binop->as.binop.rhs);
+  return walk_binop(binop, true).value;
+}
+
+// Builds a binop from the values and types of its operands.
+LLVMValueRef generate_binop_values(ast_t *binop, LLVMValueRef lhs,
+                                   LLVMValueRef rhs, type_t lt, type_t rt) {
   if (lt.kind == CLASS) {
     type_t glob_type = t_of_expr(binop);
     if (glob_type.kind == CLASS) {
@@ -1368,7 +1631,7 @@ LLVMValueRef generate_binop(ast_t *binop) {
     int index = get_binop_method_index(binop->as.binop.op.kind, cdef);
     if (index < 0) {
       printf("No method for '" SF "' binop in class %s\n",
-             SA(binop->as.binop.op.lexeme), lt.name);
+             SA(token_lexeme(binop->as.binop.op)), symbol_name(lt.name));
       EXIT;
     }
     gen->current_ptr = NULL;
@@ -1401,43 +1664,43 @@ LLVMValueRef generate_binop(ast_t *binop) {
   LLVMValueRef res;
   switch (binop->as.binop.op.kind) {
   case PLUS: {
-    if (strcmp(lt.name, "float") == 0) {
+    if (lt.name == gen->float_name) {
       res = LLVMBuildFAdd(gen->builder, lhs, rhs, "");
     } else {
       res = LLVMBuildAdd(gen->builder, lhs, rhs, "");
     }
   } break;
   case MINUS: {
-    if (strcmp(lt.name, "float") == 0) {
+    if (lt.name == gen->float_name) {
       res = LLVMBuildFSub(gen->builder, lhs, rhs, "");
     } else {
       res = LLVMBuildSub(gen->builder, lhs, rhs, "");
     }
   } break;
   case MULT: {
-    if (strcmp(lt.name, "float") == 0) {
+    if (lt.name == gen->float_name) {
       res = LLVMBuildFMul(gen->builder, lhs, rhs, "");
     } else {
       res = LLVMBuildMul(gen->builder, lhs, rhs, "");
     }
   } break;
   case DIV: {
-    if (strcmp(lt.name, "float") == 0) {
+    if (lt.name == gen->float_name) {
       res = LLVMBuildFDiv(gen->builder, lhs, rhs, "");
     } else {
       res = LLVMBuildSDiv(gen->builder, lhs, rhs, "");
     }
   } break;
   case MODULO: {
-    if (strcmp(lt.name, "float") == 0) {
+    if (lt.name == gen->float_name) {
       printf("TODO: no %% for floats\n");
       EXIT;
     }
     res = LLVMBuildSRem(gen->builder, lhs, rhs, "");
   } break;
   case LT: {
-    if (strcmp(lt.name, "float") == 0) {
-      LLVMTypeRef t = get_type_from_name("int").type;
+    if (lt.name == gen->float_name) {
+      LLVMTypeRef t = get_type_from_name(gen->int_name).type;
       LLVMValueRef sub = LLVMBuildFSub(gen->builder, lhs, rhs, "");
       sub = LLVMBuildFPToSI(gen->builder, sub, t, "");
       lhs = sub;
@@ -1446,8 +1709,8 @@ LLVMValueRef generate_binop(ast_t *binop) {
     res = LLVMBuildICmp(gen->builder, LLVMIntSLT, lhs, rhs, "");
   } break;
   case GT: {
-    if (strcmp(lt.name, "float") == 0) {
-      LLVMTypeRef t = get_type_from_name("int").type;
+    if (lt.name == gen->float_name) {
+      LLVMTypeRef t = get_type_from_name(gen->int_name).type;
       LLVMValueRef sub = LLVMBuildFSub(gen->builder, lhs, rhs, "");
       sub = LLVMBuildFPToSI(gen->builder, sub, t, "");
       lhs = sub;
@@ -1456,8 +1719,8 @@ LLVMValueRef generate_binop(ast_t *binop) {
     res = LLVMBuildICmp(gen->builder, LLVMIntSGT, lhs, rhs, "");
   } break;
   case LEQ: {
-    if (strcmp(lt.name, "float") == 0) {
-      LLVMTypeRef t = get_type_from_name("int").type;
+    if (lt.name == gen->float_name) {
+      LLVMTypeRef t = get_type_from_name(gen->int_name).type;
       LLVMValueRef sub = LLVMBuildFSub(gen->builder, lhs, rhs, "");
       sub = LLVMBuildFPToSI(gen->builder, sub, t, "");
       lhs = sub;
@@ -1466,8 +1729,8 @@ LLVMValueRef generate_binop(ast_t *binop) {
     res = LLVMBuildICmp(gen->builder, LLVMIntSLE, lhs, rhs, "");
   } break;
   case GEQ: {
-    if (strcmp(lt.name, "float") == 0) {
-      LLVMTypeRef t = get_type_from_name("int").type;
+    if (lt.name == gen->float_name) {
+      LLVMTypeRef t = get_type_from_name(gen->int_name).type;
       LLVMValueRef sub = LLVMBuildFSub(gen->builder, lhs, rhs, "");
       sub = LLVMBuildFPToSI(gen->builder, sub, t, "");
       lhs = sub;
@@ -1476,8 +1739,8 @@ LLVMValueRef generate_binop(ast_t *binop) {
     res = LLVMBuildICmp(gen->builder, LLVMIntSGE, lhs, rhs, "");
   } break;
   case EQ: {
-    if (strcmp(lt.name, "float") == 0) {
-      LLVMTypeRef t = get_type_from_name("int").type;
+    if (lt.name == gen->float_name) {
+      LLVMTypeRef t = get_type_from_name(gen->int_name).type;
       LLVMValueRef sub = LLVMBuildFSub(gen->builder, lhs, rhs, "");
       sub = LLVMBuildFPToSI(gen->builder, sub, t, "");
       lhs = sub;
@@ -1486,8 +1749,8 @@ LLVMValueRef generate_binop(ast_t *binop) {
     res = LLVMBuildICmp(gen->builder, LLVMIntEQ, lhs, rhs, "");
   } break;
   case DIFF: {
-    if (strcmp(lt.name, "float") == 0) {
-      LLVMTypeRef t = get_type_from_name("int").type;
+    if (lt.name == gen->float_name) {
+      LLVMTypeRef t = get_type_from_name(gen->int_name).type;
       LLVMValueRef sub = LLVMBuildFSub(gen->builder, lhs, rhs, "");
       sub = LLVMBuildFPToSI(gen->builder, sub, t, "");
       lhs = sub;
@@ -1496,13 +1759,13 @@ LLVMValueRef generate_binop(ast_t *binop) {
     res = LLVMBuildICmp(gen->builder, LLVMIntNE, lhs, rhs, "");
   } break;
   case AND: {
-    type_t b = get_type_from_name("bool");
+    type_t b = get_type_from_name(gen->bool_name);
     lhs = generate_cast(lhs, lt, b);
     rhs = generate_cast(rhs, rt, b);
     res = LLVMBuildAnd(gen->builder, lhs, rhs, "");
   } break;
   case OR: {
-    type_t b = get_type_from_name("bool");
+    type_t b = get_type_from_name(gen->bool_name);
     lhs = generate_cast(lhs, lt, b);
     rhs = generate_cast(rhs, rt, b);
     res = LLVMBuildOr(gen->builder, lhs, rhs, "");
@@ -1514,7 +1777,8 @@ LLVMValueRef generate_binop(ast_t *binop) {
   }
   }
   if (is_ptr) {
-    res = generate_cast(res, lt, get_ptr_of(get_type_from_name("void")));
+    res =
+        generate_cast(res, lt, get_ptr_of(get_type_from_name(gen->void_name)));
   }
   return res;
 }
@@ -1527,20 +1791,13 @@ LLVMValueRef generate_access(ast_t *binop) {
 }
 
 bool is_type_int(type_t t) {
-  return t.kind == BUILTIN && strcmp(t.name, "void") != 0;
+  return t.kind == BUILTIN && t.name != gen->void_name;
 }
 
-int get_named_value(char *name) {
-  for (size_t i = 0; i < gen->named_values.count; ++i) {
-    int index = gen->named_values.count - i - 1;
-    char *s1 = gen->named_values.items[index].name;
-    if (strlen(s1) > 0) {
-      if (strcmp(gen->named_values.items[index].name, name) == 0) {
-        return index;
-      }
-    }
-  }
-  return -1;
+int get_named_value(symbol_t name) {
+  if (name == NO_SYMBOL || name >= gen->value_of_symbol.count)
+    return -1;
+  return (int)gen->value_of_symbol.items[name] - 1;
 }
 
 LLVMValueRef generate_deref(ast_t *expr) {
@@ -1569,9 +1826,10 @@ LLVMValueRef generate_unop(ast_t *expr) {
   }
   if (expr->as.unop.op.kind == MINUS) {
     type_t t = t_of_expr(expr->as.unop.operand);
-    if (strcmp(t.name, "float") == 0) {
-      return LLVMBuildFSub(gen->builder,
-                           LLVMConstReal(get_type_from_name("float").type, 0),
+    if (t.name == gen->float_name) {
+      return LLVMBuildFSub(
+          gen->builder,
+          LLVMConstReal(get_type_from_name(gen->float_name).type, 0),
                            generate_expression(expr->as.unop.operand), "");
     }
     if (t.kind != BUILTIN) {
@@ -1583,7 +1841,7 @@ LLVMValueRef generate_unop(ast_t *expr) {
   }
   if (expr->as.unop.op.kind == NOT) {
     type_t t = t_of_expr(expr->as.unop.operand);
-    type_t bool_t = get_type_from_name("bool");
+    type_t bool_t = get_type_from_name(gen->bool_name);
     LLVMValueRef e = generate_expression(expr->as.unop.operand);
     if (!are_types_equal(t, bool_t)) {
       e = generate_cast(e, t, bool_t);
@@ -1633,8 +1891,9 @@ LLVMValueRef generate_new_dir(ast_t *expr) {
 }
 
 LLVMValueRef generate_floatlit(token_t tok) {
-  char *s = sv_to_cstr(tok.lexeme);
-  LLVMValueRef res = LLVMConstRealOfString(get_type_from_name("float").type, s);
+  char *s = sv_to_cstr(token_lexeme(tok));
+  LLVMValueRef res =
+      LLVMConstRealOfString(get_type_from_name(gen->float_name).type, s);
   free(s);
   return res;
 }
@@ -1660,22 +1919,22 @@ LLVMValueRef generate_expression(ast_t *expr) {
     return generate_binop(expr);
   } break;
   case AST_IDENTIFIER: {
-    char *name = sv_to_cstr(expr->as.identifier.tok.lexeme);
+    symbol_t name = intern(token_lexeme(expr->as.identifier.tok));
     int index = get_named_value(name);
     if (index < 0) {
-      printf("Identifier %s not declared in this scope 2 (%d) \n", name, index);
+      printf("Identifier %s not declared in this scope 2 (%d) \n",
+             symbol_name(name), index);
       EXIT;
     }
     named_value_entry_t entry = gen->named_values.items[index];
     LLVMValueRef ptr = entry.value;
     type_t t = entry.t;
-    LLVMValueRef res = LLVMBuildLoad2(gen->builder, type_to_llvm(t), ptr, name);
-    free(name);
-    return res;
+    return LLVMBuildLoad2(gen->builder, type_to_llvm(t), ptr,
+                          symbol_name(name));
   }
   case AST_BOOLLIT: {
     int val = expr->as.boollit.val;
-    return LLVMConstInt(get_type_from_name("bool").type, val, 0);
+    return LLVMConstInt(get_type_from_name(gen->bool_name).type, val, 0);
   }
   case AST_UNOP: {
     return generate_unop(expr);
@@ -1690,7 +1949,7 @@ LLVMValueRef generate_expression(ast_t *expr) {
     return generate_new_dir(expr);
   }
   case AST_CHARLIT: {
-    string_view_t lit = expr->as.charlit.tok.lexeme;
+    string_view_t lit = token_lexeme(expr->as.charlit.tok);
     lit.contents++;
     lit.length -= 2;
     char *cstr = sv_to_cstr(lit);
@@ -1698,7 +1957,8 @@ LLVMValueRef generate_expression(ast_t *expr) {
     char c = cstr2[0];
     free(cstr);
     free(cstr2);
-    LLVMValueRef res = LLVMConstInt(get_type_from_name("char").type, c, 0);
+    LLVMValueRef res =
+        LLVMConstInt(get_type_from_name(gen->char_name).type, c, 0);
     return res;
   }
   case AST_SIZE_DIR: {
@@ -1713,7 +1973,7 @@ LLVMValueRef generate_expression(ast_t *expr) {
 
 void generate_ifstmt(ast_t *if_stmt) {
   type_t t = t_of_expr(if_stmt->as.if_stmt.cond);
-  type_t bool_t = get_type_from_name("bool");
+  type_t bool_t = get_type_from_name(gen->bool_name);
   LLVMValueRef cond = generate_expression(if_stmt->as.if_stmt.cond);
   if (!are_types_equal(t, bool_t)) {
     cond = generate_cast(cond, t, bool_t);
@@ -1765,7 +2025,7 @@ void generate_whilestmt(ast_t *while_stmt) {
   gen->last_bb = bb_cond;
   LLVMValueRef cond_expr = generate_expression(cond);
   type_t t = t_of_expr(cond);
-  type_t bool_t = get_type_from_name("bool");
+  type_t bool_t = get_type_from_name(gen->bool_name);
   if (LLVMTypeOf(cond_expr) != type_to_llvm(bool_t)) {
     cond_expr = generate_cast(cond_expr, t, bool_t);
   }
@@ -1783,8 +2043,8 @@ void generate_whilestmt(ast_t *while_stmt) {
 }
 
 type_t t_from_cdef(class_entry_t cdef) {
-  printf("Creating class type for %s\n", cdef.name);
-  LLVMTypeRef str = LLVMStructCreateNamed(gen->context, cdef.name);
+  printf("Creating class type for %s\n", symbol_name(cdef.name));
+  LLVMTypeRef str = LLVMStructCreateNamed(gen->context, symbol_name(cdef.name));
   ltypes mems = {0};
   for (size_t i = 0; i < cdef.members.count; ++i) {
     member_t m = cdef.members.items[i];
@@ -1794,7 +2054,7 @@ type_t t_from_cdef(class_entry_t cdef) {
   da_free(mems);
   type_t t = {.kind = CLASS,
               .type = str,
-              .name = strdup(cdef.name),
+              .name = cdef.name,
               .pointed_by = NULL,
               .interface = NULL,
               .ast = NULL};
@@ -1814,20 +2074,21 @@ LLVMTypeRef ftype_from_constructor(constructor_t constructor,
     da_append(&ts, type_to_llvm(t));
   }
   LLVMTypeRef ftype =
-      LLVMFunctionType(get_type_from_name("void").type, ts.items, ts.count, 0);
+      LLVMFunctionType(get_type_from_name(gen->void_name).type, ts.items,
+                       ts.count, 0);
   da_free(ts);
   return ftype;
 }
 
 LLVMValueRef declare_constructor(class_entry_t cdef, size_t i) {
   if (i > cdef.constructors.count) {
-    printf("Could not generate %s constructor %ld out of %ld\n", cdef.name, i,
-           cdef.constructors.count);
+    printf("Could not generate %s constructor %ld out of %ld\n",
+           symbol_name(cdef.name), i, cdef.constructors.count);
     EXIT;
   }
   constructor_t constructor = cdef.constructors.items[i];
   char name[1024] = {0};
-  sprintf(name, "%s_%ld", cdef.name, i);
+  sprintf(name, "%s_%ld", symbol_name(cdef.name), i);
   LLVMTypeRef ftype = ftype_from_constructor(constructor, cdef);
   LLVMValueRef fptr = LLVMAddFunction(gen->module, name, ftype);
   return fptr;
@@ -1837,7 +2098,7 @@ LLVMValueRef fptr_from_constructor(constructor_t constructor,
                                    class_entry_t cdef, size_t i) {
   (void)constructor;
   char name[1024] = {0};
-  sprintf(name, "%s_%ld", cdef.name, i);
+  sprintf(name, "%s_%ld", symbol_name(cdef.name), i);
   LLVMValueRef fptr = LLVMGetNamedFunction(gen->module, name);
   if (fptr == NULL) {
     fptr = declare_constructor(cdef, i);
@@ -1858,7 +2119,7 @@ LLVMTypeRef ftype_from_method(method_t method, class_entry_t cdef) {
   for (size_t j = 0; j < method.arg_names.count; j++) {
     type_t t = method.arg_types.items[j];
     t = get_type_used_in_class(cdef, t);
-    if (t.name == NULL) {
+    if (t.name == NO_SYMBOL) {
       t = get_type_from_name(cdef.name);
     }
     da_append(&ts, type_to_llvm(t));
@@ -1873,13 +2134,15 @@ LLVMTypeRef ftype_from_method(method_t method, class_entry_t cdef) {
 LLVMValueRef declare_method(class_entry_t cdef, method_t method) {
   LLVMTypeRef ftype = ftype_from_method(method, cdef);
   char method_name[1024] = {0};
-  sprintf(method_name, "%s_%s", cdef.name, method.name);
+  sprintf(method_name, "%s_%s", symbol_name(cdef.name),
+          symbol_name(method.name));
   return LLVMAddFunction(gen->module, method_name, ftype);
 }
 
 LLVMValueRef fptr_from_method(method_t method, class_entry_t cdef) {
   char method_name[1024] = {0};
-  sprintf(method_name, "%s_%s", cdef.name, method.name);
+  sprintf(method_name, "%s_%s", symbol_name(cdef.name),
+          symbol_name(method.name));
   LLVMValueRef fptr = LLVMGetNamedFunction(gen->module, method_name);
   if (fptr == NULL) {
     fptr = declare_method(cdef, method);
@@ -1898,21 +2161,22 @@ void push_method_params(method_t method, LLVMValueRef fptr) {
   for (size_t j = 0; j < method.arg_names.count; j++) {
     type_t t = method.arg_types.items[j];
     LLVMValueRef param = LLVMGetParam(fptr, j + 1);
-    char *name = strdup(method.arg_names.items[j]);
+    char *name = method.arg_names.items[j];
     LLVMSetValueName(param, name);
     LLVMValueRef ptr = LLVMBuildAlloca(gen->builder, type_to_llvm(t), "ptr");
     LLVMBuildStore(gen->builder, param, ptr);
-    named_value_entry_t entry = {name, t, ptr};
+    named_value_entry_t entry = {intern_cstr(name), t, ptr, 0};
     add_named_value(entry);
   }
 }
 
 void generate_method(method_t method, class_entry_t cdef, ast_t *m) {
   // LLVMTypeRef ftype = ftype_from_method(method, cdef);
-  printf("Generating method %s of class %s\n", method.name, cdef.name);
+  printf("Generating method %s of class %s\n", symbol_name(method.name),
+         symbol_name(cdef.name));
   LLVMValueRef fptr = fptr_from_method(method, cdef);
   char name[256] = {0};
-  sprintf(name, "%s_%s", cdef.name, method.name);
+  sprintf(name, "%s_%s", symbol_name(cdef.name), symbol_name(method.name));
   strings names = {0};
   types types = {0};
   da_append(&names, strdup("self"));
@@ -1933,9 +2197,10 @@ void generate_method(method_t method, class_entry_t cdef, ast_t *m) {
   gen->last_bb = bb_entry;
   LLVMValueRef self = LLVMGetParam(fptr, 0);
   named_value_entry_t self_entry = {
-      strdup("self"),
+      intern_cstr("self"),
       get_ptr_of(get_type_from_name(cdef.name)),
       self,
+      0,
   };
   int scope = get_named_values_scope(1);
   gen->current_function_scope = scope;
@@ -1945,8 +2210,7 @@ void generate_method(method_t method, class_entry_t cdef, ast_t *m) {
   reset_named_values_to_scope(scope);
 
   if (LLVMGetBasicBlockTerminator(gen->last_bb) == NULL) {
-    if (method.return_type.name &&
-        strcmp(method.return_type.name, "void") == 0) {
+    if (method.return_type.name == gen->void_name) {
       LLVMBuildRetVoid(gen->builder);
     } else {
       LLVMBuildUnreachable(gen->builder);
@@ -1966,23 +2230,24 @@ void push_constructor_params(constructor_t c, LLVMValueRef fptr) {
   for (size_t j = 0; j < c.arg_names.count; j++) {
     type_t t = c.arg_types.items[j];
     LLVMValueRef param = LLVMGetParam(fptr, j + 1);
-    char *name = strdup(c.arg_names.items[j]);
+    char *name = c.arg_names.items[j];
     LLVMSetValueName(param, name);
     LLVMValueRef ptr = LLVMBuildAlloca(gen->builder, type_to_llvm(t), "ptr");
     LLVMBuildStore(gen->builder, param, ptr);
-    named_value_entry_t entry = {name, t, ptr};
+    named_value_entry_t entry = {intern_cstr(name), t, ptr, 0};
     add_named_value(entry);
   }
 }
 
 void generate_constructor(constructor_t c, class_entry_t cdef, int index,
                           ast_t *body) {
-  printf("Generating constructor %d for class %s\n", index, cdef.name);
+  printf("Generating constructor %d for class %s\n", index,
+         symbol_name(cdef.name));
   // LLVMTypeRef ftype = ftype_from_constructor(c, cdef);
   LLVMValueRef fptr = fptr_from_constructor(c, cdef, index);
 
   char name[256] = {0};
-  sprintf(name, "%s_%d", cdef.name, index);
+  sprintf(name, "%s_%d", symbol_name(cdef.name), index);
   strings names = {0};
   types types = {0};
   da_append(&names, strdup("self"));
@@ -1993,7 +2258,7 @@ void generate_constructor(constructor_t c, class_entry_t cdef, int index,
     da_append(&names, c.arg_names.items[j]);
   }
   function_entry_t func = {strdup(name), names, types,
-                           get_type_from_name("void"), 0};
+                           get_type_from_name(gen->void_name), 0};
   if (gen->current_function == NULL) {
     gen->current_function = malloc(sizeof(function_entry_t));
   }
@@ -2006,9 +2271,10 @@ void generate_constructor(constructor_t c, class_entry_t cdef, int index,
   LLVMValueRef self = LLVMGetParam(fptr, 0);
   LLVMSetValueName(self, "self");
   named_value_entry_t self_entry = {
-      strdup("self"),
+      intern_cstr("self"),
       get_ptr_of(get_type_from_name(cdef.name)),
       self,
+      0,
   };
   int scope = get_named_values_scope(0);
   gen->current_function_scope = scope;
@@ -2024,7 +2290,7 @@ void generate_constructor(constructor_t c, class_entry_t cdef, int index,
 void generate_classdef_for_include(ast_t *classdef) {
   if (classdef->as.clazz.temp != NULL) {
     template_t temp = {
-        sv_to_cstr(classdef->as.clazz.name.lexeme),
+        sv_to_cstr(token_lexeme(classdef->as.clazz.name)),
         classdef,
     };
     da_append(&gen->templates, temp);
@@ -2043,7 +2309,7 @@ class_entry_t temp_entry(ast_t *class_ast) {
   strings interfaces_names = {0};
   ast_t *ast = NULL;
 
-  char *name = sv_to_cstr(cdef.name.lexeme);
+  symbol_t name = intern(token_lexeme(cdef.name));
 
   bool templated = false;
 
@@ -2058,10 +2324,10 @@ class_entry_t temp_entry(ast_t *class_ast) {
     }
     ast_member_t m = field->as.member;
     specifier_t spec =
-        sv_eq(m.specifier.lexeme, SV("public")) ? PUBLIC : PRIVATE;
+        sv_eq(token_lexeme(m.specifier), SV("public")) ? PUBLIC : PRIVATE;
     type_t type = get_type_from_ast(m.var->as.vardef.type);
     ast_t *init = m.var->as.vardef.value;
-    char *name = sv_to_cstr(m.var->as.vardef.name.lexeme);
+    char *name = sv_to_cstr(token_lexeme(m.var->as.vardef.name));
     member_t entry = {name, spec, type, init};
     da_append(&members, entry);
   }
@@ -2078,16 +2344,18 @@ type_t add_class_templated(ast_t *classdef) {
 
   types ts = {0};
   for (size_t i = 0; i < cdef.interfaces_names.count; ++i) {
-    type_t t = get_type_from_name(cdef.interfaces_names.items[i]);
+    symbol_t t_name = intern_cstr(cdef.interfaces_names.items[i]);
+    type_t t = get_type_from_name(t_name);
     t = sanitize_type(t);
     da_append(&ts, t);
   }
-  int inst_id = get_class_instance_index(cdef.name, ts);
+  int inst_id = get_class_instance_index(symbol_name(cdef.name), ts);
 
   if (inst_id < 0) {
     inst_id = 0;
     for (size_t i = 0; i < gen->inst_classes.count; ++i) {
-      if (strcmp(cdef.name, gen->inst_classes.items[i].class_name) == 0) {
+      const char *class_name = gen->inst_classes.items[i].class_name;
+      if (strcmp(symbol_name(cdef.name), class_name) == 0) {
         inst_id++;
       }
     }
@@ -2095,13 +2363,14 @@ type_t add_class_templated(ast_t *classdef) {
 
   char new_name[256] = {0};
 
-  sprintf(new_name, "%sZ%d", cdef.name, inst_id);
+  sprintf(new_name, "%sZ%d", symbol_name(cdef.name), inst_id);
 
-  if (does_type_exist(new_name)) {
-    return get_type_from_name(new_name);
+  symbol_t inst_name = intern_cstr(new_name);
+  if (does_type_exist(inst_name)) {
+    return get_type_from_name(inst_name);
   }
 
-  cdef.name = strdup(new_name);
+  cdef.name = inst_name;
   type_t class_type = t_from_cdef(cdef);
   add_class(cdef);
   add_type(class_type);
@@ -2114,15 +2383,16 @@ void generate_classdef(ast_t *classdef) {
   if (cdef.is_templated) {
     types ts = {0};
     for (size_t i = 0; i < cdef.interfaces_names.count; ++i) {
-      type_t t = get_type_from_name(cdef.interfaces_names.items[i]);
+      symbol_t t_name = intern_cstr(cdef.interfaces_names.items[i]);
+      type_t t = get_type_from_name(t_name);
       t = sanitize_type(t);
       da_append(&ts, t);
     }
-    int inst_id = get_class_instance_index(cdef.name, ts);
+    int inst_id = get_class_instance_index(symbol_name(cdef.name), ts);
     da_free(ts);
     char new_name[128] = {0};
-    sprintf(new_name, "%sZ%d", cdef.name, inst_id);
-    cdef.name = strdup(new_name);
+    sprintf(new_name, "%sZ%d", symbol_name(cdef.name), inst_id);
+    cdef.name = intern_cstr(new_name);
     declare_constructors(cdef);
     declare_methods(cdef);
   }
@@ -2213,14 +2483,13 @@ type_t dereference_type(type_t t) {
 
 LLVMValueRef get_lm_pointer(ast_t *lm) {
   if (lm->kind == AST_IDENTIFIER) {
-    char *name = sv_to_cstr(lm->as.identifier.tok.lexeme);
+    symbol_t name = intern(token_lexeme(lm->as.identifier.tok));
     int index = get_named_value(name);
     if (index < 0) {
-      printf("Identifier '%s' not declared in the current scope 1 (%d)\n", name,
-             index);
+      printf("Identifier '%s' not declared in the current scope 1 (%d)\n",
+             symbol_name(name), index);
       EXIT;
     }
-    free(name);
     return gen->named_values.items[index].value;
   }
   if (lm->kind == AST_BINOP) {
@@ -2243,7 +2512,8 @@ LLVMValueRef get_lm_pointer(ast_t *lm) {
         printf("\n");
         EXIT;
       }
-      char *field_name = sv_to_cstr(lm->as.binop.rhs->as.identifier.tok.lexeme);
+      char *field_name =
+          sv_to_cstr(token_lexeme(lm->as.binop.rhs->as.identifier.tok));
       int index = get_index_of_field(field_name, cdef);
       LLVMValueRef res =
           LLVMBuildStructGEP2(gen->builder, base_type.type, base, index, "");
@@ -2256,7 +2526,7 @@ LLVMValueRef get_lm_pointer(ast_t *lm) {
       int index = get_binop_method_index(lm->as.binop.op.kind, cdef);
       if (index < 0) {
         printf("No method for '" SF "' binop in class %s\n",
-               SA(lm->as.binop.op.lexeme), lt.name);
+               SA(token_lexeme(lm->as.binop.op)), symbol_name(lt.name));
         EXIT;
       }
       LLVMValueRef current_ptr = gen->current_ptr;
@@ -2372,7 +2642,7 @@ void generate_assign(ast_t *assign) {
 bool is_integer_type(type_t t) {
   if (t.kind != BUILTIN)
     return false;
-  return strcmp(t.name, "void") != 0;
+  return t.name != gen->void_name;
 }
 
 char *get_real_class_name(const char *n) {
@@ -2396,16 +2666,17 @@ type_t get_type_used_in_class(class_entry_t cdef, type_t t) {
   int arg_index = -1;
   for (size_t j = 0; j < cdef.interfaces_names.count; ++j) {
     char *name = cdef.interfaces_names.items[j];
-    if (strcmp(name, t.name) == 0) {
+    if (strcmp(name, symbol_name(t.name)) == 0) {
       arg_index = j;
       break;
     }
   }
   // We are at the right index
   // We look for this instance entry
-  char *real_name = get_real_class_name(cdef.name);
+  const char *class_name = symbol_name(cdef.name);
+  char *real_name = get_real_class_name(class_name);
   char *end;
-  const char *numptr = cdef.name + strlen(real_name) + 1;
+  const char *numptr = class_name + strlen(real_name) + 1;
   int instance_index = strtol(numptr, &end, 10);
 
   if (instance_index >= (int)gen->inst_classes.count || end == numptr) {
@@ -2420,7 +2691,7 @@ type_t get_type_used_in_class(class_entry_t cdef, type_t t) {
       }
     }
   }
-  printf("Internal error: class %s is not yed instanciated !\n", cdef.name);
+  printf("Internal error: class %s is not yed instanciated !\n", class_name);
   EXIT;
   // inst_templ_class_t instance = gen->inst_classes.items[instance_index];
 }
@@ -2445,14 +2716,23 @@ bool are_types_equal(type_t a, type_t b) {
   if (a.kind != b.kind)
     return false;
   if (a.kind == PTR) {
+    // Sanitized pointees are canonical nodes, so the same pointee is the same
+    // type, but for the kinds that are equal to no type.
+    if (a.pointed_by == b.pointed_by) {
+      type_t pointee = a;
+      while (pointee.kind == PTR)
+        pointee = *pointee.pointed_by;
+      return pointee.kind == BUILTIN || pointee.kind == CLASS ||
+             pointee.kind == TEMPLATED;
+    }
     return are_types_equal(dereference_type(a), dereference_type(b));
   }
   if (a.kind == BUILTIN) {
-    return LLVMSizeOf(a.type) == LLVMSizeOf(b.type);
+    return a.type == b.type || LLVMSizeOf(a.type) == LLVMSizeOf(b.type);
   }
   // TODO: add instantiated class type entry maybe ?
   if (a.kind == CLASS || a.kind == TEMPLATED) {
-    return strcmp(a.name, b.name) == 0;
+    return a.name == b.name;
   }
   return false;
 }
@@ -2485,12 +2765,13 @@ LLVMValueRef generate_cast_no_check(LLVMValueRef value, type_t original_type,
   }
 
   if (LLVMGetTypeKind(LLVMTypeOf(value)) == LLVMFloatTypeKind &&
-      strcmp(target_type.name, "void") && strcmp(target_type.name, "float")) {
+      target_type.name != gen->void_name &&
+      target_type.name != gen->float_name) {
     // float -> int
     return LLVMBuildFPToSI(gen->builder, value, target_type.type, "");
   }
 
-  if (target_type.type == get_type_from_name("bool").type) {
+  if (target_type.type == get_type_from_name(gen->bool_name).type) {
     return LLVMBuildICmp(gen->builder, LLVMIntNE, value,
                          LLVMConstInt(LLVMTypeOf(value), 0, 0), "");
   }
@@ -2500,7 +2781,7 @@ LLVMValueRef generate_cast_no_check(LLVMValueRef value, type_t original_type,
   } else if (is_integer_type(target_type)) {
     if (LLVMGetTypeKind(LLVMTypeOf(value)) == LLVMPointerTypeKind) {
       value = LLVMBuildPtrToInt(gen->builder, value,
-                                get_type_from_name("int").type, "");
+                                get_type_from_name(gen->int_name).type, "");
     }
     value = LLVMBuildIntCast2(gen->builder, value, llvm_target_type, 1, "");
     printf("IS THIS THE CULPRIT ????\n");
@@ -2572,7 +2853,7 @@ void generate_return(ast_t *ret) {
   type_t target_type = gen->current_function->return_type;
   LLVMTypeRef llvm_target_type = type_to_llvm(target_type);
   if (ret->as.return_stmt.expr == NULL) {
-    if (llvm_target_type != get_type_from_name("void").type) {
+    if (llvm_target_type != get_type_from_name(gen->void_name).type) {
       printf("Cannot return void from a function that returns ");
       fflush(stdout);
       LLVMDumpType(llvm_target_type);
@@ -2608,7 +2889,8 @@ LLVMValueRef generate_default_value_for_type(type_t t) {
   class_entry_t c = get_class_by_name(t.name);
   int default_constructor_index = get_default_constructor(c);
   if (default_constructor_index < 0) {
-    printf("Error: No default constructor found for class %s.\n", c.name);
+    printf("Error: No default constructor found for class %s.\n",
+           symbol_name(c.name));
     EXIT;
   }
   LLVMValueRef ptr;
@@ -2646,18 +2928,19 @@ void generate_vardef(ast_t *vardef) {
     if (!are_types_equal(expr_t, type)) {
       expr = generate_cast(expr, expr_t, type);
     }
-    char *name = sv_to_cstr(vardef->as.vardef.name.lexeme);
+    char *name = sv_to_cstr(token_lexeme(vardef->as.vardef.name));
 
     LLVMBuildStore(gen->builder, expr, ptr);
     LLVMSetValueName(expr, name);
     free(name);
   }
-  char *name = sv_to_cstr(vardef->as.vardef.name.lexeme);
+  symbol_t name = intern(token_lexeme(vardef->as.vardef.name));
 
   named_value_entry_t entry = {
       name,
       type,
       ptr,
+      0,
   };
   add_named_value(entry);
   gen->current_ptr = current_ptr;
@@ -2669,21 +2952,19 @@ void generate_ct_cte(ast_t *ct_cte) {
   EXIT;
 }
 
-bool does_type_exist(const char *name) {
-  for (size_t i = 0; i < gen->types.count; i++) {
-    if (gen->types.items[i].name == NULL) {
-      continue;
-    }
-    if (strcmp(gen->types.items[i].name, name) == 0) {
-      return true;
-    }
+bool does_type_exist(symbol_t name) {
+  index_types();
+  size_t i = symbol_index_newest(&gen->type_names, name_key(name));
+  // Incomplete types do not count
+  while (i != SYMBOL_NONE && gen->types.items[i].name == NO_SYMBOL) {
+    i = symbol_index_older(&gen->type_names, i);
   }
-  return false;
+  return i != SYMBOL_NONE;
 }
 
-int does_method_exist(class_entry_t c, char *name) {
+int does_method_exist(class_entry_t c, symbol_t name) {
   for (size_t i = 0; i < c.methods.count; i++) {
-    if (strcmp(c.methods.items[i].name, name) == 0) {
+    if (c.methods.items[i].name == name) {
       return i;
     }
   }
@@ -2699,7 +2980,7 @@ class_entry_t entry_from_cdef(ast_class_t cdef) {
   strings interfaces_names = {0};
   ast_t *ast = NULL;
 
-  char *name = sv_to_cstr(cdef.name.lexeme);
+  symbol_t name = intern(token_lexeme(cdef.name));
 
   bool templated = false;
 
@@ -2713,15 +2994,17 @@ class_entry_t entry_from_cdef(ast_class_t cdef) {
     ast_template_t temp = cdef.temp->as.temp;
     for (size_t i = 0; i < temp.count; ++i) {
       ast_tempelem_t t = temp.tempelems[i]->as.tempelem;
-      char *type_name = sv_to_cstr(t.type_iden->as.identifier.tok.lexeme);
-      char *int_name = sv_to_cstr(t.interface->as.identifier.tok.lexeme);
+      char *type_name =
+          sv_to_cstr(token_lexeme(t.type_iden->as.identifier.tok));
+      char *int_name = sv_to_cstr(token_lexeme(t.interface->as.identifier.tok));
       da_append(&interfaces, strdup(int_name));
       da_append(&interfaces_names, strdup(type_name));
       printf("Adding templated type\n");
       void *marker = malloc(1);
       da_append(&to_remove, marker);
-      type_t temp_type = {strdup(type_name), TEMPLATED, NULL, marker,
-                          strdup(int_name),  NULL};
+      type_t temp_type = {
+          intern_cstr(type_name), TEMPLATED, NULL, marker, strdup(int_name),
+          NULL};
       add_type(temp_type);
 
       free(type_name);
@@ -2736,10 +3019,10 @@ class_entry_t entry_from_cdef(ast_class_t cdef) {
     }
     ast_member_t m = field->as.member;
     specifier_t spec =
-        sv_eq(m.specifier.lexeme, SV("public")) ? PUBLIC : PRIVATE;
+        sv_eq(token_lexeme(m.specifier), SV("public")) ? PUBLIC : PRIVATE;
     type_t type = get_type_from_ast(m.var->as.vardef.type);
     ast_t *init = m.var->as.vardef.value;
-    char *name = sv_to_cstr(m.var->as.vardef.name.lexeme);
+    char *name = sv_to_cstr(token_lexeme(m.var->as.vardef.name));
     member_t entry = {name, spec, type, init};
     da_append(&members, entry);
   }
@@ -2758,16 +3041,17 @@ class_entry_t entry_from_cdef(ast_class_t cdef) {
     ast_t *field = cdef.fields[i];
     if (field->kind != AST_METHOD)
       continue;
-    if (sv_eq(cdef.name.lexeme, field->as.method.fdef->as.fundef.name.lexeme)) {
+    if (sv_eq(token_lexeme(cdef.name),
+              token_lexeme(field->as.method.fdef->as.fundef.name))) {
       ast_method_t m = field->as.method;
       specifier_t spec =
-          sv_eq(m.specifier.lexeme, SV("public")) ? PUBLIC : PRIVATE;
+          sv_eq(token_lexeme(m.specifier), SV("public")) ? PUBLIC : PRIVATE;
       strings arg_names = {0};
       types arg_types = {0};
       ast_fundef_t fundef = m.fdef->as.fundef;
       for (size_t j = 0; j < fundef.param_count; j++) {
         type_t type = get_type_from_ast(fundef.param_types[j]);
-        char *name = sv_to_cstr(fundef.param_names[j].lexeme);
+        char *name = sv_to_cstr(token_lexeme(fundef.param_names[j]));
         da_append(&arg_names, name);
         da_append(&arg_types, type);
       }
@@ -2775,16 +3059,16 @@ class_entry_t entry_from_cdef(ast_class_t cdef) {
       da_append(&constructors, entry);
     } else {
       ast_method_t m = field->as.method;
-      char *method_name =
-          sv_to_cstr(field->as.method.fdef->as.fundef.name.lexeme);
+      symbol_t method_name =
+          intern(token_lexeme(field->as.method.fdef->as.fundef.name));
       specifier_t spec =
-          sv_eq(m.specifier.lexeme, SV("public")) ? PUBLIC : PRIVATE;
+          sv_eq(token_lexeme(m.specifier), SV("public")) ? PUBLIC : PRIVATE;
       strings arg_names = {0};
       types arg_types = {0};
       ast_fundef_t fundef = m.fdef->as.fundef;
       for (size_t j = 0; j < fundef.param_count; j++) {
         type_t type = get_type_from_ast(fundef.param_types[j]);
-        char *name = sv_to_cstr(fundef.param_names[j].lexeme);
+        char *name = sv_to_cstr(token_lexeme(fundef.param_names[j]));
         da_append(&arg_names, name);
         da_append(&arg_types, type);
       }
@@ -2803,7 +3087,7 @@ class_entry_t entry_from_cdef(ast_class_t cdef) {
         type_t t = gen->types.items[j];
         if (t.pointed_by == to_remove.items[i]) {
           free(to_remove.items[j]);
-          da_remove(&gen->types, j);
+          remove_type(j);
           break;
         }
       }
@@ -0,0 +1,396 @@
+/**
+ * incremental.c
+ * Copyright (C) 2024 Paul Passeron
+ * INCREMENTAL source file
+ * Paul Passeron <paul.passeron2@gmail.com>
+ */
+
+#include "../include/incremental.h"
+#include "../include/ast_cache.h"
+#include "../include/dynarr.h"
+#include "../include/flat_ast.h"
+#include "../include/parser.h"
+#include "../include/unilang_parser.h"
+#include <fcntl.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+incremental_stats_t incremental_stats = {0};
+
+#define INCREMENTAL_MAGIC "ULINCR"
+
+// A state file is this header, the source (padded to 8 bytes), its tokens,
+// its top-level declarations, and the nodes and the lists of its flat AST.
+typedef struct incremental_header_t {
+  char magic[8];
+  uint32_t version;
+  uint32_t node_size;
+  uint64_t source_length;
+  uint32_t token_count;
+  uint32_t decl_count;
+  uint32_t node_count;
+  uint32_t list_count;
+  flat_id_t root; // its list holds the declarations
+  uint16_t file;  // source id in the tokens of the nodes
+  uint16_t padding;
+  uint64_t checksum; // ast_cache_hash() of everything after the header
+} incremental_header_t;
+
+// Token indices of a top-level declaration. It can be reused as long as the
+// tokens from first to lookahead are the same.
+typedef struct incremental_decl_t {
+  uint32_t first;
+  uint32_t end;       // where parsing it stopped
+  uint32_t lookahead; // one past the furthest token looked at
+} incremental_decl_t;
+
+typedef struct incremental_decls_t {
+  incremental_decl_t *items;
+  size_t count;
+  size_t capacity;
+} incremental_decls_t;
+
+typedef struct program_decls_t {
+  ast_t **items;
+  size_t count;
+  size_t capacity;
+} program_decls_t;
+
+// The last incremental parse of a file, mapped from its state file. Empty if
+// there is none.
+typedef struct incremental_state_t {
+  void *map;
+  size_t size;
+  incremental_header_t *header;
+  string_view_t source;
+  token_t *tokens;
+  size_t token_count;
+  incremental_decl_t *decls;
+  size_t decl_count;
+  flat_ast_t flat;
+} incremental_state_t;
+
+size_t align8(size_t n) { return (n + 7) & ~(size_t)7; }
+
+bool incremental_path(char *path, size_t size, const char *filename) {
+  char dir[PATH_MAX];
+  char full[PATH_MAX];
+  if (!create_ast_cache_dir(dir, sizeof(dir)))
+    return false;
+  if (realpath(filename, full) == NULL)
+    return false;
+  uint64_t hash = ast_cache_hash((string_view_t){full, strlen(full)});
+  int n = snprintf(path, size, "%s/%016llx.inc", dir, (unsigned long long)hash);
+  return n > 0 && (size_t)n < size;
+}
+
+size_t state_size(incremental_header_t *h) {
+  return sizeof(incremental_header_t) + align8(h->source_length) +
+         (size_t)h->token_count * sizeof(token_t) +
+         (size_t)h->decl_count * sizeof(incremental_decl_t) +
+         (size_t)h->node_count * sizeof(flat_node_t) +
+         (size_t)h->list_count * sizeof(flat_id_t);
+}
+
+bool valid_state(incremental_state_t *s) {
+  incremental_header_t *h = s->header;
+  if (s->size < sizeof(incremental_header_t))
+    return false;
+  if (memcmp(h->magic, INCREMENTAL_MAGIC, sizeof(INCREMENTAL_MAGIC)) != 0 ||
+      h->version != AST_CACHE_VERSION || h->node_size != sizeof(flat_node_t) ||
+      s->size != state_size(h))
+    return false;
+  string_view_t payload = {(char *)(h + 1),
+                           s->size - sizeof(incremental_header_t)};
+  if (ast_cache_hash(payload) != h->checksum ||
+      !valid_flat_ast(&s->flat, h->root, h->source_length))
+    return false;
+  for (size_t i = 0; i < h->token_count; i++) {
+    if ((uint64_t)s->tokens[i].offset + s->tokens[i].length > h->source_length)
+      return false;
+  }
+  flat_node_t *root = flat_node(&s->flat, h->root);
+  if (root->count != h->decl_count ||
+      root->first + (size_t)root->count > h->list_count)
+    return false;
+  for (size_t i = 0; i < h->decl_count; i++) {
+    incremental_decl_t d = s->decls[i];
+    if (d.first > d.end || d.end > d.lookahead ||
+        d.lookahead > h->token_count + 1 ||
+        flat_list_at(&s->flat, root, i) >= h->node_count)
+      return false;
+  }
+  return true;
+}
+
+// Leaves s empty if the file has no valid state.
+void load_incremental_state(incremental_state_t *s, const char *path) {
+  *s = (incremental_state_t){0};
+  int fd = open(path, O_RDONLY);
+  if (fd < 0)
+    return;
+  struct stat st;
+  if (fstat(fd, &st) < 0 || st.st_size == 0) {
+    close(fd);
+    return;
+  }
+  // Private and writable, for reused declarations to be moved in place.
+  void *p = mmap(NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (p == MAP_FAILED)
+    return;
+  incremental_header_t *h = p;
+  char *source = (char *)(h + 1);
+  token_t *tokens = NULL;
+  incremental_decl_t *decls = NULL;
+  flat_node_t *nodes = NULL;
+  flat_id_t *lists = NULL;
+  if ((size_t)st.st_size >= sizeof(incremental_header_t) &&
+      (size_t)st.st_size == state_size(h)) {
+    tokens = (token_t *)(source + align8(h->source_length));
+    decls = (incremental_decl_t *)(tokens + h->token_count);
+    nodes = (flat_node_t *)(decls + h->decl_count);
+    lists = (flat_id_t *)(nodes + h->node_count);
+  }
+  *s = (incremental_state_t){p,
+                             st.st_size,
+                             h,
+                             {source, h->source_length},
+                             tokens,
+                             h->token_count,
+                             decls,
+                             h->decl_count,
+                             {{nodes, h->node_count, h->node_count},
+                              {lists, h->list_count, h->list_count},
+                              false}};
+  if (tokens == NULL || !valid_state(s)) {
+    munmap(p, st.st_size);
+    *s = (incremental_state_t){0};
+  }
+}
+
+void free_incremental_state(incremental_state_t *s) {
+  if (s->map != NULL)
+    munmap(s->map, s->size);
+  *s = (incremental_state_t){0};
+}
+
+void save_incremental_state(const char *path, source_t *src, tokens_t *tokens,
+                            incremental_decls_t decls, ast_t *prog) {
+  flat_ast_t f = {0};
+  flat_id_t root = flatten_ast(&f, prog);
+  if (root == FLAT_NONE) {
+    free_flat_ast(&f);
+    return;
+  }
+  size_t padding = align8(src->contents.length) - src->contents.length;
+  char zeros[8] = {0};
+  uint64_t checksum = ast_cache_hash(src->contents);
+  checksum = ast_cache_hash_more(checksum, zeros, padding);
+  checksum = ast_cache_hash_more(checksum, tokens->items,
+                                 tokens->count * sizeof(token_t));
+  checksum = ast_cache_hash_more(checksum, decls.items,
+                                 decls.count * sizeof(incremental_decl_t));
+  checksum = ast_cache_hash_more(checksum, f.nodes.items,
+                                 f.nodes.count * sizeof(flat_node_t));
+  checksum = ast_cache_hash_more(checksum, f.lists.items,
+                                 f.lists.count * sizeof(flat_id_t));
+  incremental_header_t h = {INCREMENTAL_MAGIC,
+                            AST_CACHE_VERSION,
+                            sizeof(flat_node_t),
+                            src->contents.length,
+                            tokens->count,
+                            decls.count,
+                            f.nodes.count,
+                            f.lists.count,
+                            root,
+                            src->id,
+                            0,
+                            checksum};
+  // Written aside and renamed, like the entries of the AST cache.
+  char tmp[PATH_MAX + 32];
+  snprintf(tmp, sizeof(tmp), "%s.%d", path, (int)getpid());
+  FILE *file = fopen(tmp, "wb");
+  if (file != NULL) {
+    bool ok =
+        fwrite(&h, sizeof(h), 1, file) == 1 &&
+        fwrite(src->contents.contents, 1, src->contents.length, file) ==
+            src->contents.length &&
+        fwrite(zeros, 1, padding, file) == padding &&
+        fwrite(tokens->items, sizeof(token_t), tokens->count, file) ==
+            tokens->count &&
+        fwrite(decls.items, sizeof(incremental_decl_t), decls.count, file) ==
+            decls.count &&
+        fwrite(f.nodes.items, sizeof(flat_node_t), f.nodes.count, file) ==
+            f.nodes.count &&
+        fwrite(f.lists.items, sizeof(flat_id_t), f.lists.count, file) ==
+            f.lists.count;
+    if (fclose(file) != 0 || !ok || rename(tmp, path) != 0)
+      remove(tmp);
+  }
+  free_flat_ast(&f);
+}
+
+bool same_lexeme(token_t a, string_view_t a_src, token_t b,
+                 string_view_t b_src) {
+  return a.kind == b.kind && a.length == b.length &&
+         memcmp(a_src.contents + a.offset, b_src.contents + b.offset,
+                a.length) == 0;
+}
+
+// Leading tokens that did not change, nor move.
+size_t same_prefix(incremental_state_t *s, tokens_t *tokens,
+                   string_view_t src) {
+  size_t n = 0;
+  while (n < s->token_count && n < tokens->count &&
+         s->tokens[n].offset == tokens->items[n].offset &&
+         same_lexeme(s->tokens[n], s->source, tokens->items[n], src)) {
+    n++;
+  }
+  return n;
+}
+
+// Trailing tokens that did not change, and all moved by *shift bytes.
+size_t same_suffix(incremental_state_t *s, tokens_t *tokens,
+                   string_view_t src, size_t prefix, int64_t *shift) {
+  size_t max = s->token_count < tokens->count ? s->token_count : tokens->count;
+  max -= prefix;
+  if (max == 0)
+    return 0;
+  token_t *old_end = s->tokens + s->token_count;
+  token_t *new_end = tokens->items + tokens->count;
+  *shift = (int64_t)new_end[-1].offset - (int64_t)old_end[-1].offset;
+  size_t n = 0;
+  while (n < max &&
+         (int64_t)new_end[-1 - n].offset - (int64_t)old_end[-1 - n].offset ==
+             *shift &&
+         same_lexeme(old_end[-1 - n], s->source, new_end[-1 - n], src)) {
+    n++;
+  }
+  return n;
+}
+
+// Builds a declaration of the state back, its tokens moved by shift bytes
+// into a source of source_length bytes. NULL if it cannot be, in which case
+// it has to be parsed.
+ast_t *reuse_decl(incremental_state_t *s, size_t i, int64_t shift,
+                  uint16_t file, size_t source_length) {
+  flat_node_t *root = flat_node(&s->flat, s->header->root);
+  flat_id_t id = flat_list_at(&s->flat, root, i);
+  // A declaration is a run of nodes, up to the next one.
+  flat_id_t end = i + 1 < s->decl_count ? flat_list_at(&s->flat, root, i + 1)
+                                        : s->flat.nodes.count;
+  for (flat_id_t n = id; n < end; n++) {
+    token_t tok = flat_node(&s->flat, n)->tok;
+    int64_t offset = (int64_t)tok.offset + shift;
+    if (tok.file != 0 &&
+        (offset < 0 || (uint64_t)offset + tok.length > source_length))
+      return NULL;
+  }
+  for (flat_id_t n = id; n < end; n++) {
+    token_t *tok = &flat_node(&s->flat, n)->tok;
+    if (tok->file != 0) {
+      tok->offset += shift;
+      tok->file = file;
+    }
+  }
+  ast_t *decl = unflatten_ast(&s->flat, id);
+  if (decl != NULL)
+    incremental_stats.reused++;
+  return decl;
+}
+
+ast_t *parse_program_incremental(lexer_t *l, int *worked) {
+  clear_parse_diagnostics();
+  source_t *src = l->state->source;
+  tokens_t *tokens = l->state->tokens;
+  char path[PATH_MAX];
+  bool has_path = incremental_path(path, sizeof(path), src->filename);
+  incremental_state_t s = {0};
+  if (has_path)
+    load_incremental_state(&s, path);
+
+  size_t prefix = same_prefix(&s, tokens, src->contents);
+  int64_t shift = 0;
+  size_t suffix = same_suffix(&s, tokens, src->contents, prefix, &shift);
+  // Old token index + moved = new token index, in the suffix
+  int64_t moved = (int64_t)tokens->count - (int64_t)s.token_count;
+  size_t suffix_start = s.token_count - suffix;
+
+  program_decls_t decls = {0};
+  incremental_decls_t records = {0};
+  size_t pos = l->token_index;
+  size_t i = 0;
+  while (i < s.decl_count && s.decls[i].first == pos &&
+         s.decls[i].lookahead <= prefix) {
+    ast_t *decl = reuse_decl(&s, i, 0, src->id, src->contents.length);
+    if (decl == NULL)
+      break;
+    da_append(&decls, decl);
+    da_append(&records, s.decls[i]);
+    pos = s.decls[i].end;
+    i++;
+  }
+  // Same loop as the program_list rule, taking each declaration from the state
+  // when an unchanged one starts at the current position.
+  while (true) {
+    while (i < s.decl_count && (s.decls[i].first < suffix_start ||
+                                s.decls[i].first + moved < (int64_t)pos)) {
+      i++;
+    }
+    if (i < s.decl_count && s.decls[i].first + moved == (int64_t)pos &&
+        s.decls[i].lookahead <= s.token_count) {
+      incremental_decl_t d = s.decls[i];
+      ast_t *decl = reuse_decl(&s, i, shift, src->id, src->contents.length);
+      if (decl == NULL) {
+        // The state is broken: parse everything that is left.
+        s.decl_count = 0;
+        continue;
+      }
+      da_append(&decls, decl);
+      da_append(&records, ((incremental_decl_t){d.first + moved, d.end + moved,
+                                                d.lookahead + moved}));
+      pos = d.end + moved;
+      i++;
+      continue;
+    }
+    lexer_seek(l, pos);
+#ifdef PPARSER_MEMO
+    // Memoized results may come from the lookahead of another declaration,
+    // and would hide what this one looked at.
+    pparser_memo_clear();
+#endif
+    lexer_lookahead = pos;
+    int decl_worked = 0;
+    ast_t *decl = parse_decl(l, &decl_worked);
+    if (!decl_worked)
+      break;
+    size_t lookahead =
+        lexer_lookahead > l->token_index ? lexer_lookahead : l->token_index;
+    da_append(&decls, decl);
+    da_append(&records, ((incremental_decl_t){pos, l->token_index, lookahead}));
+    incremental_stats.parsed++;
+    pos = l->token_index;
+  }
+  lexer_seek(l, pos);
+
+  ast_t **elems = ast_alloc((decls.count + 1) * sizeof(ast_t *));
+  memcpy(elems, decls.items, decls.count * sizeof(ast_t *));
+  elems[decls.count] = NULL;
+  pparser_list_stats.lists++;
+  pparser_list_stats.elems += decls.count;
+  *worked = decls.count > 0;
+  ast_t *prog = new_compound(elems);
+
+  free_incremental_state(&s);
+  if (has_path)
+    save_incremental_state(path, src, tokens, records, prog);
+  da_free(records);
+  da_free(decls);
+  return prog;
+}
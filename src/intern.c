@@ -0,0 +1,124 @@
+/**
+ * intern.c
+ * Copyright (C) 2024 Paul Passeron
+ * INTERN source file
+ * Paul Passeron <paul.passeron2@gmail.com>
+ */
+
+#include "../include/intern.h"
+#include "../include/dynarr.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Interned bytes are packed in blocks that are never moved or freed.
+#define INTERN_BLOCK_SIZE 65536
+
+typedef struct interned_t {
+  const char *name;
+  uint32_t length;
+  uint32_t hash;
+} interned_t;
+
+typedef struct interner_t {
+  interned_t *items; // by symbol, items[NO_SYMBOL] is the empty string
+  size_t count;
+  size_t capacity;
+  symbol_t *slots; // 0 for an empty slot
+  size_t slot_count;
+  char *block;
+  size_t block_left;
+} interner_t;
+
+interner_t interner = {0};
+
+uint32_t intern_hash(string_view_t s) {
+  uint32_t h = 2166136261u;
+  for (size_t i = 0; i < s.length; i++) {
+    h = (h ^ (unsigned char)s.contents[i]) * 16777619u;
+  }
+  return h;
+}
+
+void *intern_alloc(size_t size) {
+  void *res = malloc(size);
+  if (res == NULL) {
+    perror("Allocation failed");
+    exit(1);
+  }
+  return res;
+}
+
+const char *intern_copy(string_view_t s) {
+  char *res;
+  if (s.length + 1 > INTERN_BLOCK_SIZE / 4) {
+    // Long strings get a block of their own.
+    res = intern_alloc(s.length + 1);
+  } else {
+    if (s.length + 1 > interner.block_left) {
+      interner.block = intern_alloc(INTERN_BLOCK_SIZE);
+      interner.block_left = INTERN_BLOCK_SIZE;
+    }
+    res = interner.block;
+    interner.block += s.length + 1;
+    interner.block_left -= s.length + 1;
+  }
+  memcpy(res, s.contents, s.length);
+  res[s.length] = 0;
+  return res;
+}
+
+void intern_rehash(void) {
+  free(interner.slots);
+  interner.slot_count =
+      interner.slot_count == 0 ? 1024 : interner.slot_count * 2;
+  interner.slots = calloc(interner.slot_count, sizeof(symbol_t));
+  if (interner.slots == NULL) {
+    perror("Allocation failed");
+    exit(1);
+  }
+  size_t mask = interner.slot_count - 1;
+  for (size_t sym = 1; sym < interner.count; sym++) {
+    size_t i = interner.items[sym].hash & mask;
+    while (interner.slots[i] != 0)
+      i = (i + 1) & mask;
+    interner.slots[i] = sym;
+  }
+}
+
+symbol_t intern(string_view_t s) {
+  if (s.length == 0)
+    return NO_SYMBOL;
+  if (interner.count == 0) {
+    interned_t empty = {"", 0, 0};
+    da_append(&interner, empty);
+  }
+  if (2 * interner.count >= interner.slot_count)
+    intern_rehash();
+  uint32_t hash = intern_hash(s);
+  size_t mask = interner.slot_count - 1;
+  size_t i = hash & mask;
+  for (symbol_t sym; (sym = interner.slots[i]) != 0; i = (i + 1) & mask) {
+    interned_t e = interner.items[sym];
+    if (e.hash == hash && e.length == s.length &&
+        memcmp(e.name, s.contents, s.length) == 0)
+      return sym;
+  }
+  symbol_t sym = interner.count;
+  interned_t entry = {intern_copy(s), s.length, hash};
+  da_append(&interner, entry);
+  interner.slots[i] = sym;
+  return sym;
+}
+
+symbol_t intern_cstr(const char *s) {
+  return intern((string_view_t){(char *)s, strlen(s)});
+}
+
+const char *symbol_name(symbol_t sym) {
+  return sym == NO_SYMBOL ? "" : interner.items[sym].name;
+}
+
+size_t symbol_count(void) {
+  return interner.count == 0 ? 1 : interner.count;
+}
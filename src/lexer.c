@@ -6,93 +6,131 @@
  */
 
 #include "../include/lexer.h"
+#include "../include/dynarr.h"
+#include "../include/lexer_dfa.h"
 #include "../include/regexp.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
+_Thread_local lexer_stats_t lexer_stats = {0};
+_Thread_local size_t lexer_lookahead = 0;
+
+void location_line_col(location_t loc, int *line, int *col) {
+  if (loc.source == NULL) {
+    *line = 0;
+    *col = 0;
+    return;
+  }
+  source_line_col(loc.source, loc.offset, line, col);
+}
+
+const char *location_filename(location_t loc) {
+  return loc.source == NULL ? NULL : loc.source->filename;
+}
+
 void print_location_t(FILE *f, location_t loc) {
-  fprintf(f, "%s:%d:%d: %s", loc.filename, loc.line, loc.col,
+  int line, col;
+  location_line_col(loc, &line, &col);
+  fprintf(f, "%s:%d:%d: %s", location_filename(loc), line, col,
           loc.is_expanded ? "[IN MACRO EXPANSION] " : "");
 }
 
-void append_rule(lexer_t *l, lexer_rule_t rule) {
-  if (l->rules.count >= l->rules.size) {
-    lexer_rule_t *new_rules = malloc(sizeof(lexer_rule_t) * l->rules.size * 2);
-    for (size_t i = 0; i < l->rules.count; i++) {
-      new_rules[i] = l->rules.data[i];
+void append_rule(lexer_rules_t *rules, lexer_rule_t rule) {
+  if (rules->count >= rules->size) {
+    lexer_rule_t *new_rules = malloc(sizeof(lexer_rule_t) * rules->size * 2);
+    for (size_t i = 0; i < rules->count; i++) {
+      new_rules[i] = rules->data[i];
     }
-    free(l->rules.data);
-    l->rules.data = new_rules;
+    free(rules->data);
+    rules->data = new_rules;
+    rules->size *= 2;
   }
-  l->rules.data[l->rules.count++] = rule;
+  rules->data[rules->count++] = rule;
+  free_lexer_dfa(rules->dfa);
+  rules->dfa = NULL;
 }
 
-void add_rule_to_lexer(lexer_t *l, string_view_t regexp, int value) {
+void add_lexer_rule(lexer_rules_t *rules, string_view_t regexp, int value) {
   lexer_rule_t res;
   res.regexp = regexp;
   res.kind = GOOD;
   res.as.good = value;
-  append_rule(l, res);
+  append_rule(rules, res);
 }
 
-void add_bad_rule_to_lexer(lexer_t *l, string_view_t regexp,
-                           string_view_t error) {
+void add_bad_lexer_rule(lexer_rules_t *rules, string_view_t regexp,
+                        string_view_t error) {
   lexer_rule_t res;
   res.regexp = regexp;
   res.kind = BAD;
   res.as.error = error;
-  append_rule(l, res);
+  append_rule(rules, res);
 }
 
-void add_skip_rule_to_lexer(lexer_t *l, string_view_t regexp) {
+void add_skip_lexer_rule(lexer_rules_t *rules, string_view_t regexp) {
   lexer_rule_t res = {regexp, SKIP, {0}};
-  append_rule(l, res);
+  append_rule(rules, res);
 }
 
-bool is_done(lexer_t *l) { return l->remaining.length == 0; }
+void set_rules_classifier(lexer_rules_t *rules, token_classifier_t classify) {
+  rules->classify = classify;
+}
 
-void update_pos(lexer_t *l, int n) {
-  if (n < 0)
-    return;
-  l->eaten += n;
-  for (size_t i = 0; i < (size_t)n && i < l->remaining.length; i++) {
-    char c = l->remaining.contents[i];
-    switch (c) {
-    case '\n': {
-      l->current_loc.line++;
-      l->current_loc.col = 1;
-    } break;
-    default: {
-      l->current_loc.col++;
-    } break;
-    }
-  }
+void compile_rules(lexer_rules_t *rules) {
+  if (rules->dfa == NULL)
+    rules->dfa = compile_lexer_dfa(*rules);
+}
+
+lexer_t new_lexer(lexer_rules_t *rules) {
+  compile_rules(rules);
+  lexer_state_t *state = malloc(sizeof(lexer_state_t));
+  *state = (lexer_state_t){rules, NULL, NULL};
+  return (lexer_t){state, 0, 0};
 }
 
+void set_lexer_source(lexer_t *l, source_t *src) {
+  l->state->source = src;
+  l->state->tokens = NULL;
+  l->offset = 0;
+  l->token_index = 0;
+}
+
+location_t lexer_location(lexer_t *l) {
+  return (location_t){l->state->source, l->offset, false};
+}
+
+string_view_t lexer_remaining(lexer_t *l) {
+  string_view_t contents = l->state->source->contents;
+  return (string_view_t){contents.contents + l->offset,
+                         contents.length - l->offset};
+}
+
+bool is_done(lexer_t *l) {
+  return l->offset == l->state->source->contents.length;
+}
+
+void eat(lexer_t *l, size_t n) { l->offset += n; }
+
 void lexer_skip(lexer_t *l) {
-  while (true) {
-    if (is_done(l))
-      break;
-    bool could_skip = false;
-    for (size_t i = 0; i < l->rules.count; i++) {
-      lexer_rule_t rule = l->rules.data[i];
-      if (rule.kind != SKIP)
-        continue;
-      string_view_t nr;
-      if (sv_matches_exact(rule.regexp, l->remaining, &nr)) {
-        update_pos(l, l->remaining.length - nr.length);
-        l->remaining = nr;
-        could_skip = true;
-        break;
-      }
+  const lexer_rules_t *rules = l->state->rules;
+  while (!is_done(l)) {
+    size_t blanks = lexer_dfa_skip_blanks(rules->dfa, lexer_remaining(l));
+    if (blanks > 0) {
+      eat(l, blanks);
+      continue;
     }
-    if (!could_skip)
+    size_t len;
+    int i = lexer_dfa_match(rules->dfa, lexer_remaining(l), &len);
+    if (i < 0 || rules->data[i].kind != SKIP)
       break;
+    eat(l, len);
   }
 }
 
 bool is_next(lexer_t *l) {
+  if (l->state->tokens != NULL && l->token_index < l->state->tokens->count)
+    return false;
   if (is_done(l))
     return true;
   lexer_t cpy = *l;
@@ -102,7 +140,9 @@ bool is_next(lexer_t *l) {
 
 string_view_t location_to_sv(location_t loc) {
   char res[1024] = {0};
-  sprintf(res, "%s:%d:%d", loc.filename, loc.line, loc.col);
+  int line, col;
+  location_line_col(loc, &line, &col);
+  sprintf(res, "%s:%d:%d", location_filename(loc), line, col);
   string_view_t r = {0};
   int l = strlen(res);
   r.length = l;
@@ -114,12 +154,13 @@ string_view_t location_to_sv(location_t loc) {
 }
 
 void print_error(FILE *f, lexer_t *l, string_view_t error_message) {
-  int until_end_of_line = length_until(l->remaining, '\n');
+  string_view_t remaining = lexer_remaining(l);
+  int until_end_of_line = length_until(remaining, '\n');
   if (until_end_of_line < 0)
-    until_end_of_line = l->remaining.length;
-  string_view_t loc = location_to_sv(l->current_loc);
+    until_end_of_line = remaining.length;
+  string_view_t loc = location_to_sv(lexer_location(l));
   fprintf(f, SF " " SF ": %.*s\n", SA(loc), SA(error_message),
-          until_end_of_line, l->remaining.contents);
+          until_end_of_line, remaining.contents);
   free(loc.contents);
   int space_len = error_message.length + loc.length + 3;
   for (int i = 0; i < space_len; i++) {
@@ -131,42 +172,101 @@ void print_error(FILE *f, lexer_t *l, string_view_t error_message) {
   fprintf(f, "\n");
 }
 
-token_t error_token() { return (token_t){{0}, {0}, -1}; }
+token_t error_token() { return (token_t){0, 0, -1, 0}; }
+
+string_view_t token_lexeme(token_t tok) {
+  source_t *src = get_source(tok.file);
+  if (src == NULL)
+    return (string_view_t){0};
+  return (string_view_t){src->contents.contents + tok.offset, tok.length};
+}
+
+location_t token_location(token_t tok) {
+  return (location_t){get_source(tok.file), tok.offset, false};
+}
+
+// Token for the next len bytes of the input.
+token_t scanned_token(lexer_t *l, size_t len, int kind) {
+  token_t tok = {l->offset, len, kind, l->state->source->id};
+  token_classifier_t classify = l->state->rules->classify;
+  if (classify != NULL)
+    tok.kind = classify(
+        (string_view_t){l->state->source->contents.contents + l->offset, len},
+        kind);
+  return tok;
+}
+
+// Moves the lexer right after a buffered token, exactly as if it had been
+// scanned.
+void move_past(lexer_t *l, token_t tok) {
+  l->offset = tok.offset + tok.length;
+}
+
+token_t next_buffered(lexer_t *l) {
+  token_t tok = l->state->tokens->items[l->token_index++];
+  move_past(l, tok);
+  lexer_stats.read++;
+  if (l->token_index > lexer_lookahead)
+    lexer_lookahead = l->token_index;
+  return tok;
+}
+
+void lexer_seek(lexer_t *l, size_t token_index) {
+  if (token_index <= l->token_index)
+    return;
+  l->token_index = token_index;
+  move_past(l, l->state->tokens->items[token_index - 1]);
+}
 
 token_t next(lexer_t *l) {
+  if (l->state->tokens != NULL && l->token_index < l->state->tokens->count)
+    return next_buffered(l);
+  if (l->state->tokens != NULL)
+    lexer_lookahead = l->state->tokens->count + 1;
   lexer_skip(l);
-  location_t tmp = l->current_loc;
-  for (size_t i = 0; i < l->rules.count; i++) {
-    lexer_rule_t rule = l->rules.data[i];
-    if (rule.kind == SKIP)
-      continue;
-    string_view_t sv;
-    bool res = sv_matches_exact(rule.regexp, l->remaining, &sv);
-    if (!res)
-      continue;
-    if (rule.kind == GOOD) {
-      int len = l->remaining.length - sv.length;
-      token_t tok = {tmp, {l->remaining.contents, len}, rule.as.good};
-      update_pos(l, len);
-      l->remaining = sv;
-      return tok;
-    }
+  const lexer_rules_t *rules = l->state->rules;
+  size_t len;
+  int i = lexer_dfa_match(rules->dfa, lexer_remaining(l), &len);
+  if (i < 0)
+    return error_token();
+  lexer_rule_t rule = rules->data[i];
+  if (rule.kind == BAD) {
     print_error(stderr, l, rule.as.error);
     return error_token();
   }
-  for (size_t i = 0; i < l->rules.size; i++) {
-    lexer_rule_t rule = l->rules.data[i];
-    if (rule.kind != BAD)
-      continue;
+  token_t tok = scanned_token(l, len, rule.as.good);
+  eat(l, len);
+  lexer_stats.scanned++;
+  lexer_stats.read++;
+  return tok;
+}
+
+void tokenize(lexer_t *l) {
+  lexer_t cpy = *l;
+  const lexer_rules_t *rules = l->state->rules;
+  tokens_t *tokens = malloc(sizeof(tokens_t));
+  *tokens = (tokens_t){0};
+  while (true) {
+    lexer_skip(&cpy);
+    size_t len;
+    int i = lexer_dfa_match(rules->dfa, lexer_remaining(&cpy), &len);
+    // Errors are left to next(), that reports them if the parser gets there.
+    if (i < 0 || rules->data[i].kind != GOOD)
+      break;
+    token_t tok = scanned_token(&cpy, len, rules->data[i].as.good);
+    eat(&cpy, len);
+    da_append(tokens, tok);
+    lexer_stats.scanned++;
   }
-  return error_token();
+  l->state->tokens = tokens;
+  l->token_index = 0;
 }
 
 #define RULES_INIT 64
 
 lexer_rules_t new_rules(void) {
   return (lexer_rules_t){malloc(RULES_INIT * sizeof(lexer_rule_t)), 0,
-                         RULES_INIT};
+                         RULES_INIT, NULL, NULL};
 }
 
 bool is_error_tok(token_t tok) { return tok.kind < 0; }
@@ -174,4 +274,14 @@ bool is_error_tok(token_t tok) { return tok.kind < 0; }
 token_t peek_token(lexer_t *l) {
   lexer_t cpy = *l;
   return next(&cpy);
+}
+
+int peek_kind(lexer_t *l) {
+  tokens_t *tokens = l->state->tokens;
+  if (tokens != NULL && l->token_index < tokens->count) {
+    if (l->token_index + 1 > lexer_lookahead)
+      lexer_lookahead = l->token_index + 1;
+    return tokens->items[l->token_index].kind;
+  }
+  return peek_token(l).kind;
 }
\ No newline at end of file
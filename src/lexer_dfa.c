@@ -0,0 +1,534 @@
+/**
+ * lexer_dfa.c
+ * Copyright (C) 2024 Paul Passeron
+ * LEXER_DFA source file
+ * Paul Passeron <paul.passeron2@gmail.com>
+ */
+
+#include "../include/lexer_dfa.h"
+#include "../include/dynarr.h"
+#include "../include/lexer.h"
+#include "../include/regexp.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// The rules are first turned into a Thompson NFA (one fragment per rule, all
+// reachable from a common start), which is then determinized with the subset
+// construction. Bytes that no pattern tells apart share a column of the
+// transition table.
+
+typedef struct charset_t {
+  uint64_t bits[4];
+} charset_t;
+
+typedef struct nfa_state_t {
+  int set;   // index of the charset labelling the edge, -1 for epsilon
+  int out;   // target of the labelled edge, or first epsilon edge
+  int out1;  // second epsilon edge
+  int rule;  // rule owning this state
+  bool final;
+} nfa_state_t;
+
+typedef struct nfa_t {
+  nfa_state_t *items;
+  size_t count;
+  size_t capacity;
+} nfa_t;
+
+typedef struct charsets_t {
+  charset_t *items;
+  size_t count;
+  size_t capacity;
+} charsets_t;
+
+typedef struct nfa_frag_t {
+  int start;
+  int end; // epsilon state with no edge yet
+} nfa_frag_t;
+
+typedef struct nfa_builder_t {
+  nfa_t states;
+  charsets_t sets;
+  int rule;
+} nfa_builder_t;
+
+bool charset_has(charset_t set, unsigned char c) {
+  return (set.bits[c >> 6] >> (c & 63)) & 1;
+}
+
+void charset_add(charset_t *set, unsigned char c) {
+  set->bits[c >> 6] |= (uint64_t)1 << (c & 63);
+}
+
+int nfa_new_state(nfa_builder_t *b, int set, int out, int out1) {
+  nfa_state_t s = {set, out, out1, b->rule, false};
+  da_append(&b->states, s);
+  return b->states.count - 1;
+}
+
+int nfa_new_set(nfa_builder_t *b, charset_t set) {
+  da_append(&b->sets, set);
+  return b->sets.count - 1;
+}
+
+nfa_frag_t nfa_empty(nfa_builder_t *b) {
+  int s = nfa_new_state(b, -1, -1, -1);
+  return (nfa_frag_t){s, s};
+}
+
+nfa_frag_t nfa_set(nfa_builder_t *b, charset_t set) {
+  int end = nfa_new_state(b, -1, -1, -1);
+  int start = nfa_new_state(b, nfa_new_set(b, set), end, -1);
+  return (nfa_frag_t){start, end};
+}
+
+nfa_frag_t nfa_concat(nfa_builder_t *b, nfa_frag_t a, nfa_frag_t c) {
+  b->states.items[a.end].out = c.start;
+  return (nfa_frag_t){a.start, c.end};
+}
+
+nfa_frag_t nfa_star(nfa_builder_t *b, nfa_frag_t a) {
+  int end = nfa_new_state(b, -1, -1, -1);
+  int split = nfa_new_state(b, -1, a.start, end);
+  b->states.items[a.end].out = split;
+  return (nfa_frag_t){split, end};
+}
+
+nfa_frag_t dfa_parse_sequence(nfa_builder_t *b, string_view_t p, bool *lazy) {
+  nfa_frag_t res = nfa_empty(b);
+  size_t i = 0;
+  while (i < p.length) {
+    char c = p.contents[i];
+    charset_t set = {0};
+    nfa_frag_t f;
+    if (c == '(') {
+      size_t start = ++i;
+      while (i < p.length && p.contents[i] != ')') {
+        i++;
+      }
+      string_view_t sub = {p.contents + start, i - start};
+      i++;
+      f = nfa_star(b, dfa_parse_sequence(b, sub, lazy));
+    } else if (c == '*') {
+      i++;
+      memset(&set, 0xff, sizeof(set));
+      f = nfa_star(b, nfa_set(b, set));
+      // A trailing '*' eats the whole input, anything else is lazy.
+      if (i < p.length) {
+        *lazy = true;
+      }
+    } else if (c == '?') {
+      i++;
+      memset(&set, 0xff, sizeof(set));
+      f = nfa_set(b, set);
+    } else if (c == '[') {
+      i++;
+      regexp_class_t class = regexp_parse_class(p, &i);
+      memcpy(set.bits, class.bits, sizeof(set.bits));
+      f = nfa_set(b, set);
+    } else {
+      charset_add(&set, regexp_pattern_char(p, &i));
+      f = nfa_set(b, set);
+    }
+    res = nfa_concat(b, res, f);
+  }
+  return res;
+}
+
+typedef struct dfa_sets_t {
+  uint64_t *items; // words_per_set words per DFA state
+  size_t count;
+  size_t capacity;
+} dfa_sets_t;
+
+typedef struct ints_t {
+  int *items;
+  size_t count;
+  size_t capacity;
+} ints_t;
+
+typedef struct dfa_builder_t {
+  nfa_builder_t *nfa;
+  size_t words;    // words per NFA state set
+  bool *lazy;      // rule -> stops at its shortest match
+  int *priority;   // rule -> rank, lower wins
+  bool *done;      // scratch: lazy rules that accepted in the current set
+  size_t rule_count;
+  dfa_sets_t sets; // NFA state set of every DFA state
+  ints_t table;    // open addressing: DFA state + 1, 0 if empty
+  ints_t stack;
+} dfa_builder_t;
+
+void nfa_closure(dfa_builder_t *d, uint64_t *set) {
+  d->stack.count = 0;
+  for (size_t i = 0; i < d->nfa->states.count; i++) {
+    if ((set[i >> 6] >> (i & 63)) & 1) {
+      da_append(&d->stack, i);
+    }
+  }
+  while (d->stack.count > 0) {
+    nfa_state_t s = d->nfa->states.items[d->stack.items[--d->stack.count]];
+    if (s.set >= 0) {
+      continue;
+    }
+    int outs[] = {s.out, s.out1};
+    for (int j = 0; j < 2; j++) {
+      int o = outs[j];
+      if (o < 0 || ((set[o >> 6] >> (o & 63)) & 1)) {
+        continue;
+      }
+      set[o >> 6] |= (uint64_t)1 << (o & 63);
+      da_append(&d->stack, o);
+    }
+  }
+}
+
+// Finds the winning rule of a closed set and drops the states of the lazy
+// rules that are already done.
+int dfa_settle(dfa_builder_t *d, uint64_t *set) {
+  int best = -1;
+  bool any_done = false;
+  for (size_t i = 0; i < d->nfa->states.count; i++) {
+    nfa_state_t s = d->nfa->states.items[i];
+    if (!s.final || !((set[i >> 6] >> (i & 63)) & 1)) {
+      continue;
+    }
+    if (best < 0 || d->priority[s.rule] < d->priority[best]) {
+      best = s.rule;
+    }
+    if (d->lazy[s.rule]) {
+      d->done[s.rule] = true;
+      any_done = true;
+    }
+  }
+  if (!any_done) {
+    return best;
+  }
+  // Final states are kept: they have no edge, and the accepted rule must stay
+  // a function of the set for states to be shared.
+  for (size_t i = 0; i < d->nfa->states.count; i++) {
+    nfa_state_t s = d->nfa->states.items[i];
+    if (!s.final && d->done[s.rule]) {
+      set[i >> 6] &= ~((uint64_t)1 << (i & 63));
+    }
+  }
+  memset(d->done, 0, d->rule_count * sizeof(bool));
+  return best;
+}
+
+uint64_t dfa_hash_set(const uint64_t *set, size_t words) {
+  uint64_t h = 14695981039346656037ULL;
+  for (size_t i = 0; i < words; i++) {
+    h = (h ^ set[i]) * 1099511628211ULL;
+  }
+  return h;
+}
+
+bool dfa_set_empty(const uint64_t *set, size_t words) {
+  for (size_t i = 0; i < words; i++) {
+    if (set[i]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void dfa_rehash(dfa_builder_t *d) {
+  size_t cap = d->table.capacity * 2;
+  free(d->table.items);
+  d->table.items = calloc(cap, sizeof(int));
+  d->table.capacity = cap;
+  size_t state_count = d->sets.count / d->words;
+  for (size_t s = 0; s < state_count; s++) {
+    uint64_t h = dfa_hash_set(d->sets.items + s * d->words, d->words);
+    size_t i = h & (cap - 1);
+    while (d->table.items[i]) {
+      i = (i + 1) & (cap - 1);
+    }
+    d->table.items[i] = s + 1;
+  }
+}
+
+// Returns the DFA state for a settled NFA state set, adding it if needed.
+int dfa_intern(dfa_builder_t *d, const uint64_t *set, bool *added) {
+  size_t cap = d->table.capacity;
+  size_t i = dfa_hash_set(set, d->words) & (cap - 1);
+  *added = false;
+  while (d->table.items[i]) {
+    int s = d->table.items[i] - 1;
+    if (!memcmp(d->sets.items + s * d->words, set, d->words * 8)) {
+      return s;
+    }
+    i = (i + 1) & (cap - 1);
+  }
+  int s = d->sets.count / d->words;
+  da_append_many(&d->sets, set, d->words);
+  d->table.items[i] = s + 1;
+  *added = true;
+  if ((size_t)(s + 1) * 2 > cap) {
+    dfa_rehash(d);
+  }
+  return s;
+}
+
+void dfa_compute_classes(lexer_dfa_t *dfa, charsets_t sets) {
+  memset(dfa->classes, 0, sizeof(dfa->classes));
+  dfa->class_count = 1;
+  for (size_t i = 0; i < sets.count; i++) {
+    int split[256][2];
+    memset(split, -1, sizeof(split));
+    size_t count = 0;
+    for (int c = 0; c < 256; c++) {
+      int in = charset_has(sets.items[i], c);
+      int *slot = &split[dfa->classes[c]][in];
+      if (*slot < 0) {
+        *slot = count++;
+      }
+      dfa->classes[c] = *slot;
+    }
+    dfa->class_count = count;
+  }
+}
+
+bool dfa_span_add(lexer_dfa_span_t *span, unsigned char c) {
+  if (span->count == LEXER_DFA_SPAN_MAX) {
+    return false;
+  }
+  span->bytes[span->count++] = c;
+  return true;
+}
+
+bool dfa_span_has(const lexer_dfa_span_t *span, unsigned char c) {
+  for (size_t k = 0; k < span->count; k++) {
+    if (span->bytes[k] == c) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void dfa_compute_spans(lexer_dfa_t *dfa, lexer_rules_t rules) {
+  size_t n = dfa->class_count;
+  dfa->exits = calloc(dfa->state_count, sizeof(lexer_dfa_span_t));
+  for (size_t s = 0; s < dfa->state_count; s++) {
+    // While an accepting state loops, every byte moves the match end.
+    if (dfa->accept[s] >= 0) {
+      continue;
+    }
+    lexer_dfa_span_t exits = {0};
+    bool ok = true;
+    for (int c = 0; c < 256 && ok; c++) {
+      if (dfa->transitions[s * n + dfa->classes[c]] != (int)s) {
+        ok = dfa_span_add(&exits, c);
+      }
+    }
+    if (ok) {
+      dfa->exits[s] = exits;
+    }
+  }
+
+  dfa->blanks = (lexer_dfa_span_t){0};
+  for (int c = 0; c < 256; c++) {
+    int t = dfa->transitions[dfa->classes[c]];
+    if (t < 0 || dfa->accept[t] < 0 ||
+        rules.data[dfa->accept[t]].kind != SKIP) {
+      continue;
+    }
+    bool dead = true;
+    for (size_t k = 0; k < n && dead; k++) {
+      dead = dfa->transitions[t * n + k] < 0;
+    }
+    if (dead && !dfa_span_add(&dfa->blanks, c)) {
+      dfa->blanks.count = 0;
+      return;
+    }
+  }
+}
+
+lexer_dfa_t *compile_lexer_dfa(lexer_rules_t rules) {
+  nfa_builder_t b = {0};
+  bool *lazy = calloc(rules.count + 1, sizeof(bool));
+  int *priority = malloc(sizeof(int) * (rules.count + 1));
+  // The states chaining the rules together belong to no rule.
+  b.rule = rules.count;
+  int start = nfa_new_state(&b, -1, -1, -1);
+  int last = start;
+  for (size_t i = 0; i < rules.count; i++) {
+    lexer_rule_t rule = rules.data[i];
+    b.rule = i;
+    nfa_frag_t f = dfa_parse_sequence(&b, rule.regexp, &lazy[i]);
+    b.states.items[f.end].final = true;
+    priority[i] = (rule.kind == SKIP ? 0 : rules.count) + i;
+    b.rule = rules.count;
+    int split = nfa_new_state(&b, -1, f.start, -1);
+    b.states.items[last].out1 = split;
+    last = split;
+  }
+  priority[rules.count] = 2 * rules.count;
+
+  lexer_dfa_t *dfa = malloc(sizeof(lexer_dfa_t));
+  dfa_compute_classes(dfa, b.sets);
+  unsigned char representative[256];
+  for (int c = 255; c >= 0; c--) {
+    representative[dfa->classes[c]] = c;
+  }
+
+  dfa_builder_t d = {0};
+  d.nfa = &b;
+  d.words = (b.states.count + 63) / 64;
+  d.lazy = lazy;
+  d.priority = priority;
+  d.done = calloc(rules.count + 1, sizeof(bool));
+  d.rule_count = rules.count + 1;
+  d.table.capacity = 64;
+  d.table.items = calloc(d.table.capacity, sizeof(int));
+  ints_t accept = {0};
+  ints_t transitions = {0};
+  uint64_t *set = malloc(d.words * sizeof(uint64_t));
+  memset(set, 0, d.words * sizeof(uint64_t));
+  set[start >> 6] |= (uint64_t)1 << (start & 63);
+  nfa_closure(&d, set);
+  bool added;
+  // Empty matches are never accepted, the start state stays non-final.
+  dfa_settle(&d, set);
+  dfa_intern(&d, set, &added);
+  da_append(&accept, -1);
+
+  for (size_t s = 0; s < d.sets.count / d.words; s++) {
+    for (size_t c = 0; c < dfa->class_count; c++) {
+      unsigned char byte = representative[c];
+      memset(set, 0, d.words * sizeof(uint64_t));
+      for (size_t i = 0; i < b.states.count; i++) {
+        if (!((d.sets.items[s * d.words + (i >> 6)] >> (i & 63)) & 1)) {
+          continue;
+        }
+        nfa_state_t st = b.states.items[i];
+        if (st.set >= 0 && charset_has(b.sets.items[st.set], byte)) {
+          set[st.out >> 6] |= (uint64_t)1 << (st.out & 63);
+        }
+      }
+      int target = -1;
+      if (!dfa_set_empty(set, d.words)) {
+        nfa_closure(&d, set);
+        int rule = dfa_settle(&d, set);
+        target = dfa_intern(&d, set, &added);
+        if (added) {
+          da_append(&accept, rule);
+        }
+      }
+      da_append(&transitions, target);
+    }
+  }
+
+  dfa->transitions = transitions.items;
+  dfa->accept = accept.items;
+  dfa->state_count = accept.count;
+  dfa_compute_spans(dfa, rules);
+
+  free(set);
+  free(d.sets.items);
+  free(d.table.items);
+  free(d.stack.items);
+  free(d.done);
+  free(b.states.items);
+  free(b.sets.items);
+  free(lazy);
+  free(priority);
+  return dfa;
+}
+
+void free_lexer_dfa(lexer_dfa_t *dfa) {
+  if (dfa == NULL)
+    return;
+  free(dfa->transitions);
+  free(dfa->accept);
+  free(dfa->exits);
+  free(dfa);
+}
+
+// Length of the prefix of p made of bytes of the span if inside is set, or of
+// bytes out of it otherwise. Strides of 32 or 16 bytes are compared at once
+// when the target has the vector instructions for it.
+size_t dfa_span_length(const unsigned char *p, size_t n,
+                       const lexer_dfa_span_t *span, bool inside) {
+  size_t i = 0;
+#if defined(__AVX2__)
+  for (; i + 32 <= n; i += 32) {
+    __m256i chunk = _mm256_loadu_si256((const __m256i *)(p + i));
+    __m256i hit = _mm256_setzero_si256();
+    for (size_t k = 0; k < span->count; k++) {
+      __m256i b = _mm256_set1_epi8((char)span->bytes[k]);
+      hit = _mm256_or_si256(hit, _mm256_cmpeq_epi8(chunk, b));
+    }
+    uint32_t mask = (uint32_t)_mm256_movemask_epi8(hit);
+    if (inside) {
+      mask = ~mask;
+    }
+    if (mask) {
+      return i + __builtin_ctz(mask);
+    }
+  }
+#endif
+#if defined(__SSE2__)
+  for (; i + 16 <= n; i += 16) {
+    __m128i chunk = _mm_loadu_si128((const __m128i *)(p + i));
+    __m128i hit = _mm_setzero_si128();
+    for (size_t k = 0; k < span->count; k++) {
+      __m128i b = _mm_set1_epi8((char)span->bytes[k]);
+      hit = _mm_or_si128(hit, _mm_cmpeq_epi8(chunk, b));
+    }
+    uint32_t mask = (uint32_t)_mm_movemask_epi8(hit);
+    if (inside) {
+      mask = ~mask & 0xffff;
+    }
+    if (mask) {
+      return i + __builtin_ctz(mask);
+    }
+  }
+#endif
+  while (i < n && dfa_span_has(span, p[i]) == inside) {
+    i++;
+  }
+  return i;
+}
+
+size_t lexer_dfa_skip_blanks(const lexer_dfa_t *dfa, string_view_t s) {
+  if (dfa->blanks.count == 0) {
+    return 0;
+  }
+  return dfa_span_length((const unsigned char *)s.contents, s.length,
+                         &dfa->blanks, true);
+}
+
+int lexer_dfa_match(const lexer_dfa_t *dfa, string_view_t s, size_t *length) {
+  const unsigned char *p = (const unsigned char *)s.contents;
+  int state = 0;
+  int rule = -1;
+  *length = 0;
+  for (size_t i = 0; i < s.length; i++) {
+    if (dfa->exits[state].count > 0) {
+      i += dfa_span_length(p + i, s.length - i, &dfa->exits[state], false);
+      if (i == s.length) {
+        break;
+      }
+    }
+    unsigned char c = p[i];
+    state = dfa->transitions[state * dfa->class_count + dfa->classes[c]];
+    if (state < 0) {
+      break;
+    }
+    if (dfa->accept[state] >= 0) {
+      rule = dfa->accept[state];
+      *length = i + 1;
+    }
+  }
+  return rule;
+}
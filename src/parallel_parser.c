@@ -0,0 +1,237 @@
+/**
+ * parallel_parser.c
+ * Copyright (C) 2024 Paul Passeron
+ * PARALLEL_PARSER source file
+ * Paul Passeron <paul.passeron2@gmail.com>
+ */
+
+#include "../include/parallel_parser.h"
+#include "../include/dynarr.h"
+#include "../include/parser.h"
+#include "../include/unilang_lexer.h"
+#include "../include/unilang_parser.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Below this many declarations per thread, threads cost more than they save.
+#define DECLS_PER_JOB 16
+
+// A top-level declaration found by the pre-scan, and what parsing it gave.
+typedef struct decl_span_t {
+  size_t start; // token index
+  size_t end;   // token index where parsing the declaration stopped
+  int worked;
+  ast_t *decl;
+} decl_span_t;
+
+typedef struct decl_spans_t {
+  decl_span_t *items;
+  size_t count;
+  size_t capacity;
+} decl_spans_t;
+
+typedef struct decls_t {
+  ast_t **items;
+  size_t count;
+  size_t capacity;
+} decls_t;
+
+typedef struct parse_job_t {
+  lexer_t lexer;
+  decl_span_t *spans;
+  size_t count;
+  arena_t arena;
+  lexer_stats_t lexer_stats;
+  pparser_list_stats_t list_stats;
+  parse_diagnostics_t diagnostics;
+#ifdef PPARSER_STATS
+  pparser_rule_stats_t *rule_stats;
+#endif
+} parse_job_t;
+
+bool starts_decl(token_t tok) {
+  switch (tok.kind) {
+  case KEY_LET:
+  case KEY_CLASS:
+    return true;
+  case DIRECTIVE:
+    return sv_eq(token_lexeme(tok), SV("@include")) ||
+           sv_eq(token_lexeme(tok), SV("@const"));
+  case IDENTIFIER:
+    return sv_eq(token_lexeme(tok), SV("interface"));
+  default:
+    return false;
+  }
+}
+
+// Declarations start with one of a few tokens, outside of any bracket. A wrong
+// guess only costs time: where parsing a declaration stops is checked against
+// the start of the next one.
+decl_spans_t find_decls(tokens_t *tokens, size_t from) {
+  decl_spans_t spans = {0};
+  size_t depth = 0;
+  for (size_t i = from; i < tokens->count; i++) {
+    token_t tok = tokens->items[i];
+    switch (tok.kind) {
+    case OPEN_PAR:
+    case OPEN_SQR:
+    case OPEN_BRA:
+      depth++;
+      break;
+    case CLOSE_PAR:
+    case CLOSE_SQR:
+    case CLOSE_BRA:
+      if (depth > 0)
+        depth--;
+      break;
+    default:
+      if (depth == 0 && starts_decl(tok)) {
+        da_append(&spans, ((decl_span_t){i, i, 0, NULL}));
+      }
+    }
+  }
+  return spans;
+}
+
+void *parse_job(void *arg) {
+  parse_job_t *job = arg;
+  set_ast_arena(&job->arena);
+  clear_parse_diagnostics();
+  for (size_t i = 0; i < job->count; i++) {
+    decl_span_t *span = &job->spans[i];
+    lexer_t l = job->lexer;
+    lexer_seek(&l, span->start);
+    span->decl = parse_decl(&l, &span->worked);
+    span->end = l.token_index;
+  }
+  pparser_free_thread_buffers();
+  job->lexer_stats = lexer_stats;
+  job->list_stats = pparser_list_stats;
+  job->diagnostics = parse_diagnostics;
+#ifdef PPARSER_STATS
+  size_t size = pparser_rule_count() * sizeof(pparser_rule_stats_t);
+  job->rule_stats = malloc(size);
+  memcpy(job->rule_stats, pparser_rule_stats, size);
+#endif
+  return NULL;
+}
+
+// Splits the declarations in runs of about as many tokens each.
+void split_jobs(parse_job_t *jobs, size_t job_count, lexer_t *l,
+                decl_spans_t spans) {
+  size_t from = l->token_index;
+  size_t token_count = l->state->tokens->count - from;
+  size_t first = 0;
+  for (size_t j = 0; j < job_count; j++) {
+    size_t target = from + token_count * (j + 1) / job_count;
+    size_t last = first;
+    while (last < spans.count &&
+           (j + 1 == job_count || spans.items[last].start < target)) {
+      last++;
+    }
+    jobs[j] = (parse_job_t){
+        .lexer = *l, .spans = spans.items + first, .count = last - first};
+    first = last;
+  }
+}
+
+void run_jobs(parse_job_t *jobs, size_t job_count) {
+  pthread_t *threads = malloc(sizeof(pthread_t) * job_count);
+  bool *started = malloc(sizeof(bool) * job_count);
+  for (size_t j = 0; j < job_count; j++) {
+    started[j] = pthread_create(&threads[j], NULL, parse_job, &jobs[j]) == 0;
+    if (!started[j])
+      parse_job(&jobs[j]);
+  }
+  for (size_t j = 0; j < job_count; j++) {
+    if (started[j])
+      pthread_join(threads[j], NULL);
+  }
+  free(started);
+  free(threads);
+}
+
+// The trees, the statistics and the diagnostics of the workers become those
+// of this thread.
+void adopt_jobs(parse_job_t *jobs, size_t job_count) {
+  for (size_t j = 0; j < job_count; j++) {
+    arena_adopt(get_ast_arena(), &jobs[j].arena);
+    lexer_stats.scanned += jobs[j].lexer_stats.scanned;
+    lexer_stats.read += jobs[j].lexer_stats.read;
+    pparser_list_stats.lists += jobs[j].list_stats.lists;
+    pparser_list_stats.elems += jobs[j].list_stats.elems;
+    pparser_list_stats.grows += jobs[j].list_stats.grows;
+    if (jobs[j].list_stats.peak > pparser_list_stats.peak)
+      pparser_list_stats.peak = jobs[j].list_stats.peak;
+    if (jobs[j].diagnostics.failed)
+      record_parse_failure(jobs[j].diagnostics.furthest);
+#ifdef PPARSER_STATS
+    for (size_t r = 0; r < pparser_rule_count(); r++) {
+      pparser_rule_stats_t *to = &pparser_rule_stats[r];
+      pparser_rule_stats_t from = jobs[j].rule_stats[r];
+      to->calls += from.calls;
+      to->memo_hits += from.memo_hits;
+      to->successes += from.successes;
+      to->failures += from.failures;
+      to->failed_tokens += from.failed_tokens;
+      to->total_ns += from.total_ns;
+      to->self_ns += from.self_ns;
+    }
+    free(jobs[j].rule_stats);
+#endif
+  }
+}
+
+ast_t *parse_program_parallel(lexer_t *l, int *worked, int jobs) {
+  clear_parse_diagnostics();
+  if (l->state->tokens == NULL || jobs < 2)
+    return parse_program(l, worked);
+  decl_spans_t spans = find_decls(l->state->tokens, l->token_index);
+  size_t job_count = spans.count / DECLS_PER_JOB;
+  if (job_count > (size_t)jobs)
+    job_count = jobs;
+  if (job_count < 2) {
+    da_free(spans);
+    return parse_program(l, worked);
+  }
+  parse_job_t *job = malloc(sizeof(parse_job_t) * job_count);
+  split_jobs(job, job_count, l, spans);
+  run_jobs(job, job_count);
+  adopt_jobs(job, job_count);
+  free(job);
+
+  // Same loop as the program_list rule, taking each declaration from the
+  // workers when one starts at the current position.
+  decls_t decls = {0};
+  size_t i = 0;
+  while (true) {
+    while (i < spans.count && spans.items[i].start < l->token_index) {
+      i++;
+    }
+    int decl_worked = 0;
+    ast_t *decl;
+    if (i < spans.count && spans.items[i].start == l->token_index) {
+      decl_worked = spans.items[i].worked;
+      decl = spans.items[i].decl;
+      if (decl_worked)
+        lexer_seek(l, spans.items[i].end);
+    } else {
+      decl = parse_decl(l, &decl_worked);
+    }
+    if (!decl_worked)
+      break;
+    da_append(&decls, decl);
+  }
+  da_free(spans);
+
+  ast_t **elems = ast_alloc((decls.count + 1) * sizeof(ast_t *));
+  memcpy(elems, decls.items, decls.count * sizeof(ast_t *));
+  elems[decls.count] = NULL;
+  pparser_list_stats.lists++;
+  pparser_list_stats.elems += decls.count;
+  *worked = decls.count > 0;
+  da_free(decls);
+  return *worked ? new_compound(elems) : NULL;
+}
@@ -47,6 +47,29 @@ parser_t new_choice_parser(parser_t *children, size_t count,
   return res;
 }
 
+_Thread_local parse_diagnostics_t parse_diagnostics = {0};
+
+void clear_parse_diagnostics(void) {
+  parse_diagnostics = (parse_diagnostics_t){0};
+}
+
+void record_parse_failure(parse_failure_t failure) {
+  // On a tie the first failure recorded, the innermost one, is kept.
+  if (parse_diagnostics.failed &&
+      failure.at.offset <= parse_diagnostics.furthest.at.offset)
+    return;
+  parse_diagnostics.failed = true;
+  parse_diagnostics.furthest = failure;
+}
+
+void report_parse_failure(FILE *f) {
+  if (!parse_diagnostics.failed)
+    return;
+  parse_failure_t failure = parse_diagnostics.furthest;
+  print_error(f, &failure.rule_start, failure.rule_message);
+  print_error(f, &failure.at, failure.message);
+}
+
 // this returns an array of pointer.
 // Its actual return type is void**
 void *chain_rule(lexer_t *l, parser_t self) {
@@ -56,8 +79,9 @@ void *chain_rule(lexer_t *l, parser_t self) {
     parser_t p = self.children.parsers[i];
     res[i] = p.rule(l, p);
     if (res[i] == NULL) {
-      print_error(stderr, &cpy, self.error_message);
-      print_error(stderr, l, p.error_message);
+      record_parse_failure(
+          (parse_failure_t){cpy, self.error_message, *l, p.error_message});
+      free(res);
       return NULL;
     }
   }
@@ -65,32 +89,14 @@ void *chain_rule(lexer_t *l, parser_t self) {
 }
 
 void *choice_rule(lexer_t *l, parser_t self) {
-  int current_max = -1;
-  lexer_t *current_lexer = malloc(sizeof(lexer_t));
-  *current_lexer = *l;
-  parser_t *best_parser = malloc(sizeof(parser_t));
-  *best_parser = self;
   for (size_t i = 0; i < self.children.count; i++) {
     lexer_t cpy = *l;
     parser_t p = self.children.parsers[i];
     void *res = p.rule(&cpy, p);
-    if (res) {
-      free(current_lexer);
-      free(best_parser);
+    if (res)
       return res;
-    }
-    int dist = l->eaten - cpy.eaten;
-    if (dist > current_max) {
-      current_max = dist;
-      *current_lexer = cpy;
-      *best_parser = p;
-    }
-  }
-  print_error(stderr, l, self.error_message);
-  if (best_parser != NULL) {
-    print_error(stderr, current_lexer, best_parser->error_message);
+    record_parse_failure(
+        (parse_failure_t){*l, self.error_message, cpy, p.error_message});
   }
-  free(current_lexer);
-  free(best_parser);
   return NULL;
 }
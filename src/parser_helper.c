@@ -6,6 +6,7 @@
  */
 
 #include "../include/parser_helper.h"
+#include "../include/dynarr.h"
 #include "../include/unilang_lexer.h"
 #include "../include/unilang_parser.h"
 
@@ -75,18 +76,7 @@ bool is_kind_op(const int kind) {
          kind != DEREF;
 }
 
-bool is_postfix(lexer_t *l) {
-  token_t t = peek_token(l);
-  if (is_error_tok(t))
-    return 0;
-  switch (t.kind) {
-  case OPEN_PAR:
-  case OPEN_SQR:
-    return true;
-  default:
-    return false;
-  }
-}
+bool is_postfix(int kind) { return kind == OPEN_PAR || kind == OPEN_SQR; }
 
 ast_t *parse_funcall(lexer_t *l, ast_t *called) {
   int w;
@@ -94,14 +84,13 @@ ast_t *parse_funcall(lexer_t *l, ast_t *called) {
   ast_t **elems;
   size_t count = 0;
   if (tok.kind == CLOSE_PAR) {
-    elems = malloc(sizeof(ast_t *));
+    elems = ast_alloc(sizeof(ast_t *));
     *elems = NULL;
   } else {
     elems = parse_funcallargs(l, &w);
     while (elems[count]) {
       count++;
     }
-    elems = realloc(elems, sizeof(ast_t *) * count);
   }
   tok = next(l);
   if (tok.kind != CLOSE_PAR) {
@@ -110,20 +99,6 @@ ast_t *parse_funcall(lexer_t *l, ast_t *called) {
   return new_funcall(called, count, elems);
 }
 
-ast_t *parse_prefix(lexer_t *l) {
-  token_t tok = peek_token(l);
-  if (!is_prefix(tok.kind)) {
-    return NULL;
-  }
-  next(l);
-  ast_t *operand = parse_expression_aux(l, get_precedence(tok.kind));
-  if (!operand) {
-    return NULL;
-  }
-
-  return new_unop(tok, operand);
-}
-
 ast_t *parse_postfix(lexer_t *l, ast_t *left) {
   token_t tok = next(l);
   if (is_error_tok(tok))
@@ -144,63 +119,152 @@ ast_t *parse_postfix(lexer_t *l, ast_t *left) {
   return left;
 }
 
-ast_t *parse_expression_aux(lexer_t *l, int min_precedence) {
-  int worked = 0;
-  ast_t *left;
+// Next token, peeked once per position of the lexer.
+typedef struct lookahead_t {
+  lexer_t *l;
+  size_t offset;
+  bool valid;
+  token_t tok;
+} lookahead_t;
 
-  token_t tok = peek_token(l);
-  if (is_prefix(tok.kind)) {
-    left = parse_prefix(l);
-    if (!left) {
-      worked = 0;
-      return NULL; // Error in parsing prefix expression
-    }
-  } else {
-    left = parse_leaf(l, &worked);
-    if (!worked) {
-      return NULL; // Error in parsing leaf expression
-    }
-  }
-  tok = peek_token(l);
-  if (is_error_tok(tok)) {
-    return NULL;
-  }
-  while (true) {
-    ast_t *node = parse_increasing_precedence(l, left, min_precedence);
-    if (!node) {
-      return NULL;
-    }
-    if (node == left)
-      break;
-    left = node;
+token_t lookahead(lookahead_t *la) {
+  if (!la->valid || la->offset != la->l->offset) {
+    la->tok = peek_token(la->l);
+    la->offset = la->l->offset;
+    la->valid = true;
   }
-  return left;
+  return la->tok;
 }
 
-ast_t *parse_increasing_precedence(lexer_t *l, ast_t *left,
-                                   int min_precedence) {
-  token_t tok = peek_token(l);
-  if (is_error_tok(tok)) {
-    return NULL;
-  }
-  while (is_postfix(l)) {
-    int postfix_precedence = get_precedence(peek_token(l).kind);
-    if (postfix_precedence < min_precedence) {
-      break;
+// What an expression frame waits for: the operand of its prefix operator, or
+// the right side of its binary operator.
+typedef enum expr_wait_t {
+  EXPR_PREFIX,
+  EXPR_INFIX,
+} expr_wait_t;
+
+// One level of precedence climbing: the operator at the top of the stack
+// binds tighter than every operator below it.
+typedef struct expr_frame_t {
+  int min_precedence;
+  expr_wait_t wait;
+  token_t op;
+  ast_t *left;
+} expr_frame_t;
+
+typedef struct expr_frames_t {
+  expr_frame_t *items;
+  size_t count;
+  size_t capacity;
+} expr_frames_t;
+
+// Shared by nested expressions (parentheses, arguments, subscripts), each one
+// above the frames of the expression it is part of. Frames are only accessed
+// through expr_top(): parsing a leaf or a postfix can move the stack.
+_Thread_local expr_frames_t expr_frames = {0};
+
+void free_expr_frames(void) {
+  da_free(expr_frames);
+  expr_frames = (expr_frames_t){0};
+}
+
+expr_frame_t *expr_top(void) {
+  return &expr_frames.items[expr_frames.count - 1];
+}
+
+void push_expr_frame(int min_precedence) {
+  expr_frame_t frame = {min_precedence, EXPR_INFIX, error_token(), NULL};
+  da_append(&expr_frames, frame);
+}
+
+typedef enum expr_step_t {
+  EXPR_OPERAND,  // parse a prefix operator or a leaf
+  EXPR_OPERATOR, // parse postfixes or a binary operator after the left side
+  EXPR_RETURN,   // hand the result of the top frame to the one below
+} expr_step_t;
+
+// Precedence climbing with an explicit stack instead of one recursive call per
+// operator, so that the depth of an expression does not matter.
+ast_t *parse_expression_aux(lexer_t *l, int min_precedence) {
+  lookahead_t la = {l, 0, false, {0}};
+  size_t base = expr_frames.count;
+  push_expr_frame(min_precedence);
+  expr_step_t step = EXPR_OPERAND;
+  ast_t *res = NULL;
+  while (true) {
+    switch (step) {
+    case EXPR_OPERAND: {
+      token_t tok = lookahead(&la);
+      if (is_prefix(tok.kind)) {
+        next(l);
+        expr_top()->op = tok;
+        expr_top()->wait = EXPR_PREFIX;
+        push_expr_frame(get_precedence(tok.kind));
+        break;
+      }
+      int worked = 0;
+      ast_t *leaf = parse_leaf(l, &worked);
+      if (!worked) {
+        res = NULL;
+        step = EXPR_RETURN;
+        break;
+      }
+      expr_top()->left = leaf;
+      step = EXPR_OPERATOR;
+    } break;
+    case EXPR_OPERATOR: {
+      token_t tok = lookahead(&la);
+      if (is_error_tok(tok)) {
+        res = NULL;
+        step = EXPR_RETURN;
+        break;
+      }
+      if (is_postfix(tok.kind)) {
+        ast_t *left = expr_top()->left;
+        while (is_postfix(lookahead(&la).kind)) {
+          int postfix_precedence = get_precedence(lookahead(&la).kind);
+          if (postfix_precedence < expr_top()->min_precedence) {
+            break;
+          }
+          left = parse_postfix(l, left);
+        }
+        if (left == NULL || left == expr_top()->left) {
+          res = left;
+          step = EXPR_RETURN;
+          break;
+        }
+        expr_top()->left = left;
+        break;
+      }
+      int next_precedence = get_precedence(tok.kind);
+      if (!is_kind_op(tok.kind) ||
+          next_precedence <= expr_top()->min_precedence) {
+        res = expr_top()->left;
+        step = EXPR_RETURN;
+        break;
+      }
+      next(l);
+      expr_top()->op = tok;
+      expr_top()->wait = EXPR_INFIX;
+      push_expr_frame(next_precedence);
+      step = EXPR_OPERAND;
+    } break;
+    case EXPR_RETURN: {
+      expr_frames.count--;
+      if (expr_frames.count == base) {
+        return res;
+      }
+      if (res == NULL) {
+        break;
+      }
+      expr_frame_t *top = expr_top();
+      if (top->wait == EXPR_PREFIX) {
+        top->left = new_unop(top->op, res);
+      } else {
+        top->left = new_binop(top->op, top->left, res);
+      }
+      step = EXPR_OPERATOR;
+    } break;
     }
-    left = parse_postfix(l, left);
-  }
-  if (!is_kind_op(tok.kind)) {
-    return left;
-  }
-  int next_precedence = get_precedence(tok.kind);
-  if (next_precedence <= min_precedence) {
-    return left;
-  }
-  next(l);
-  ast_t *right = parse_expression_aux(l, next_precedence);
-  if (right == NULL) {
-    return NULL;
   }
-  return new_binop(tok, left, right);
 }
@@ -6,242 +6,295 @@
  */
 
 #include "../include/regexp.h"
+#include "../include/dynarr.h"
 #include <stdint.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
-void match_single(const char *pattern, const char *string, bool *worked,
-                  int *pattern_advanced) {
-  *pattern_advanced = 1;
-  char to_test = *pattern;
-  pattern++;
-  if (to_test == '\\') {
-    // handle escaping
-    switch (*pattern) {
-    case '*':
-      to_test = '*';
-      break;
-    case '[':
-      to_test = '[';
-      break;
-    case ']':
-      to_test = ']';
-      break;
-    case ')':
-      to_test = ')';
-      break;
-    case '(':
-      to_test = '(';
-      break;
-    case '\\':
-      to_test = '\\';
-      break;
-    case '?':
-      to_test = '?';
-      break;
-    case 'n':
-      to_test = '\n';
-      break;
-    case 't':
-      to_test = '\t';
-      break;
-    case 'r':
-      to_test = '\r';
-      break;
-    case 'b':
-      to_test = '\b';
-      break;
-    case '0':
-      to_test = 0;
-      break;
-    default:
-      break;
-    }
-    *pattern_advanced = 2;
+// Patterns are compiled once to a flat program. A '(...)' group becomes a
+// GROUP instruction followed by the program of its body, ended by END, so the
+// matcher never copies a sub-pattern. Classes are 256-bit maps.
+
+char regexp_escaped_char(char c) {
+  switch (c) {
+  case 'n':
+    return '\n';
+  case 't':
+    return '\t';
+  case 'r':
+    return '\r';
+  case 'b':
+    return '\b';
+  case '0':
+    return 0;
+  case '*':
+  case '[':
+  case ']':
+  case '(':
+  case ')':
+  case '\\':
+  case '?':
+    return c;
+  default:
+    return '\\';
   }
-  *worked = *string == to_test;
 }
 
-char get_actualchar(const char *str, int *length) {
-  *length = 1;
-  if (!*str)
-    return 0;
-  char ch = *str;
-  str++;
-  if (ch == '\\') {
-    *length = 2;
-    switch (*str) {
-    case '*':
-      ch = '*';
-      break;
-    case '[':
-      ch = '[';
-      break;
-    case ']':
-      ch = ']';
-      break;
-    case ')':
-      ch = ')';
-      break;
-    case '(':
-      ch = '(';
-      break;
-    case '\\':
-      ch = '\\';
-      break;
-    case '?':
-      ch = '?';
-      break;
-    case 'n':
-      ch = '\n';
-      break;
-    case 't':
-      ch = '\t';
-      break;
-    case 'r':
-      ch = '\r';
-      break;
-    case 'b':
-      ch = '\b';
-      break;
-    case '0':
-      ch = 0;
-      break;
-    default:
-      break;
+char regexp_pattern_char(string_view_t p, size_t *i) {
+  char c = p.contents[(*i)++];
+  if (c == '\\' && *i < p.length) {
+    c = regexp_escaped_char(p.contents[(*i)++]);
+  }
+  return c;
+}
+
+void regexp_emit(regexp_t *re, regexp_op_t op, int arg) {
+  da_append(&re->code, ((regexp_inst_t){op, arg}));
+}
+
+void regexp_class_add(regexp_class_t *set, unsigned char c) {
+  set->bits[c >> 6] |= (uint64_t)1 << (c & 63);
+}
+
+bool regexp_class_has(const regexp_class_t *set, unsigned char c) {
+  return (set->bits[c >> 6] >> (c & 63)) & 1;
+}
+
+regexp_class_t regexp_parse_class(string_view_t p, size_t *i) {
+  regexp_class_t set = {0};
+  if (*i >= p.length || p.contents[*i] == ']') {
+    printf("Syntax error in regexp: [] without body\n");
+    exit(1);
+  }
+  while (*i < p.length && p.contents[*i] != ']') {
+    unsigned char start = regexp_pattern_char(p, i);
+    if (*i >= p.length || p.contents[*i] != '-') {
+      if (start == '-') {
+        regexp_class_add(&set, '-');
+        continue;
+      }
+      printf("Syntax error in regexp: Expected '-' delimeter in [] "
+             "range.\n");
+      exit(1);
+    }
+    (*i)++;
+    if (*i >= p.length || p.contents[*i] == ']') {
+      printf("Syntax error in regexp: No right part of range [].\n");
+      exit(1);
+    }
+    unsigned char end = regexp_pattern_char(p, i);
+    for (unsigned c = start; c <= end; c++) {
+      regexp_class_add(&set, c);
     }
   }
-  return ch;
+  if (*i >= p.length) {
+    printf("Syntax error in regexp: [ without ] in range.\n");
+    exit(1);
+  }
+  (*i)++;
+  return set;
 }
 
-void regexp(const char *pattern, const char *string, bool *pattern_finished,
-            int *string_matched) {
-  const char *src_string = string;
-  *pattern_finished = false;
-  *string_matched = 0;
-  while (*pattern && *string) {
-    char c = *pattern;
+void regexp_compile_sequence(regexp_t *re, string_view_t p) {
+  size_t i = 0;
+  while (i < p.length) {
+    char c = p.contents[i];
     if (c == '(') {
-      pattern++;
-      const char *pat = pattern;
-      while (*pattern && *pattern != ')') {
-        pattern++;
-      }
-      char *sub_pat = (malloc(pattern - pat + 1));
-      memcpy(sub_pat, pat, pattern - pat + 1);
-      sub_pat[pattern - pat] = 0;
-      pattern++;
-      while (true) {
-        bool finished = false;
-        int strmatched = 0;
-        regexp(sub_pat, string, &finished, &strmatched);
-        if (!finished || !*string) {
-          break;
-        }
-        string += strmatched;
-        *string_matched += strmatched;
+      size_t start = ++i;
+      while (i < p.length && p.contents[i] != ')') {
+        i++;
       }
-      free(sub_pat);
-
-      continue;
-    } else if (c == '?') {
-      pattern++;
-      string++;
-      *string_matched += 1;
+      string_view_t sub = {p.contents + start, i - start};
+      i++;
+      size_t group = re->code.count;
+      regexp_emit(re, RE_GROUP, 0);
+      regexp_compile_sequence(re, sub);
+      regexp_emit(re, RE_END, 0);
+      re->code.items[group].arg = re->code.count - group - 1;
     } else if (c == '*') {
-      if (!*(pattern + 1)) {
-        *pattern_finished = true;
-        *string_matched = strlen(src_string);
-        return;
+      i++;
+      regexp_emit(re, RE_STAR, 0);
+    } else if (c == '?') {
+      i++;
+      regexp_emit(re, RE_ANY, 0);
+    } else if (c == '[') {
+      i++;
+      da_append(&re->classes, regexp_parse_class(p, &i));
+      regexp_emit(re, RE_CLASS, re->classes.count - 1);
+    } else {
+      regexp_emit(re, RE_CHAR, (unsigned char)regexp_pattern_char(p, &i));
+    }
+  }
+}
+
+regexp_t *compile_regexp(string_view_t pattern) {
+  regexp_t *re = malloc(sizeof(regexp_t));
+  *re = (regexp_t){0};
+  regexp_compile_sequence(re, pattern);
+  regexp_emit(re, RE_END, 0);
+  re->code.items =
+      realloc(re->code.items, re->code.count * sizeof(regexp_inst_t));
+  re->code.capacity = re->code.count;
+  if (re->classes.count > 0) {
+    re->classes.items = realloc(re->classes.items,
+                                re->classes.count * sizeof(regexp_class_t));
+    re->classes.capacity = re->classes.count;
+  }
+  return re;
+}
+
+void free_regexp(regexp_t *re) {
+  if (re == NULL)
+    return;
+  free(re->code.items);
+  free(re->classes.items);
+  free(re);
+}
+
+// Runs the program from pc on s. Returns whether the program got to its END,
+// groups being allowed to repeat zero times once s is exhausted.
+bool regexp_run(const regexp_t *re, size_t pc, const unsigned char *s,
+                size_t len, size_t *matched) {
+  const regexp_inst_t *code = re->code.items;
+  size_t i = 0;
+  while (code[pc].op != RE_END && i < len) {
+    regexp_inst_t inst = code[pc];
+    switch (inst.op) {
+    case RE_CHAR:
+      if (s[i] != inst.arg) {
+        *matched = i;
+        return false;
       }
-      uint32_t string_length = strlen(string);
-      for (size_t j = 0; j < string_length; j++) {
-        bool finished = false;
-        int string_match = 0;
-        regexp(pattern + 1, string + j, &finished, &string_match);
-        if (finished) {
-          *pattern_finished = true;
-          *string_matched += string_match + j;
-          return;
-        }
-        if (!*(string + j + 1)) {
-          *pattern_finished = false;
-          return;
+      i++;
+      pc++;
+      break;
+    case RE_ANY:
+      i++;
+      pc++;
+      break;
+    case RE_CLASS:
+      if (!regexp_class_has(&re->classes.items[inst.arg], s[i])) {
+        *matched = i;
+        return false;
+      }
+      i++;
+      pc++;
+      break;
+    case RE_GROUP:
+      // Greedy and without backtracking, like the rest of the language.
+      while (i < len) {
+        size_t m;
+        if (!regexp_run(re, pc + 1, s + i, len - i, &m) || m == 0) {
+          break;
         }
+        i += m;
       }
-    } else if (c == '[') {
-      bool found = false;
-      pattern++;
-      if (!*pattern || *pattern == ']') {
-        exit(1);
+      pc += 1 + inst.arg;
+      break;
+    case RE_STAR:
+      if (code[pc + 1].op == RE_END) {
+        *matched = len;
+        return true;
       }
-      do {
-        if (found) {
-          pattern++;
-          continue;
-        }
-        int l = 0;
-        char start = get_actualchar(pattern, &l);
-        pattern += l;
-        char delim = *pattern;
-        if (!delim) {
-          exit(1);
-        }
-        if (start != delim && start == '-') {
-          if (*string == '-') {
-            pattern--;
-            found = true;
-            *string_matched += 1;
-            string++;
-            continue;
-          }
-          return;
+      // Shortest match: the first position from which the rest matches.
+      for (size_t j = i; j < len; j++) {
+        size_t m;
+        if (regexp_run(re, pc + 1, s + j, len - j, &m)) {
+          *matched = j + m;
+          return true;
         }
-        if (delim != '-') {
-          exit(1);
-        }
-        pattern++;
-        char end = get_actualchar(pattern, &l);
-        pattern += l;
-        if (!end || end == ']') {
-          exit(1);
-        }
-        char s = *string;
-        if (s >= start && s <= end) {
-          found = true;
-          *string_matched += 1;
-          string++;
-          if (!*pattern) {
-            *pattern_finished = true;
-          }
-        }
-      } while (*pattern && *pattern != ']');
-      if (!found) {
-        return;
-      }
-      pattern++;
-    } else {
-      bool worked;
-      int amount;
-      match_single(pattern, string, &worked, &amount);
-      if (worked) {
-        string++;
-        *string_matched += 1;
-        pattern += amount;
-      } else {
-        return;
       }
+      *matched = i;
+      return false;
+    case RE_END:
+      break;
+    }
+  }
+  while (code[pc].op == RE_GROUP) {
+    pc += 1 + code[pc].arg;
+  }
+  *matched = i;
+  return code[pc].op == RE_END;
+}
+
+bool regexp_match(const regexp_t *re, string_view_t string, size_t *matched) {
+  return regexp_run(re, 0, (const unsigned char *)string.contents,
+                    string.length, matched);
+}
+
+// Compiled programs of the patterns given to sv_regexp() and friends, so a
+// pattern is only compiled the first time it is used.
+typedef struct regexp_cache_t {
+  string_view_t *patterns;
+  regexp_t **programs;
+  size_t count;
+  size_t capacity; // power of two, 0 before the first insertion
+} regexp_cache_t;
+
+regexp_cache_t regexp_cache = {0};
+
+size_t regexp_hash(string_view_t s) {
+  uint64_t h = 14695981039346656037ULL;
+  for (size_t i = 0; i < s.length; i++) {
+    h = (h ^ (unsigned char)s.contents[i]) * 1099511628211ULL;
+  }
+  return h;
+}
+
+void regexp_cache_insert(regexp_cache_t *c, string_view_t pattern,
+                         regexp_t *re) {
+  size_t i = regexp_hash(pattern) & (c->capacity - 1);
+  while (c->programs[i] != NULL) {
+    i = (i + 1) & (c->capacity - 1);
+  }
+  c->patterns[i] = pattern;
+  c->programs[i] = re;
+  c->count++;
+}
+
+void regexp_cache_grow(regexp_cache_t *c) {
+  regexp_cache_t old = *c;
+  c->capacity = old.capacity == 0 ? 64 : old.capacity * 2;
+  c->count = 0;
+  c->patterns = calloc(c->capacity, sizeof(string_view_t));
+  c->programs = calloc(c->capacity, sizeof(regexp_t *));
+  for (size_t i = 0; i < old.capacity; i++) {
+    if (old.programs[i] != NULL) {
+      regexp_cache_insert(c, old.patterns[i], old.programs[i]);
     }
   }
-  while (*pattern == '(') {
-    while (*pattern && *pattern != ')') {
-      pattern++;
+  free(old.patterns);
+  free(old.programs);
+}
+
+const regexp_t *cached_regexp(string_view_t pattern) {
+  regexp_cache_t *c = &regexp_cache;
+  if (c->capacity > 0) {
+    size_t i = regexp_hash(pattern) & (c->capacity - 1);
+    while (c->programs[i] != NULL) {
+      if (sv_eq(c->patterns[i], pattern)) {
+        return c->programs[i];
+      }
+      i = (i + 1) & (c->capacity - 1);
     }
-    pattern++;
   }
-  if (!*pattern) {
-    *pattern_finished = true;
+  if ((c->count + 1) * 2 > c->capacity) {
+    regexp_cache_grow(c);
   }
+  // The cache keeps its own copy: the pattern may live in a temporary buffer.
+  string_view_t key = {malloc(pattern.length + 1), pattern.length};
+  memcpy(key.contents, pattern.contents, pattern.length);
+  regexp_t *re = compile_regexp(pattern);
+  regexp_cache_insert(c, key, re);
+  return re;
+}
+
+void regexp(const char *pattern, const char *string, bool *pattern_finished,
+            int *string_matched) {
+  string_view_t p = {(char *)pattern, strlen(pattern)};
+  string_view_t s = {(char *)string, strlen(string)};
+  sv_regexp(p, s, pattern_finished, string_matched);
 }
 
 bool matches_exact(const char *pattern, char *string, char **rest) {
@@ -269,149 +322,9 @@ bool sv_matches_exact(string_view_t pattern, string_view_t string,
 
 void sv_regexp(string_view_t pattern, string_view_t string,
                bool *pattern_finished, int *string_matched) {
-  *pattern_finished = false;
-  *string_matched = 0;
-  size_t pat_index = 0;
-  size_t str_index = 0;
-  while (pat_index < pattern.length && str_index < string.length) {
-    char c = pattern.contents[pat_index];
-    if (c == '(') {
-      pat_index++;
-      size_t start_index = pat_index;
-      while (pat_index < pattern.length && pattern.contents[pat_index] != ')') {
-        pat_index++;
-      }
-      string_view_t sub_pat = (string_view_t){
-          .contents = pattern.contents + start_index,
-          .length = pat_index - start_index,
-      };
-      pat_index++;
-      while (true) {
-        bool finished = false;
-        int strmatched = 0;
-        string_view_t to_match = (string_view_t){
-            string.contents + str_index,
-            string.length - str_index,
-        };
-        sv_regexp(sub_pat, to_match, &finished, &strmatched);
-        if (!finished || str_index >= string.length) {
-          break;
-        }
-        str_index += strmatched;
-        *string_matched += strmatched;
-      }
-      continue;
-    } else if (c == '?') {
-      pat_index++;
-      str_index++;
-      *string_matched += 1;
-    } else if (c == '*') {
-      if (pat_index + 1 >= pattern.length) {
-        *pattern_finished = true;
-        *string_matched = string.length;
-        return;
-      }
-      size_t string_length = string.length - str_index;
-      for (size_t j = 0; j < string_length; j++) {
-        bool finished = false;
-        int string_match = 0;
-        string_view_t to_match =
-            (string_view_t){string.contents + str_index + j, string_length - j};
-        string_view_t new_pat = (string_view_t){
-            pattern.contents + pat_index + 1, pattern.length - pat_index - 1};
-        sv_regexp(new_pat, to_match, &finished, &string_match);
-        if (finished) {
-          *pattern_finished = true;
-          *string_matched += string_match + j;
-          return;
-        }
-        if (str_index + j >= string.length) {
-          *pattern_finished = false;
-          return;
-        }
-      }
-    } else if (c == '[') {
-      bool found = false;
-      pat_index++;
-      if (pat_index >= pattern.length || pattern.contents[pat_index] == ']') {
-        printf("Syntax error in regexp: [] without body\n");
-        exit(1);
-      }
-      do {
-        if (found) {
-          pat_index++;
-          continue;
-        }
-        int l = 0;
-        char start = get_actualchar(pattern.contents + pat_index, &l);
-        pat_index += l;
-        char delim = pattern.contents[pat_index];
-        if (start != delim && start == '-') {
-          if (string.contents[str_index] == '-') {
-            pat_index--;
-            found = true;
-            *string_matched += 1;
-            str_index++;
-            continue;
-          }
-          // return;
-        }
-        if (delim != '-') {
-          printf("Syntax error in regexp: Expected '-' delimeter in [] "
-                 "range.\n");
-          exit(1);
-        }
-        pat_index++;
-        if (pat_index >= pattern.length) {
-          printf("Syntax error in regexp: [ without ] in range.\n");
-          exit(1);
-        }
-        char end = get_actualchar(pattern.contents + pat_index, &l);
-
-        pat_index += l;
-        if (end == ']' || pat_index >= pattern.length) {
-          printf("Syntax error in regexp: No right part of range [].\n");
-          exit(1);
-        }
-        char s = string.contents[str_index];
-        if (s >= start && s <= end) {
-          found = true;
-          *string_matched += 1;
-          str_index++;
-          if (pat_index >= pattern.length) {
-            *pattern_finished = true;
-          }
-        }
-      } while (pat_index < pattern.length &&
-               pattern.contents[pat_index] != ']');
-      if (!found) {
-        return;
-      }
-      pat_index++;
-    } else {
-      bool worked;
-      int ammount;
-      match_single(pattern.contents + pat_index, string.contents + str_index,
-                   &worked, &ammount);
-      if (worked) {
-        str_index++;
-        *string_matched += 1;
-        pat_index += ammount;
-      } else {
-        return;
-      }
-    }
-  }
-  // why ?
-  while (pattern.contents[pat_index] == '(') {
-    while (pat_index < pattern.length && pattern.contents[pat_index] != ')') {
-      pat_index++;
-    }
-    pat_index++;
-  }
-  if (pat_index >= pattern.length) {
-    *pattern_finished = true;
-  }
+  size_t matched;
+  *pattern_finished = regexp_match(cached_regexp(pattern), string, &matched);
+  *string_matched = matched;
 }
 
 char *unescape_string(const char *input) {
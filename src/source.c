@@ -0,0 +1,153 @@
+/**
+ * source.c
+ * Copyright (C) 2024 Paul Passeron
+ * SOURCE source file
+ * Paul Passeron <paul.passeron2@gmail.com>
+ */
+
+#include "../include/source.h"
+#include "../include/dynarr.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+typedef struct line_starts_t {
+  size_t *items;
+  size_t count;
+  size_t capacity;
+} line_starts_t;
+
+typedef struct sources_t {
+  source_t **items;
+  size_t count;
+  size_t capacity;
+} sources_t;
+
+sources_t sources = {0};
+
+source_t *new_source(const char *filename, string_view_t contents) {
+  if (sources.count >= UINT16_MAX) {
+    printf("Too many source files (at most %d).\n", UINT16_MAX);
+    exit(1);
+  }
+  if (contents.length > UINT32_MAX) {
+    printf("Source file '%s' is too large (at most 4GiB).\n", filename);
+    exit(1);
+  }
+  source_t *src = malloc(sizeof(source_t));
+  *src = (source_t){sources.count + 1, filename, contents, NULL, 0, false};
+  da_append(&sources, src);
+  return src;
+}
+
+// Reads a file that cannot be mapped until its end.
+bool read_whole_fd(int fd, string_view_t *res) {
+  size_t capacity = 4096;
+  size_t length = 0;
+  char *buf = malloc(capacity);
+  while (true) {
+    if (length == capacity) {
+      capacity *= 2;
+      buf = realloc(buf, capacity);
+    }
+    ssize_t n = read(fd, buf + length, capacity - length);
+    if (n < 0 && errno == EINTR)
+      continue;
+    if (n < 0) {
+      free(buf);
+      return false;
+    }
+    if (n == 0)
+      break;
+    length += n;
+  }
+  *res = (string_view_t){buf, length};
+  return true;
+}
+
+source_t *load_source(const char *filename) {
+  int fd = open(filename, O_RDONLY);
+  if (fd < 0)
+    return NULL;
+  struct stat st;
+  if (fstat(fd, &st) < 0) {
+    int err = errno;
+    close(fd);
+    errno = err;
+    return NULL;
+  }
+  string_view_t contents = {0};
+  bool mapped = false;
+  if (S_ISREG(st.st_mode) && st.st_size > 0) {
+    void *p = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (p != MAP_FAILED) {
+      contents = (string_view_t){p, st.st_size};
+      mapped = true;
+    }
+  }
+  if (!mapped && !read_whole_fd(fd, &contents)) {
+    int err = errno;
+    close(fd);
+    errno = err;
+    return NULL;
+  }
+  // The mapping outlives the descriptor.
+  close(fd);
+  source_t *src = new_source(filename, contents);
+  src->mapped = mapped;
+  return src;
+}
+
+void free_sources(void) {
+  for (size_t i = 0; i < sources.count; i++) {
+    source_t *src = sources.items[i];
+    if (src->mapped)
+      munmap(src->contents.contents, src->contents.length);
+    free(src->line_starts);
+    free(src);
+  }
+  free(sources.items);
+  sources = (sources_t){0};
+}
+
+source_t *get_source(uint16_t id) {
+  if (id == 0 || id > sources.count)
+    return NULL;
+  return sources.items[id - 1];
+}
+
+void build_line_starts(source_t *src) {
+  line_starts_t starts = {0};
+  da_append(&starts, 0);
+  const char *begin = src->contents.contents;
+  const char *end = begin + src->contents.length;
+  const char *p = begin;
+  while (p < end && (p = memchr(p, '\n', end - p)) != NULL) {
+    p++;
+    da_append(&starts, (size_t)(p - begin));
+  }
+  src->line_starts = starts.items;
+  src->line_count = starts.count;
+}
+
+void source_line_col(source_t *src, size_t offset, int *line, int *col) {
+  if (src->line_starts == NULL)
+    build_line_starts(src);
+  // Last line starting at or before the offset.
+  size_t lo = 0;
+  size_t hi = src->line_count;
+  while (hi - lo > 1) {
+    size_t mid = lo + (hi - lo) / 2;
+    if (src->line_starts[mid] <= offset)
+      lo = mid;
+    else
+      hi = mid;
+  }
+  *line = lo + 1;
+  *col = offset - src->line_starts[lo] + 1;
+}
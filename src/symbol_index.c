@@ -0,0 +1,109 @@
+/**
+ * symbol_index.c
+ * Copyright (C) 2024 Paul Passeron
+ * SYMBOL_INDEX source file
+ * Paul Passeron <paul.passeron2@gmail.com>
+ */
+
+#include "../include/symbol_index.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+size_t symbol_hash(symbol_index_t *ix, const void *key) {
+  if (ix->by_address) {
+    // Interned names are packed byte after byte: mix every address bit into
+    // the low ones that pick the slot.
+    uint64_t h = (uintptr_t)key;
+    h = (h ^ (h >> 33)) * 0xff51afd7ed558ccdULL;
+    return h ^ (h >> 33);
+  }
+  uint64_t h = 14695981039346656037ULL;
+  for (const unsigned char *c = key; *c; c++) {
+    h = (h ^ *c) * 1099511628211ULL;
+  }
+  return h;
+}
+
+bool symbol_key_eq(symbol_index_t *ix, const void *a, const void *b) {
+  return ix->by_address ? a == b : strcmp(a, b) == 0;
+}
+
+// Slot of a key, or the empty slot where it would go.
+symbol_slot_t *symbol_slot(symbol_index_t *ix, const void *key) {
+  size_t i = symbol_hash(ix, key) & (ix->slot_count - 1);
+  while (ix->slots[i].newest != 0 && !symbol_key_eq(ix, ix->slots[i].key, key))
+    i = (i + 1) & (ix->slot_count - 1);
+  return &ix->slots[i];
+}
+
+void symbol_rehash(symbol_index_t *ix) {
+  symbol_slot_t *old = ix->slots;
+  size_t old_count = ix->slot_count;
+  ix->slot_count = old_count == 0 ? 256 : old_count * 2;
+  ix->slots = calloc(ix->slot_count, sizeof(symbol_slot_t));
+  if (ix->slots == NULL) {
+    perror("Allocation failed");
+    exit(1);
+  }
+  for (size_t i = 0; i < old_count; i++) {
+    if (old[i].newest != 0)
+      *symbol_slot(ix, old[i].key) = old[i];
+  }
+  free(old);
+}
+
+void symbol_index_add(symbol_index_t *ix, const void *key, size_t entry) {
+  if (2 * (ix->used + 1) > ix->slot_count)
+    symbol_rehash(ix);
+  if (entry >= ix->older_capacity) {
+    size_t capacity = ix->older_capacity == 0 ? 256 : ix->older_capacity;
+    while (capacity <= entry)
+      capacity *= 2;
+    ix->older = realloc(ix->older, capacity * sizeof(size_t));
+    if (ix->older == NULL) {
+      perror("Reallocation failed");
+      exit(1);
+    }
+    ix->older_capacity = capacity;
+  }
+  symbol_slot_t *slot = symbol_slot(ix, key);
+  if (slot->newest == 0) {
+    *slot = (symbol_slot_t){key, entry + 1, entry + 1};
+    ix->older[entry] = 0;
+    ix->used++;
+    return;
+  }
+  ix->older[entry] = slot->newest;
+  slot->newest = entry + 1;
+}
+
+size_t symbol_index_newest(symbol_index_t *ix, const void *key) {
+  if (ix->slot_count == 0)
+    return SYMBOL_NONE;
+  return symbol_slot(ix, key)->newest - 1;
+}
+
+size_t symbol_index_oldest(symbol_index_t *ix, const void *key) {
+  if (ix->slot_count == 0)
+    return SYMBOL_NONE;
+  symbol_slot_t *slot = symbol_slot(ix, key);
+  return slot->newest == 0 ? SYMBOL_NONE : slot->oldest - 1;
+}
+
+size_t symbol_index_older(symbol_index_t *ix, size_t entry) {
+  return ix->older[entry] - 1;
+}
+
+void symbol_index_clear(symbol_index_t *ix) {
+  if (ix->slots != NULL)
+    memset(ix->slots, 0, ix->slot_count * sizeof(symbol_slot_t));
+  ix->used = 0;
+}
+
+void symbol_index_free(symbol_index_t *ix) {
+  free(ix->slots);
+  free(ix->older);
+  *ix = (symbol_index_t){ix->by_address, NULL, 0, 0, NULL, 0};
+}
@@ -7,76 +7,114 @@
 
 #include "../include/unilang_lexer.h"
 
-lexer_t new_unilang_lexer() {
-  lexer_t l = {0};
-  l.rules = new_rules();
-  add_rule_to_lexer(&l, SV("let"), KEY_LET);
-  add_rule_to_lexer(&l, SV("let"), KEY_LET);
-  add_rule_to_lexer(&l, SV("if"), KEY_IF);
-  add_rule_to_lexer(&l, SV("else"), KEY_ELSE);
-  add_rule_to_lexer(&l, SV("while"), KEY_WHILE);
-  add_rule_to_lexer(&l, SV("loop"), KEY_LOOP);
-  add_rule_to_lexer(&l, SV("return"), KEY_RETURN);
-  add_rule_to_lexer(&l, SV("defer"), KEY_DEFER);
-  add_rule_to_lexer(&l, SV("sum"), KEY_SUM);
-  add_rule_to_lexer(&l, SV("class"), KEY_CLASS);
-  add_rule_to_lexer(&l, SV("\'\\\\000\'"), CHARLIT);
-  add_rule_to_lexer(&l, SV("\'\\\\?\'"), CHARLIT);
-  add_rule_to_lexer(&l, SV("\'?\'"), CHARLIT);
-  add_rule_to_lexer(&l, SV("\"*\""), STRLIT);
-  add_bad_rule_to_lexer(&l, SV("/\\*"), SV("Unmatched multi-line comment."));
-  add_bad_rule_to_lexer(&l, SV("\""), SV("Unmatched string literal start."));
-  add_bad_rule_to_lexer(&l, SV("\'"), SV("Unmatched char literal start."));
-  add_rule_to_lexer(&l, SV("@[a-zA-Z_-_]([a-zA-Z_-_0-9])"), DIRECTIVE);
-  add_rule_to_lexer(&l, SV("\\*"), MULT);
-  add_rule_to_lexer(&l, SV("+"), PLUS);
-  add_rule_to_lexer(&l, SV("/"), DIV);
-  add_rule_to_lexer(&l, SV("%"), MODULO);
-  add_rule_to_lexer(&l, SV("<="), LEQ);
-  add_rule_to_lexer(&l, SV("<"), LT);
-  add_rule_to_lexer(&l, SV(">="), GEQ);
-  add_rule_to_lexer(&l, SV(">"), GT);
-  add_rule_to_lexer(&l, SV("::"), ACCESS);
-  add_rule_to_lexer(&l, SV(";"), SEMICOLON);
-  add_rule_to_lexer(&l, SV(":"), COLON);
-  add_rule_to_lexer(&l, SV("=>"), BIG_ARROW);
-  add_rule_to_lexer(&l, SV("="), EQ);
-  add_rule_to_lexer(&l, SV("!="), DIFF);
-  add_rule_to_lexer(&l, SV("&&"), AND);
-  add_rule_to_lexer(&l, SV("&"), BIT_AND);
-  add_rule_to_lexer(&l, SV("||"), OR);
-  add_rule_to_lexer(&l, SV("|"), BIT_OR);
-  add_rule_to_lexer(&l, SV("^"), BIT_XOR);
-  add_rule_to_lexer(&l, SV("!"), NOT);
-  add_rule_to_lexer(&l, SV("$"), DEREF);
-  add_rule_to_lexer(&l, SV("\\("), OPEN_PAR);
-  add_rule_to_lexer(&l, SV("\\)"), CLOSE_PAR);
-  add_rule_to_lexer(&l, SV("\\["), OPEN_SQR);
-  add_rule_to_lexer(&l, SV("\\]"), CLOSE_SQR);
-  add_rule_to_lexer(&l, SV("{"), OPEN_BRA);
-  add_rule_to_lexer(&l, SV("}"), CLOSE_BRA);
-  add_rule_to_lexer(&l, SV("->"), SMALL_ARR);
-  add_rule_to_lexer(&l, SV("0b[0-1]([0-1])"), INTLIT);
-  add_rule_to_lexer(&l, SV("0x[0-9a-fA-F]([0-9a-fA-F])"), INTLIT);
-  add_rule_to_lexer(&l, SV("[0-9]([0-9]).[0-9]([0-9])f"), FLOATLIT);
-  add_rule_to_lexer(&l, SV("[0-9]([0-9]).[0-9]([0-9])"), FLOATLIT);
-  add_rule_to_lexer(&l, SV("[0-9]([0-9])f"), FLOATLIT);
-  add_rule_to_lexer(&l, SV("[0-9]([0-9])"), INTLIT);
-  add_rule_to_lexer(&l, SV("-[0-9]([0-9]).[0-9]([0-9])f"), FLOATLIT);
-  add_rule_to_lexer(&l, SV("-[0-9]([0-9]).[0-9]([0-9])"), FLOATLIT);
-  add_rule_to_lexer(&l, SV("-[0-9]([0-9])f"), FLOATLIT);
-  add_rule_to_lexer(&l, SV("-[0-9]([0-9])"), INTLIT);
-  add_rule_to_lexer(&l, SV("-"), MINUS);
-  add_rule_to_lexer(&l, SV(","), COMMA);
-  add_rule_to_lexer(&l, SV("[a-zA-Z_-_]([a-zA-Z_-_0-9])"), IDENTIFIER);
-  add_skip_rule_to_lexer(&l, SV(" "));
-  add_skip_rule_to_lexer(&l, SV("//*\n"));
-  add_skip_rule_to_lexer(&l, SV("\n"));
-  add_skip_rule_to_lexer(&l, SV("\t"));
-  add_skip_rule_to_lexer(&l, SV("\b"));
-  add_skip_rule_to_lexer(&l, SV("/\\**\\*/"));
+lexer_rules_t unilang_rules = {0};
 
-  return l;
+// Built and compiled once, every unilang lexer shares them.
+lexer_rules_t *get_unilang_rules(void) {
+  if (unilang_rules.dfa != NULL)
+    return &unilang_rules;
+  lexer_rules_t *r = &unilang_rules;
+  *r = new_rules();
+  add_lexer_rule(r, SV("\'\\\\000\'"), CHARLIT);
+  add_lexer_rule(r, SV("\'\\\\?\'"), CHARLIT);
+  add_lexer_rule(r, SV("\'?\'"), CHARLIT);
+  add_lexer_rule(r, SV("\"*\""), STRLIT);
+  add_bad_lexer_rule(r, SV("/\\*"), SV("Unmatched multi-line comment."));
+  add_bad_lexer_rule(r, SV("\""), SV("Unmatched string literal start."));
+  add_bad_lexer_rule(r, SV("\'"), SV("Unmatched char literal start."));
+  add_lexer_rule(r, SV("@[a-zA-Z_-_]([a-zA-Z_-_0-9])"), DIRECTIVE);
+  add_lexer_rule(r, SV("\\*"), MULT);
+  add_lexer_rule(r, SV("+"), PLUS);
+  add_lexer_rule(r, SV("/"), DIV);
+  add_lexer_rule(r, SV("%"), MODULO);
+  add_lexer_rule(r, SV("<="), LEQ);
+  add_lexer_rule(r, SV("<"), LT);
+  add_lexer_rule(r, SV(">="), GEQ);
+  add_lexer_rule(r, SV(">"), GT);
+  add_lexer_rule(r, SV("::"), ACCESS);
+  add_lexer_rule(r, SV(";"), SEMICOLON);
+  add_lexer_rule(r, SV(":"), COLON);
+  add_lexer_rule(r, SV("=>"), BIG_ARROW);
+  add_lexer_rule(r, SV("="), EQ);
+  add_lexer_rule(r, SV("!="), DIFF);
+  add_lexer_rule(r, SV("&&"), AND);
+  add_lexer_rule(r, SV("&"), BIT_AND);
+  add_lexer_rule(r, SV("||"), OR);
+  add_lexer_rule(r, SV("|"), BIT_OR);
+  add_lexer_rule(r, SV("^"), BIT_XOR);
+  add_lexer_rule(r, SV("!"), NOT);
+  add_lexer_rule(r, SV("$"), DEREF);
+  add_lexer_rule(r, SV("\\("), OPEN_PAR);
+  add_lexer_rule(r, SV("\\)"), CLOSE_PAR);
+  add_lexer_rule(r, SV("\\["), OPEN_SQR);
+  add_lexer_rule(r, SV("\\]"), CLOSE_SQR);
+  add_lexer_rule(r, SV("{"), OPEN_BRA);
+  add_lexer_rule(r, SV("}"), CLOSE_BRA);
+  add_lexer_rule(r, SV("->"), SMALL_ARR);
+  add_lexer_rule(r, SV("0b[0-1]([0-1])"), INTLIT);
+  add_lexer_rule(r, SV("0x[0-9a-fA-F]([0-9a-fA-F])"), INTLIT);
+  add_lexer_rule(r, SV("[0-9]([0-9]).[0-9]([0-9])f"), FLOATLIT);
+  add_lexer_rule(r, SV("[0-9]([0-9]).[0-9]([0-9])"), FLOATLIT);
+  add_lexer_rule(r, SV("[0-9]([0-9])f"), FLOATLIT);
+  add_lexer_rule(r, SV("[0-9]([0-9])"), INTLIT);
+  add_lexer_rule(r, SV("-[0-9]([0-9]).[0-9]([0-9])f"), FLOATLIT);
+  add_lexer_rule(r, SV("-[0-9]([0-9]).[0-9]([0-9])"), FLOATLIT);
+  add_lexer_rule(r, SV("-[0-9]([0-9])f"), FLOATLIT);
+  add_lexer_rule(r, SV("-[0-9]([0-9])"), INTLIT);
+  add_lexer_rule(r, SV("-"), MINUS);
+  add_lexer_rule(r, SV(","), COMMA);
+  add_lexer_rule(r, SV("[a-zA-Z_-_]([a-zA-Z_-_0-9])"), IDENTIFIER);
+  add_skip_lexer_rule(r, SV(" "));
+  add_skip_lexer_rule(r, SV("//*\n"));
+  add_skip_lexer_rule(r, SV("\n"));
+  add_skip_lexer_rule(r, SV("\t"));
+  add_skip_lexer_rule(r, SV("\b"));
+  add_skip_lexer_rule(r, SV("/\\**\\*/"));
+  set_rules_classifier(r, &unilang_keyword_kind);
+  compile_rules(r);
+  return r;
+}
+
+lexer_t new_unilang_lexer() { return new_lexer(get_unilang_rules()); }
+
+typedef struct keyword_t {
+  string_view_t lexeme;
+  int kind;
+} keyword_t;
+
+#define KEYWORD_SLOTS 16
+#define KEYWORD_HASH(len, first, last)                                         \
+  (((len) + 9 * (first) + 2 * (last)) % KEYWORD_SLOTS)
+
+// Perfect hash table of the keywords: no two of them share a KEYWORD_HASH
+// slot.
+const keyword_t keywords[KEYWORD_SLOTS] = {
+    [0] = {{"loop", 4}, KEY_LOOP},
+    [1] = {{"private", 7}, KEY_PRIVATE},
+    [2] = {{"true", 4}, KEY_TRUE},
+    [4] = {{"return", 6}, KEY_RETURN},
+    [5] = {{"false", 5}, KEY_FALSE},
+    [6] = {{"class", 5}, KEY_CLASS},
+    [7] = {{"let", 3}, KEY_LET},
+    [8] = {{"sum", 3}, KEY_SUM},
+    [11] = {{"else", 4}, KEY_ELSE},
+    [12] = {{"public", 6}, KEY_PUBLIC},
+    [13] = {{"defer", 5}, KEY_DEFER},
+    [14] = {{"while", 5}, KEY_WHILE},
+    [15] = {{"if", 2}, KEY_IF},
+};
+
+// Identifiers are scanned by a single rule and then looked up here, so
+// keywords never match a prefix of a longer identifier.
+int unilang_keyword_kind(string_view_t lexeme, int kind) {
+  if (kind != IDENTIFIER)
+    return kind;
+  unsigned char first = lexeme.contents[0];
+  unsigned char last = lexeme.contents[lexeme.length - 1];
+  keyword_t k = keywords[KEYWORD_HASH(lexeme.length, first, last)];
+  if (k.lexeme.contents != NULL && sv_eq(lexeme, k.lexeme))
+    return k.kind;
+  return kind;
 }
 
 const char *human_token_kind(int kind) {
@@ -103,6 +141,14 @@ const char *human_token_kind(int kind) {
     return "KEY_SUM";
   case KEY_CLASS:
     return "KEY_CLASS";
+  case KEY_TRUE:
+    return "KEY_TRUE";
+  case KEY_FALSE:
+    return "KEY_FALSE";
+  case KEY_PUBLIC:
+    return "KEY_PUBLIC";
+  case KEY_PRIVATE:
+    return "KEY_PRIVATE";
   case MULT:
     return "MULT";
   case PLUS:
@@ -177,11 +223,13 @@ const char *human_token_kind(int kind) {
 }
 
 void dump_token(token_t token) {
-  print_location_t(stdout, token.location);
-  printf("\'" SF "\' %s", SA(token.lexeme), human_token_kind(token.kind));
+  print_location_t(stdout, token_location(token));
+  printf("\'" SF "\' %s", SA(token_lexeme(token)),
+         human_token_kind(token.kind));
 }
 
 void fdump_token(FILE *f, token_t token) {
-  print_location_t(f, token.location);
-  fprintf(f, "\'" SF "\' %s", SA(token.lexeme), human_token_kind(token.kind));
+  print_location_t(f, token_location(token));
+  fprintf(f, "\'" SF "\' %s", SA(token_lexeme(token)),
+          human_token_kind(token.kind));
 }
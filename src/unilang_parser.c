@@ -1,12 +1,14 @@
 #include "../include/unilang_parser.h"
+#include <string.h>
+#include <time.h>
 token_t *parse_token_lexeme(lexer_t *l, int *worked, string_view_t lexeme) {
   token_t tok = next(l);
   *worked = 0;
   if (is_error_tok(tok)) {
     return NULL;
   }
-  if (sv_eq(tok.lexeme, lexeme)) {
-    token_t *res = malloc(sizeof(token_t));
+  if (sv_eq(token_lexeme(tok), lexeme)) {
+    token_t *res = ast_alloc(sizeof(token_t));
     *res = tok;
     *worked = 1;
     return res;
@@ -21,7 +23,7 @@ token_t *parse_token_kind(lexer_t *l, int *worked, int kind) {
     return NULL;
   }
   if (tok.kind == kind) {
-    token_t *res = malloc(sizeof(token_t));
+    token_t *res = ast_alloc(sizeof(token_t));
     *res = tok;
     *worked = 1;
     return res;
@@ -29,6 +31,376 @@ token_t *parse_token_kind(lexer_t *l, int *worked, int kind) {
   return NULL;
 }
 
+
+#ifdef PPARSER_MEMO
+typedef enum rule_id_t {
+  RULE_IDENTIFIER,
+  RULE_INTLIT,
+  RULE_FLOATLIT,
+  RULE_CHARLIT,
+  RULE_STRINGLIT,
+  RULE_BOOLLIT,
+  RULE_LITERAL,
+  RULE_PARAM,
+  RULE_ARGLIST,
+  RULE_FUNCALLARGS,
+  RULE_SIZE_DIR,
+  RULE_CAST_LIKE_DIR,
+  RULE_LEAF,
+  RULE_EXPR,
+  RULE_STMT,
+  RULE_DECL,
+  RULE_BINOP,
+  RULE_PAREN,
+  RULE_STARLIST,
+  RULE_TYPE,
+  RULE_UNARY,
+  RULE_STMT_LIST,
+  RULE_COMPOUND,
+  RULE_PROGRAM_LIST,
+  RULE_PROGRAM,
+  RULE_TEMPELEM,
+  RULE_TEMPLIST,
+  RULE_TEMPLATE,
+  RULE_TLIST,
+  RULE_INST_TEMPLATE,
+  RULE_FUNDEF_LETLESS,
+  RULE_FUNDEF,
+  RULE_UOP,
+  RULE_VARDEF_LETLESS,
+  RULE_VARDEF,
+  RULE_CT_CTE,
+  RULE_ACCESS_SPEC,
+  RULE_ABSTRACT_OPT,
+  RULE_STATIC_OPT,
+  RULE_CLASS_BODY,
+  RULE_CLASS_CONSTRUCTOR,
+  RULE_CLASS_BODY_ITEM,
+  RULE_CLASS_DECL,
+  RULE_IF_STATEMENT,
+  RULE_WHILE_STMT,
+  RULE_ASSIGNEMENT,
+  RULE_RETURN,
+  RULE_INCLUDE_DIR,
+  RULE_PROTO,
+  RULE_PROTO_LIST,
+  RULE_INTERFACE,
+  RULE_COUNT,
+} rule_id_t;
+
+#ifdef PPARSER_STATS
+const char *rule_names[RULE_COUNT] = {
+    "identifier",
+    "intlit",
+    "floatlit",
+    "charlit",
+    "stringlit",
+    "boollit",
+    "literal",
+    "param",
+    "arglist",
+    "funcallargs",
+    "size_dir",
+    "cast_like_dir",
+    "leaf",
+    "expr",
+    "stmt",
+    "decl",
+    "binop",
+    "paren",
+    "starlist",
+    "type",
+    "unary",
+    "stmt_list",
+    "compound",
+    "program_list",
+    "program",
+    "tempelem",
+    "templist",
+    "template",
+    "tlist",
+    "inst_template",
+    "fundef_letless",
+    "fundef",
+    "uop",
+    "vardef_letless",
+    "vardef",
+    "ct_cte",
+    "access_spec",
+    "abstract_opt",
+    "static_opt",
+    "class_body",
+    "class_constructor",
+    "class_body_item",
+    "class_decl",
+    "if_statement",
+    "while_stmt",
+    "assignement",
+    "return",
+    "include_dir",
+    "proto",
+    "proto_list",
+    "interface",
+};
+
+bool pparser_stats_enabled = false;
+_Thread_local pparser_rule_stats_t pparser_rule_stats[RULE_COUNT] = {0};
+
+// Time spent in the rules called by the rule being timed.
+_Thread_local uint64_t rule_children_ns = 0;
+
+size_t pparser_rule_count(void) { return RULE_COUNT; }
+
+const char *pparser_rule_name(size_t rule) { return rule_names[rule]; }
+
+uint64_t rule_clock_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
+
+void count_memo_hit(rule_id_t rule, bool parsed) {
+  if (!pparser_stats_enabled)
+    return;
+  pparser_rule_stats_t *s = &pparser_rule_stats[rule];
+  s->calls++;
+  s->memo_hits++;
+  if (parsed)
+    s->successes++;
+  else
+    s->failures++;
+}
+
+// Tokens looked at by a failing rule are found with lexer_lookahead, put back
+// afterwards for the callers that rely on it.
+void *timed_parse(lexer_t *l, int *worked, rule_id_t rule,
+                  void *(*parse)(lexer_t *, int *)) {
+  if (!pparser_stats_enabled)
+    return parse(l, worked);
+  pparser_rule_stats_t *s = &pparser_rule_stats[rule];
+  size_t pos = l->token_index;
+  size_t lookahead = lexer_lookahead;
+  uint64_t children = rule_children_ns;
+  lexer_lookahead = pos;
+  rule_children_ns = 0;
+  uint64_t start = rule_clock_ns();
+  void *res = parse(l, worked);
+  uint64_t elapsed = rule_clock_ns() - start;
+  s->calls++;
+  s->total_ns += elapsed;
+  s->self_ns += elapsed - rule_children_ns;
+  rule_children_ns = children + elapsed;
+  if (*worked) {
+    s->successes++;
+  } else {
+    s->failures++;
+    s->failed_tokens += lexer_lookahead - pos;
+  }
+  if (lexer_lookahead < lookahead)
+    lexer_lookahead = lookahead;
+  return res;
+}
+#else
+#define count_memo_hit(rule, parsed)
+#define timed_parse(l, worked, rule, parse) (parse)(l, worked)
+#endif
+
+typedef enum memo_state_t {
+  MEMO_UNKNOWN,
+  MEMO_FAILED,
+  MEMO_PARSED,
+} memo_state_t;
+
+typedef struct memo_entry_t {
+  rule_id_t rule;
+  size_t pos;
+  memo_state_t state;
+  void *res;
+  size_t end;
+} memo_entry_t;
+
+// Outcome of every rule tried at every token position of one token buffer.
+// A cached result is handed out again until an alternative or a list that got
+// it succeeds: actions take ownership of their elements and may reuse them.
+typedef struct memo_table_t {
+  tokens_t *tokens;
+  memo_entry_t *entries;
+  size_t count;
+  size_t capacity;
+  size_t *slots; // open addressing: entry index + 1, 0 if empty
+  size_t slot_count;
+  size_t *pending; // entries handed out and not taken yet
+  size_t pending_count;
+  size_t pending_capacity;
+} memo_table_t;
+
+// Per thread, like every parser global: the top-level declarations of a
+// program may be parsed concurrently, see parse_program_parallel().
+_Thread_local memo_table_t memo = {0};
+
+void pparser_memo_clear(void) {
+  free(memo.entries);
+  free(memo.slots);
+  free(memo.pending);
+  memo = (memo_table_t){0};
+}
+
+size_t memo_slot(rule_id_t rule, size_t pos) {
+  size_t h = (pos * RULE_COUNT + rule) * 2654435761u;
+  return h & (memo.slot_count - 1);
+}
+
+void memo_rehash(void) {
+  free(memo.slots);
+  memo.slot_count = memo.slot_count == 0 ? 1024 : memo.slot_count * 2;
+  memo.slots = calloc(memo.slot_count, sizeof(size_t));
+  if (memo.slots == NULL) {
+    perror("Allocation failed");
+    exit(1);
+  }
+  for (size_t i = 0; i < memo.count; i++) {
+    size_t slot = memo_slot(memo.entries[i].rule, memo.entries[i].pos);
+    while (memo.slots[slot]) {
+      slot = (slot + 1) & (memo.slot_count - 1);
+    }
+    memo.slots[slot] = i + 1;
+  }
+}
+
+// Returns the index of the entry of rule at the current position of l,
+// adding an unknown one if needed.
+size_t memo_lookup(lexer_t *l, rule_id_t rule) {
+  if (memo.tokens != l->state->tokens) {
+    pparser_memo_clear();
+    memo.tokens = l->state->tokens;
+  }
+  if (2 * (memo.count + 1) > memo.slot_count) {
+    memo_rehash();
+  }
+  size_t pos = l->token_index;
+  size_t slot = memo_slot(rule, pos);
+  while (memo.slots[slot]) {
+    memo_entry_t e = memo.entries[memo.slots[slot] - 1];
+    if (e.rule == rule && e.pos == pos) {
+      return memo.slots[slot] - 1;
+    }
+    slot = (slot + 1) & (memo.slot_count - 1);
+  }
+  if (memo.count >= memo.capacity) {
+    memo.capacity = memo.capacity == 0 ? 256 : memo.capacity * 2;
+    memo.entries = realloc(memo.entries, memo.capacity * sizeof(memo_entry_t));
+    if (memo.entries == NULL) {
+      perror("Reallocation failed");
+      exit(1);
+    }
+  }
+  memo.entries[memo.count] = (memo_entry_t){rule, pos, MEMO_UNKNOWN, NULL, 0};
+  memo.slots[slot] = ++memo.count;
+  return memo.count - 1;
+}
+
+void memo_hand_out(size_t entry) {
+  if (memo.pending_count >= memo.pending_capacity) {
+    memo.pending_capacity =
+        memo.pending_capacity == 0 ? 64 : memo.pending_capacity * 2;
+    memo.pending =
+        realloc(memo.pending, memo.pending_capacity * sizeof(size_t));
+    if (memo.pending == NULL) {
+      perror("Reallocation failed");
+      exit(1);
+    }
+  }
+  memo.pending[memo.pending_count++] = entry;
+}
+
+void *memo_parse(lexer_t *l, int *worked, rule_id_t rule,
+                 void *(*parse)(lexer_t *, int *)) {
+  if (l->state->tokens == NULL) {
+    return timed_parse(l, worked, rule, parse);
+  }
+  size_t entry = memo_lookup(l, rule);
+  memo_entry_t e = memo.entries[entry];
+  if (e.state == MEMO_FAILED) {
+    count_memo_hit(rule, false);
+    *worked = 0;
+    return NULL;
+  }
+  if (e.state == MEMO_PARSED) {
+    count_memo_hit(rule, true);
+    lexer_seek(l, e.end);
+    memo_hand_out(entry);
+    *worked = 1;
+    return e.res;
+  }
+  size_t mark = memo.pending_count;
+  void *res = timed_parse(l, worked, rule, parse);
+  if (*worked) {
+    // Everything handed out while parsing is now owned by res
+    for (size_t i = mark; i < memo.pending_count; i++) {
+      memo.entries[memo.pending[i]].state = MEMO_UNKNOWN;
+    }
+  }
+  memo.pending_count = mark;
+  memo.entries[entry].state = *worked ? MEMO_PARSED : MEMO_FAILED;
+  memo.entries[entry].res = *worked ? res : NULL;
+  memo.entries[entry].end = l->token_index;
+  if (*worked) {
+    memo_hand_out(entry);
+  }
+  return res;
+}
+#endif
+
+// Elements of the @list rules being parsed, innermost list on top. A list
+// keeps its elements here until it is done, and then gets an exact-size copy
+// in the AST arena: the stack grows geometrically and is reused by every list.
+typedef struct list_stack_t {
+  void **items;
+  size_t count;
+  size_t capacity;
+} list_stack_t;
+
+_Thread_local list_stack_t list_stack = {0};
+_Thread_local pparser_list_stats_t pparser_list_stats = {0};
+
+void list_push(void *elem) {
+  if (list_stack.count >= list_stack.capacity) {
+    list_stack.capacity =
+        list_stack.capacity == 0 ? 256 : list_stack.capacity * 2;
+    list_stack.items =
+        realloc(list_stack.items, list_stack.capacity * sizeof(void *));
+    if (list_stack.items == NULL) {
+      perror("Reallocation failed");
+      exit(1);
+    }
+    pparser_list_stats.grows++;
+  }
+  list_stack.items[list_stack.count++] = elem;
+  if (list_stack.count > pparser_list_stats.peak) {
+    pparser_list_stats.peak = list_stack.count;
+  }
+}
+
+// Pops the elements pushed since base, as a NULL-terminated array.
+void **list_pop(size_t base) {
+  size_t count = list_stack.count - base;
+  void **res = ast_alloc((count + 1) * sizeof(void *));
+  memcpy(res, list_stack.items + base, count * sizeof(void *));
+  res[count] = NULL;
+  list_stack.count = base;
+  pparser_list_stats.lists++;
+  pparser_list_stats.elems += count;
+  return res;
+}
+
+void pparser_free_thread_buffers(void) {
+#ifdef PPARSER_MEMO
+  pparser_memo_clear();
+#endif
+  free(list_stack.items);
+  list_stack = (list_stack_t){0};
+  free_expr_frames();
+}
 // RULE identifier
 void *parse_identifier_c0(lexer_t *l, int *worked);
 
@@ -255,7 +627,7 @@ void *parse_interface_c0(lexer_t *l, int *worked);
 void *parse_interface_c1(lexer_t *l, int *worked);
 
 // RULE identifier
-void *parse_identifier(lexer_t *l, int *worked) {
+void *parse_identifier_impl(lexer_t *l, int *worked) {
   *worked = 0;
   int rule_worked = 0;
   void *rule_res = NULL;
@@ -268,9 +640,16 @@ void *parse_identifier(lexer_t *l, int *worked) {
   }
   return NULL;
 }
+void *parse_identifier(lexer_t *l, int *worked) {
+#ifdef PPARSER_MEMO
+  return memo_parse(l, worked, RULE_IDENTIFIER, parse_identifier_impl);
+#else
+  return parse_identifier_impl(l, worked);
+#endif
+}
 
 // RULE intlit
-void *parse_intlit(lexer_t *l, int *worked) {
+void *parse_intlit_impl(lexer_t *l, int *worked) {
   *worked = 0;
   int rule_worked = 0;
   void *rule_res = NULL;
@@ -283,9 +662,16 @@ void *parse_intlit(lexer_t *l, int *worked) {
   }
   return NULL;
 }
+void *parse_intlit(lexer_t *l, int *worked) {
+#ifdef PPARSER_MEMO
+  return memo_parse(l, worked, RULE_INTLIT, parse_intlit_impl);
+#else
+  return parse_intlit_impl(l, worked);
+#endif
+}
 
 // RULE floatlit
-void *parse_floatlit(lexer_t *l, int *worked) {
+void *parse_floatlit_impl(lexer_t *l, int *worked) {
   *worked = 0;
   int rule_worked = 0;
   void *rule_res = NULL;
@@ -298,9 +684,16 @@ void *parse_floatlit(lexer_t *l, int *worked) {
   }
   return NULL;
 }
+void *parse_floatlit(lexer_t *l, int *worked) {
+#ifdef PPARSER_MEMO
+  return memo_parse(l, worked, RULE_FLOATLIT, parse_floatlit_impl);
+#else
+  return parse_floatlit_impl(l, worked);
+#endif
+}
 
 // RULE charlit
-void *parse_charlit(lexer_t *l, int *worked) {
+void *parse_charlit_impl(lexer_t *l, int *worked) {
   *worked = 0;
   int rule_worked = 0;
   void *rule_res = NULL;
@@ -313,9 +706,16 @@ void *parse_charlit(lexer_t *l, int *worked) {
   }
   return NULL;
 }
+void *parse_charlit(lexer_t *l, int *worked) {
+#ifdef PPARSER_MEMO
+  return memo_parse(l, worked, RULE_CHARLIT, parse_charlit_impl);
+#else
+  return parse_charlit_impl(l, worked);
+#endif
+}
 
 // RULE stringlit
-void *parse_stringlit(lexer_t *l, int *worked) {
+void *parse_stringlit_impl(lexer_t *l, int *worked) {
   *worked = 0;
   int rule_worked = 0;
   void *rule_res = NULL;
@@ -328,74 +728,145 @@ void *parse_stringlit(lexer_t *l, int *worked) {
   }
   return NULL;
 }
+void *parse_stringlit(lexer_t *l, int *worked) {
+#ifdef PPARSER_MEMO
+  return memo_parse(l, worked, RULE_STRINGLIT, parse_stringlit_impl);
+#else
+  return parse_stringlit_impl(l, worked);
+#endif
+}
 
 // RULE boollit
-void *parse_boollit(lexer_t *l, int *worked) {
+void *parse_boollit_impl(lexer_t *l, int *worked) {
   *worked = 0;
   int rule_worked = 0;
   void *rule_res = NULL;
-  lexer_t rule_cpy = *l;
-  rule_res = parse_boollit_c0(&rule_cpy, &rule_worked);
-  if (rule_worked) {
-    *worked = 1;
-    *l = rule_cpy;
-    return rule_res;
+  // Alternatives that can start with the next token
+  int viable;
+  switch (peek_kind(l)) {
+  case KEY_TRUE:
+    viable = 1 << 0;
+    break;
+  case KEY_FALSE:
+    viable = 1 << 1;
+    break;
+  default:
+    return NULL;
+  }
+  lexer_t rule_cpy;
+  if (viable & (1 << 0)) {
+    rule_cpy = *l;
+    rule_res = parse_boollit_c0(&rule_cpy, &rule_worked);
+    if (rule_worked) {
+      *worked = 1;
+      *l = rule_cpy;
+      return rule_res;
+    }
   }
-  rule_cpy = *l;
-  rule_res = parse_boollit_c1(&rule_cpy, &rule_worked);
-  if (rule_worked) {
-    *worked = 1;
-    *l = rule_cpy;
-    return rule_res;
+  if (viable & (1 << 1)) {
+    rule_cpy = *l;
+    rule_res = parse_boollit_c1(&rule_cpy, &rule_worked);
+    if (rule_worked) {
+      *worked = 1;
+      *l = rule_cpy;
+      return rule_res;
+    }
   }
   return NULL;
 }
+void *parse_boollit(lexer_t *l, int *worked) {
+#ifdef PPARSER_MEMO
+  return memo_parse(l, worked, RULE_BOOLLIT, parse_boollit_impl);
+#else
+  return parse_boollit_impl(l, worked);
+#endif
+}
 
 // RULE literal
-void *parse_literal(lexer_t *l, int *worked) {
+void *parse_literal_impl(lexer_t *l, int *worked) {
   *worked = 0;
   int rule_worked = 0;
   void *rule_res = NULL;
-  lexer_t rule_cpy = *l;
-  rule_res = parse_literal_c0(&rule_cpy, &rule_worked);
-  if (rule_worked) {
-    *worked = 1;
-    *l = rule_cpy;
-    return rule_res;
+  // Alternatives that can start with the next token
+  int viable;
+  switch (peek_kind(l)) {
+  case STRLIT:
+    viable = 1 << 3;
+    break;
+  case KEY_TRUE:
+  case KEY_FALSE:
+    viable = 1 << 4;
+    break;
+  case CHARLIT:
+    viable = 1 << 2;
+    break;
+  case INTLIT:
+    viable = 1 << 0;
+    break;
+  case FLOATLIT:
+    viable = 1 << 1;
+    break;
+  default:
+    return NULL;
+  }
+  lexer_t rule_cpy;
+  if (viable & (1 << 0)) {
+    rule_cpy = *l;
+    rule_res = parse_literal_c0(&rule_cpy, &rule_worked);
+    if (rule_worked) {
+      *worked = 1;
+      *l = rule_cpy;
+      return rule_res;
+    }
   }
-  rule_cpy = *l;
-  rule_res = parse_literal_c1(&rule_cpy, &rule_worked);
-  if (rule_worked) {
-    *worked = 1;
-    *l = rule_cpy;
-    return rule_res;
+  if (viable & (1 << 1)) {
+    rule_cpy = *l;
+    rule_res = parse_literal_c1(&rule_cpy, &rule_worked);
+    if (rule_worked) {
+      *worked = 1;
+      *l = rule_cpy;
+      return rule_res;
+    }
   }
-  rule_cpy = *l;
-  rule_res = parse_literal_c2(&rule_cpy, &rule_worked);
-  if (rule_worked) {
-    *worked = 1;
-    *l = rule_cpy;
-    return rule_res;
+  if (viable & (1 << 2)) {
+    rule_cpy = *l;
+    rule_res = parse_literal_c2(&rule_cpy, &rule_worked);
+    if (rule_worked) {
+      *worked = 1;
+      *l = rule_cpy;
+      return rule_res;
+    }
   }
-  rule_cpy = *l;
-  rule_res = parse_literal_c3(&rule_cpy, &rule_worked);
-  if (rule_worked) {
-    *worked = 1;
-    *l = rule_cpy;
-    return rule_res;
+  if (viable & (1 << 3)) {
+    rule_cpy = *l;
+    rule_res = parse_literal_c3(&rule_cpy, &rule_worked);
+    if (rule_worked) {
+      *worked = 1;
+      *l = rule_cpy;
+      return rule_res;
+    }
   }
-  rule_cpy = *l;
-  rule_res = parse_literal_c4(&rule_cpy, &rule_worked);
-  if (rule_worked) {
-    *worked = 1;
-    *l = rule_cpy;
-    return rule_res;
+  if (viable & (1 << 4)) {
+    rule_cpy = *l;
+    rule_res = parse_literal_c4(&rule_cpy, &rule_worked);
+    if (rule_worked) {
+      *worked = 1;
+      *l = rule_cpy;
+      return rule_res;
+    }
   }
   return NULL;
 }
+void *parse_literal(lexer_t *l, int *worked) {
+#ifdef PPARSER_MEMO
+  return memo_parse(l, worked, RULE_LITERAL, parse_literal_impl);
+#else
+  return parse_literal_impl(l, worked);
+#endif
+}
 
 // RULE param
-void *parse_param(lexer_t *l, int *worked) {
+void *parse_param_impl(lexer_t *l, int *worked) {
   *worked = 0;
   int rule_worked = 0;
   void *rule_res = NULL;
@@ -408,81 +879,70 @@ void *parse_param(lexer_t *l, int *worked) {
   }
   return NULL;
 }
+void *parse_param(lexer_t *l, int *worked) {
+#ifdef PPARSER_MEMO
+  return memo_parse(l, worked, RULE_PARAM, parse_param_impl);
+#else
+  return parse_param_impl(l, worked);
+#endif
+}
 
-void *parse_arglist(lexer_t *l, int *worked) {
+void *parse_arglist_impl(lexer_t *l, int *worked) {
   int rule_worked = 0;
-  size_t cap = 16;
-  size_t count = 0;
-  void **elems = malloc(sizeof(void *) * cap);
+  size_t base = list_stack.count;
   while (1) {
     lexer_t old = *l;
     void *elem = parse_param(l, &rule_worked);
     if (!rule_worked) {
       break;
     }
-    if (count + 1 >= cap) {
-      cap += 16;
-      void **temp = realloc(elems, cap * sizeof(void *));
-      if (!temp) {
-        free(elems);
-        perror("Reallocation failed");
-        exit(1);
-      }
-      elems = temp;
-    }
-    elems[count++] = elem;
+    list_push(elem);
     old = *l;
-    (void)parse_token_lexeme(l, &rule_worked, SV(","));
+    (void)parse_token_kind(l, &rule_worked, COMMA);
     if (!rule_worked) {
       *l = old;
       break;
     }
   }
-  if (count + 1 >= cap) {
-    elems = realloc(elems, (count + 1) * sizeof(void *));
-  }
-  elems[count] = NULL;
-  *worked = count > 0;
-  return elems;
+  *worked = list_stack.count > base;
+  return list_pop(base);
 }
-void *parse_funcallargs(lexer_t *l, int *worked) {
+void *parse_arglist(lexer_t *l, int *worked) {
+#ifdef PPARSER_MEMO
+  return memo_parse(l, worked, RULE_ARGLIST, parse_arglist_impl);
+#else
+  return parse_arglist_impl(l, worked);
+#endif
+}
+void *parse_funcallargs_impl(lexer_t *l, int *worked) {
   int rule_worked = 0;
-  size_t cap = 16;
-  size_t count = 0;
-  void **elems = malloc(sizeof(void *) * cap);
+  size_t base = list_stack.count;
   while (1) {
     lexer_t old = *l;
     void *elem = parse_expr(l, &rule_worked);
     if (!rule_worked) {
       break;
     }
-    if (count + 1 >= cap) {
-      cap += 16;
-      void **temp = realloc(elems, cap * sizeof(void *));
-      if (!temp) {
-        free(elems);
-        perror("Reallocation failed");
-        exit(1);
-      }
-      elems = temp;
-    }
-    elems[count++] = elem;
+    list_push(elem);
     old = *l;
-    (void)parse_token_lexeme(l, &rule_worked, SV(","));
+    (void)parse_token_kind(l, &rule_worked, COMMA);
     if (!rule_worked) {
       *l = old;
       break;
     }
   }
-  if (count + 1 >= cap) {
-    elems = realloc(elems, (count + 1) * sizeof(void *));
-  }
-  elems[count] = NULL;
-  *worked = count > 0;
-  return elems;
+  *worked = list_stack.count > base;
+  return list_pop(base);
+}
+void *parse_funcallargs(lexer_t *l, int *worked) {
+#ifdef PPARSER_MEMO
+  return memo_parse(l, worked, RULE_FUNCALLARGS, parse_funcallargs_impl);
+#else
+  return parse_funcallargs_impl(l, worked);
+#endif
 }
 // RULE size_dir
-void *parse_size_dir(lexer_t *l, int *worked) {
+void *parse_size_dir_impl(lexer_t *l, int *worked) {
   *worked = 0;
   int rule_worked = 0;
   void *rule_res = NULL;
@@ -495,210 +955,403 @@ void *parse_size_dir(lexer_t *l, int *worked) {
   }
   return NULL;
 }
+void *parse_size_dir(lexer_t *l, int *worked) {
+#ifdef PPARSER_MEMO
+  return memo_parse(l, worked, RULE_SIZE_DIR, parse_size_dir_impl);
+#else
+  return parse_size_dir_impl(l, worked);
+#endif
+}
 
 // RULE cast_like_dir
-void *parse_cast_like_dir(lexer_t *l, int *worked) {
+void *parse_cast_like_dir_impl(lexer_t *l, int *worked) {
   *worked = 0;
   int rule_worked = 0;
   void *rule_res = NULL;
-  lexer_t rule_cpy = *l;
-  rule_res = parse_cast_like_dir_c0(&rule_cpy, &rule_worked);
-  if (rule_worked) {
-    *worked = 1;
-    *l = rule_cpy;
-    return rule_res;
+  // Alternatives that can start with the next token
+  int viable;
+  switch (peek_kind(l)) {
+  case DIRECTIVE:
+    viable = 1 << 0 | 1 << 1;
+    break;
+  default:
+    return NULL;
+  }
+  lexer_t rule_cpy;
+  if (viable & (1 << 0)) {
+    rule_cpy = *l;
+    rule_res = parse_cast_like_dir_c0(&rule_cpy, &rule_worked);
+    if (rule_worked) {
+      *worked = 1;
+      *l = rule_cpy;
+      return rule_res;
+    }
   }
-  rule_cpy = *l;
-  rule_res = parse_cast_like_dir_c1(&rule_cpy, &rule_worked);
-  if (rule_worked) {
-    *worked = 1;
-    *l = rule_cpy;
-    return rule_res;
+  if (viable & (1 << 1)) {
+    rule_cpy = *l;
+    rule_res = parse_cast_like_dir_c1(&rule_cpy, &rule_worked);
+    if (rule_worked) {
+      *worked = 1;
+      *l = rule_cpy;
+      return rule_res;
+    }
   }
   return NULL;
 }
+void *parse_cast_like_dir(lexer_t *l, int *worked) {
+#ifdef PPARSER_MEMO
+  return memo_parse(l, worked, RULE_CAST_LIKE_DIR, parse_cast_like_dir_impl);
+#else
+  return parse_cast_like_dir_impl(l, worked);
+#endif
+}
 
 // RULE leaf
-void *parse_leaf(lexer_t *l, int *worked) {
+void *parse_leaf_impl(lexer_t *l, int *worked) {
   *worked = 0;
   int rule_worked = 0;
   void *rule_res = NULL;
-  lexer_t rule_cpy = *l;
-  rule_res = parse_leaf_c0(&rule_cpy, &rule_worked);
-  if (rule_worked) {
-    *worked = 1;
-    *l = rule_cpy;
-    return rule_res;
+  // Alternatives that can start with the next token
+  int viable;
+  switch (peek_kind(l)) {
+  case DIRECTIVE:
+    viable = 1 << 4 | 1 << 5;
+    break;
+  case STRLIT:
+  case KEY_TRUE:
+  case KEY_FALSE:
+  case CHARLIT:
+  case INTLIT:
+  case FLOATLIT:
+    viable = 1 << 1;
+    break;
+  case BIT_AND:
+  case NOT:
+  case MINUS:
+  case DEREF:
+    viable = 1 << 3;
+    break;
+  case OPEN_PAR:
+    viable = 1 << 0;
+    break;
+  case IDENTIFIER:
+    viable = 1 << 2;
+    break;
+  default:
+    return NULL;
+  }
+  lexer_t rule_cpy;
+  if (viable & (1 << 0)) {
+    rule_cpy = *l;
+    rule_res = parse_leaf_c0(&rule_cpy, &rule_worked);
+    if (rule_worked) {
+      *worked = 1;
+      *l = rule_cpy;
+      return rule_res;
+    }
   }
-  rule_cpy = *l;
-  rule_res = parse_leaf_c1(&rule_cpy, &rule_worked);
-  if (rule_worked) {
-    *worked = 1;
-    *l = rule_cpy;
-    return rule_res;
+  if (viable & (1 << 1)) {
+    rule_cpy = *l;
+    rule_res = parse_leaf_c1(&rule_cpy, &rule_worked);
+    if (rule_worked) {
+      *worked = 1;
+      *l = rule_cpy;
+      return rule_res;
+    }
   }
-  rule_cpy = *l;
-  rule_res = parse_leaf_c2(&rule_cpy, &rule_worked);
-  if (rule_worked) {
-    *worked = 1;
-    *l = rule_cpy;
-    return rule_res;
+  if (viable & (1 << 2)) {
+    rule_cpy = *l;
+    rule_res = parse_leaf_c2(&rule_cpy, &rule_worked);
+    if (rule_worked) {
+      *worked = 1;
+      *l = rule_cpy;
+      return rule_res;
+    }
   }
-  rule_cpy = *l;
-  rule_res = parse_leaf_c3(&rule_cpy, &rule_worked);
-  if (rule_worked) {
-    *worked = 1;
-    *l = rule_cpy;
-    return rule_res;
+  if (viable & (1 << 3)) {
+    rule_cpy = *l;
+    rule_res = parse_leaf_c3(&rule_cpy, &rule_worked);
+    if (rule_worked) {
+      *worked = 1;
+      *l = rule_cpy;
+      return rule_res;
+    }
   }
-  rule_cpy = *l;
-  rule_res = parse_leaf_c4(&rule_cpy, &rule_worked);
-  if (rule_worked) {
-    *worked = 1;
-    *l = rule_cpy;
-    return rule_res;
+  if (viable & (1 << 4)) {
+    rule_cpy = *l;
+    rule_res = parse_leaf_c4(&rule_cpy, &rule_worked);
+    if (rule_worked) {
+      *worked = 1;
+      *l = rule_cpy;
+      return rule_res;
+    }
   }
-  rule_cpy = *l;
-  rule_res = parse_leaf_c5(&rule_cpy, &rule_worked);
-  if (rule_worked) {
-    *worked = 1;
-    *l = rule_cpy;
-    return rule_res;
+  if (viable & (1 << 5)) {
+    rule_cpy = *l;
+    rule_res = parse_leaf_c5(&rule_cpy, &rule_worked);
+    if (rule_worked) {
+      *worked = 1;
+      *l = rule_cpy;
+      return rule_res;
+    }
   }
   return NULL;
 }
+void *parse_leaf(lexer_t *l, int *worked) {
+#ifdef PPARSER_MEMO
+  return memo_parse(l, worked, RULE_LEAF, parse_leaf_impl);
+#else
+  return parse_leaf_impl(l, worked);
+#endif
+}
 
 // RULE expr
-void *parse_expr(lexer_t *l, int *worked) {
+void *parse_expr_impl(lexer_t *l, int *worked) {
   *worked = 0;
   int rule_worked = 0;
   void *rule_res = NULL;
-  lexer_t rule_cpy = *l;
-  rule_res = parse_expr_c0(&rule_cpy, &rule_worked);
-  if (rule_worked) {
-    *worked = 1;
-    *l = rule_cpy;
-    return rule_res;
+  // Alternatives that can start with the next token
+  int viable;
+  switch (peek_kind(l)) {
+  case DIRECTIVE:
+  case STRLIT:
+  case KEY_TRUE:
+  case KEY_FALSE:
+  case BIT_AND:
+  case NOT:
+  case OPEN_PAR:
+  case CHARLIT:
+  case INTLIT:
+  case FLOATLIT:
+  case MINUS:
+  case IDENTIFIER:
+  case DEREF:
+    viable = 1 << 0 | 1 << 1;
+    break;
+  default:
+    viable = 1 << 0;
+    break;
+  }
+  lexer_t rule_cpy;
+  if (viable & (1 << 0)) {
+    rule_cpy = *l;
+    rule_res = parse_expr_c0(&rule_cpy, &rule_worked);
+    if (rule_worked) {
+      *worked = 1;
+      *l = rule_cpy;
+      return rule_res;
+    }
   }
-  rule_cpy = *l;
-  rule_res = parse_expr_c1(&rule_cpy, &rule_worked);
-  if (rule_worked) {
-    *worked = 1;
-    *l = rule_cpy;
-    return rule_res;
+  if (viable & (1 << 1)) {
+    rule_cpy = *l;
+    rule_res = parse_expr_c1(&rule_cpy, &rule_worked);
+    if (rule_worked) {
+      *worked = 1;
+      *l = rule_cpy;
+      return rule_res;
+    }
   }
   return NULL;
 }
+void *parse_expr(lexer_t *l, int *worked) {
+#ifdef PPARSER_MEMO
+  return memo_parse(l, worked, RULE_EXPR, parse_expr_impl);
+#else
+  return parse_expr_impl(l, worked);
+#endif
+}
 
 // RULE stmt
-void *parse_stmt(lexer_t *l, int *worked) {
+void *parse_stmt_impl(lexer_t *l, int *worked) {
   *worked = 0;
   int rule_worked = 0;
   void *rule_res = NULL;
-  lexer_t rule_cpy = *l;
-  rule_res = parse_stmt_c0(&rule_cpy, &rule_worked);
-  if (rule_worked) {
-    *worked = 1;
-    *l = rule_cpy;
-    return rule_res;
+  // Alternatives that can start with the next token
+  int viable;
+  switch (peek_kind(l)) {
+  case KEY_LET:
+    viable = 1 << 0 | 1 << 2 | 1 << 5;
+    break;
+  case KEY_IF:
+    viable = 1 << 0 | 1 << 3 | 1 << 5;
+    break;
+  case KEY_WHILE:
+    viable = 1 << 0 | 1 << 4 | 1 << 5;
+    break;
+  case KEY_RETURN:
+    viable = 1 << 0 | 1 << 5 | 1 << 6;
+    break;
+  case OPEN_BRA:
+    viable = 1 << 0 | 1 << 1 | 1 << 5;
+    break;
+  default:
+    viable = 1 << 0 | 1 << 5;
+    break;
+  }
+  lexer_t rule_cpy;
+  if (viable & (1 << 0)) {
+    rule_cpy = *l;
+    rule_res = parse_stmt_c0(&rule_cpy, &rule_worked);
+    if (rule_worked) {
+      *worked = 1;
+      *l = rule_cpy;
+      return rule_res;
+    }
   }
-  rule_cpy = *l;
-  rule_res = parse_stmt_c1(&rule_cpy, &rule_worked);
-  if (rule_worked) {
-    *worked = 1;
-    *l = rule_cpy;
-    return rule_res;
+  if (viable & (1 << 1)) {
+    rule_cpy = *l;
+    rule_res = parse_stmt_c1(&rule_cpy, &rule_worked);
+    if (rule_worked) {
+      *worked = 1;
+      *l = rule_cpy;
+      return rule_res;
+    }
   }
-  rule_cpy = *l;
-  rule_res = parse_stmt_c2(&rule_cpy, &rule_worked);
-  if (rule_worked) {
-    *worked = 1;
-    *l = rule_cpy;
-    return rule_res;
+  if (viable & (1 << 2)) {
+    rule_cpy = *l;
+    rule_res = parse_stmt_c2(&rule_cpy, &rule_worked);
+    if (rule_worked) {
+      *worked = 1;
+      *l = rule_cpy;
+      return rule_res;
+    }
   }
-  rule_cpy = *l;
-  rule_res = parse_stmt_c3(&rule_cpy, &rule_worked);
-  if (rule_worked) {
-    *worked = 1;
-    *l = rule_cpy;
-    return rule_res;
+  if (viable & (1 << 3)) {
+    rule_cpy = *l;
+    rule_res = parse_stmt_c3(&rule_cpy, &rule_worked);
+    if (rule_worked) {
+      *worked = 1;
+      *l = rule_cpy;
+      return rule_res;
+    }
   }
-  rule_cpy = *l;
-  rule_res = parse_stmt_c4(&rule_cpy, &rule_worked);
-  if (rule_worked) {
-    *worked = 1;
-    *l = rule_cpy;
-    return rule_res;
+  if (viable & (1 << 4)) {
+    rule_cpy = *l;
+    rule_res = parse_stmt_c4(&rule_cpy, &rule_worked);
+    if (rule_worked) {
+      *worked = 1;
+      *l = rule_cpy;
+      return rule_res;
+    }
   }
-  rule_cpy = *l;
-  rule_res = parse_stmt_c5(&rule_cpy, &rule_worked);
-  if (rule_worked) {
-    *worked = 1;
-    *l = rule_cpy;
-    return rule_res;
+  if (viable & (1 << 5)) {
+    rule_cpy = *l;
+    rule_res = parse_stmt_c5(&rule_cpy, &rule_worked);
+    if (rule_worked) {
+      *worked = 1;
+      *l = rule_cpy;
+      return rule_res;
+    }
   }
-  rule_cpy = *l;
-  rule_res = parse_stmt_c6(&rule_cpy, &rule_worked);
-  if (rule_worked) {
-    *worked = 1;
-    *l = rule_cpy;
-    return rule_res;
+  if (viable & (1 << 6)) {
+    rule_cpy = *l;
+    rule_res = parse_stmt_c6(&rule_cpy, &rule_worked);
+    if (rule_worked) {
+      *worked = 1;
+      *l = rule_cpy;
+      return rule_res;
+    }
   }
   return NULL;
 }
+void *parse_stmt(lexer_t *l, int *worked) {
+#ifdef PPARSER_MEMO
+  return memo_parse(l, worked, RULE_STMT, parse_stmt_impl);
+#else
+  return parse_stmt_impl(l, worked);
+#endif
+}
 
 // RULE decl
-void *parse_decl(lexer_t *l, int *worked) {
+void *parse_decl_impl(lexer_t *l, int *worked) {
   *worked = 0;
   int rule_worked = 0;
   void *rule_res = NULL;
-  lexer_t rule_cpy = *l;
-  rule_res = parse_decl_c0(&rule_cpy, &rule_worked);
-  if (rule_worked) {
-    *worked = 1;
-    *l = rule_cpy;
-    return rule_res;
+  // Alternatives that can start with the next token
+  int viable;
+  switch (peek_kind(l)) {
+  case DIRECTIVE:
+    viable = 1 << 0 | 1 << 1;
+    break;
+  case KEY_LET:
+    viable = 1 << 2 | 1 << 3;
+    break;
+  case KEY_CLASS:
+    viable = 1 << 4;
+    break;
+  case IDENTIFIER:
+    viable = 1 << 5;
+    break;
+  default:
+    return NULL;
+  }
+  lexer_t rule_cpy;
+  if (viable & (1 << 0)) {
+    rule_cpy = *l;
+    rule_res = parse_decl_c0(&rule_cpy, &rule_worked);
+    if (rule_worked) {
+      *worked = 1;
+      *l = rule_cpy;
+      return rule_res;
+    }
   }
-  rule_cpy = *l;
-  rule_res = parse_decl_c1(&rule_cpy, &rule_worked);
-  if (rule_worked) {
-    *worked = 1;
-    *l = rule_cpy;
-    return rule_res;
+  if (viable & (1 << 1)) {
+    rule_cpy = *l;
+    rule_res = parse_decl_c1(&rule_cpy, &rule_worked);
+    if (rule_worked) {
+      *worked = 1;
+      *l = rule_cpy;
+      return rule_res;
+    }
   }
-  rule_cpy = *l;
-  rule_res = parse_decl_c2(&rule_cpy, &rule_worked);
-  if (rule_worked) {
-    *worked = 1;
-    *l = rule_cpy;
-    return rule_res;
+  if (viable & (1 << 2)) {
+    rule_cpy = *l;
+    rule_res = parse_decl_c2(&rule_cpy, &rule_worked);
+    if (rule_worked) {
+      *worked = 1;
+      *l = rule_cpy;
+      return rule_res;
+    }
   }
-  rule_cpy = *l;
-  rule_res = parse_decl_c3(&rule_cpy, &rule_worked);
-  if (rule_worked) {
-    *worked = 1;
-    *l = rule_cpy;
-    return rule_res;
+  if (viable & (1 << 3)) {
+    rule_cpy = *l;
+    rule_res = parse_decl_c3(&rule_cpy, &rule_worked);
+    if (rule_worked) {
+      *worked = 1;
+      *l = rule_cpy;
+      return rule_res;
+    }
   }
-  rule_cpy = *l;
-  rule_res = parse_decl_c4(&rule_cpy, &rule_worked);
-  if (rule_worked) {
-    *worked = 1;
-    *l = rule_cpy;
-    return rule_res;
+  if (viable & (1 << 4)) {
+    rule_cpy = *l;
+    rule_res = parse_decl_c4(&rule_cpy, &rule_worked);
+    if (rule_worked) {
+      *worked = 1;
+      *l = rule_cpy;
+      return rule_res;
+    }
   }
-  rule_cpy = *l;
-  rule_res = parse_decl_c5(&rule_cpy, &rule_worked);
-  if (rule_worked) {
-    *worked = 1;
-    *l = rule_cpy;
-    return rule_res;
+  if (viable & (1 << 5)) {
+    rule_cpy = *l;
+    rule_res = parse_decl_c5(&rule_cpy, &rule_worked);
+    if (rule_worked) {
+      *worked = 1;
+      *l = rule_cpy;
+      return rule_res;
+    }
   }
   return NULL;
 }
+void *parse_decl(lexer_t *l, int *worked) {
+#ifdef PPARSER_MEMO
+  return memo_parse(l, worked, RULE_DECL, parse_decl_impl);
+#else
+  return parse_decl_impl(l, worked);
+#endif
+}
 
 // RULE binop
-void *parse_binop(lexer_t *l, int *worked) {
+void *parse_binop_impl(lexer_t *l, int *worked) {
   *worked = 0;
   int rule_worked = 0;
   void *rule_res = NULL;
@@ -711,9 +1364,16 @@ void *parse_binop(lexer_t *l, int *worked) {
   }
   return NULL;
 }
+void *parse_binop(lexer_t *l, int *worked) {
+#ifdef PPARSER_MEMO
+  return memo_parse(l, worked, RULE_BINOP, parse_binop_impl);
+#else
+  return parse_binop_impl(l, worked);
+#endif
+}
 
 // RULE paren
-void *parse_paren(lexer_t *l, int *worked) {
+void *parse_paren_impl(lexer_t *l, int *worked) {
   *worked = 0;
   int rule_worked = 0;
   void *rule_res = NULL;
@@ -726,77 +1386,100 @@ void *parse_paren(lexer_t *l, int *worked) {
   }
   return NULL;
 }
+void *parse_paren(lexer_t *l, int *worked) {
+#ifdef PPARSER_MEMO
+  return memo_parse(l, worked, RULE_PAREN, parse_paren_impl);
+#else
+  return parse_paren_impl(l, worked);
+#endif
+}
 
-void *parse_starlist(lexer_t *l, int *worked) {
+void *parse_starlist_impl(lexer_t *l, int *worked) {
   int rule_worked = 0;
-  size_t cap = 16;
-  size_t count = 0;
-  void **elems = malloc(sizeof(void *) * cap);
+  size_t base = list_stack.count;
   while (1) {
     lexer_t old = *l;
-    void *elem = parse_token_lexeme(l, &rule_worked, SV("*"));
+    void *elem = parse_token_kind(l, &rule_worked, MULT);
     if (!rule_worked) {
       *l = old;
       break;
     }
-    if (count + 1 >= cap) {
-      cap += 16;
-      void **temp = realloc(elems, cap * sizeof(void *));
-      if (!temp) {
-        free(elems);
-        perror("Reallocation failed");
-        exit(1);
-      }
-      elems = temp;
-    }
-    elems[count++] = elem;
+    list_push(elem);
     old = *l;
   }
-  if (count + 1 >= cap) {
-    elems = realloc(elems, (count + 1) * sizeof(void *));
-  }
-  elems[count] = NULL;
-  *worked = count > 0;
-  return elems;
+  *worked = list_stack.count > base;
+  return list_pop(base);
+}
+void *parse_starlist(lexer_t *l, int *worked) {
+#ifdef PPARSER_MEMO
+  return memo_parse(l, worked, RULE_STARLIST, parse_starlist_impl);
+#else
+  return parse_starlist_impl(l, worked);
+#endif
 }
 // RULE type
-void *parse_type(lexer_t *l, int *worked) {
+void *parse_type_impl(lexer_t *l, int *worked) {
   *worked = 0;
   int rule_worked = 0;
   void *rule_res = NULL;
-  lexer_t rule_cpy = *l;
-  rule_res = parse_type_c0(&rule_cpy, &rule_worked);
-  if (rule_worked) {
-    *worked = 1;
-    *l = rule_cpy;
-    return rule_res;
+  // Alternatives that can start with the next token
+  int viable;
+  switch (peek_kind(l)) {
+  case IDENTIFIER:
+    viable = 1 << 0 | 1 << 1 | 1 << 2 | 1 << 3;
+    break;
+  default:
+    return NULL;
+  }
+  lexer_t rule_cpy;
+  if (viable & (1 << 0)) {
+    rule_cpy = *l;
+    rule_res = parse_type_c0(&rule_cpy, &rule_worked);
+    if (rule_worked) {
+      *worked = 1;
+      *l = rule_cpy;
+      return rule_res;
+    }
   }
-  rule_cpy = *l;
-  rule_res = parse_type_c1(&rule_cpy, &rule_worked);
-  if (rule_worked) {
-    *worked = 1;
-    *l = rule_cpy;
-    return rule_res;
+  if (viable & (1 << 1)) {
+    rule_cpy = *l;
+    rule_res = parse_type_c1(&rule_cpy, &rule_worked);
+    if (rule_worked) {
+      *worked = 1;
+      *l = rule_cpy;
+      return rule_res;
+    }
   }
-  rule_cpy = *l;
-  rule_res = parse_type_c2(&rule_cpy, &rule_worked);
-  if (rule_worked) {
-    *worked = 1;
-    *l = rule_cpy;
-    return rule_res;
+  if (viable & (1 << 2)) {
+    rule_cpy = *l;
+    rule_res = parse_type_c2(&rule_cpy, &rule_worked);
+    if (rule_worked) {
+      *worked = 1;
+      *l = rule_cpy;
+      return rule_res;
+    }
   }
-  rule_cpy = *l;
-  rule_res = parse_type_c3(&rule_cpy, &rule_worked);
-  if (rule_worked) {
-    *worked = 1;
-    *l = rule_cpy;
-    return rule_res;
+  if (viable & (1 << 3)) {
+    rule_cpy = *l;
+    rule_res = parse_type_c3(&rule_cpy, &rule_worked);
+    if (rule_worked) {
+      *worked = 1;
+      *l = rule_cpy;
+      return rule_res;
+    }
   }
   return NULL;
 }
+void *parse_type(lexer_t *l, int *worked) {
+#ifdef PPARSER_MEMO
+  return memo_parse(l, worked, RULE_TYPE, parse_type_impl);
+#else
+  return parse_type_impl(l, worked);
+#endif
+}
 
 // RULE unary
-void *parse_unary(lexer_t *l, int *worked) {
+void *parse_unary_impl(lexer_t *l, int *worked) {
   *worked = 0;
   int rule_worked = 0;
   void *rule_res = NULL;
@@ -809,12 +1492,17 @@ void *parse_unary(lexer_t *l, int *worked) {
   }
   return NULL;
 }
+void *parse_unary(lexer_t *l, int *worked) {
+#ifdef PPARSER_MEMO
+  return memo_parse(l, worked, RULE_UNARY, parse_unary_impl);
+#else
+  return parse_unary_impl(l, worked);
+#endif
+}
 
-void *parse_stmt_list(lexer_t *l, int *worked) {
+void *parse_stmt_list_impl(lexer_t *l, int *worked) {
   int rule_worked = 0;
-  size_t cap = 16;
-  size_t count = 0;
-  void **elems = malloc(sizeof(void *) * cap);
+  size_t base = list_stack.count;
   while (1) {
     lexer_t old = *l;
     void *elem = parse_stmt(l, &rule_worked);
@@ -822,53 +1510,65 @@ void *parse_stmt_list(lexer_t *l, int *worked) {
       *l = old;
       break;
     }
-    if (count + 1 >= cap) {
-      cap += 16;
-      void **temp = realloc(elems, cap * sizeof(void *));
-      if (!temp) {
-        free(elems);
-        perror("Reallocation failed");
-        exit(1);
-      }
-      elems = temp;
-    }
-    elems[count++] = elem;
+    list_push(elem);
     old = *l;
   }
-  if (count + 1 >= cap) {
-    elems = realloc(elems, (count + 1) * sizeof(void *));
-  }
-  elems[count] = NULL;
-  *worked = count > 0;
-  return elems;
+  *worked = list_stack.count > base;
+  return list_pop(base);
+}
+void *parse_stmt_list(lexer_t *l, int *worked) {
+#ifdef PPARSER_MEMO
+  return memo_parse(l, worked, RULE_STMT_LIST, parse_stmt_list_impl);
+#else
+  return parse_stmt_list_impl(l, worked);
+#endif
 }
 // RULE compound
-void *parse_compound(lexer_t *l, int *worked) {
+void *parse_compound_impl(lexer_t *l, int *worked) {
   *worked = 0;
   int rule_worked = 0;
   void *rule_res = NULL;
-  lexer_t rule_cpy = *l;
-  rule_res = parse_compound_c0(&rule_cpy, &rule_worked);
-  if (rule_worked) {
-    *worked = 1;
-    *l = rule_cpy;
-    return rule_res;
+  // Alternatives that can start with the next token
+  int viable;
+  switch (peek_kind(l)) {
+  case OPEN_BRA:
+    viable = 1 << 0 | 1 << 1;
+    break;
+  default:
+    return NULL;
+  }
+  lexer_t rule_cpy;
+  if (viable & (1 << 0)) {
+    rule_cpy = *l;
+    rule_res = parse_compound_c0(&rule_cpy, &rule_worked);
+    if (rule_worked) {
+      *worked = 1;
+      *l = rule_cpy;
+      return rule_res;
+    }
   }
-  rule_cpy = *l;
-  rule_res = parse_compound_c1(&rule_cpy, &rule_worked);
-  if (rule_worked) {
-    *worked = 1;
-    *l = rule_cpy;
-    return rule_res;
+  if (viable & (1 << 1)) {
+    rule_cpy = *l;
+    rule_res = parse_compound_c1(&rule_cpy, &rule_worked);
+    if (rule_worked) {
+      *worked = 1;
+      *l = rule_cpy;
+      return rule_res;
+    }
   }
   return NULL;
 }
+void *parse_compound(lexer_t *l, int *worked) {
+#ifdef PPARSER_MEMO
+  return memo_parse(l, worked, RULE_COMPOUND, parse_compound_impl);
+#else
+  return parse_compound_impl(l, worked);
+#endif
+}
 
-void *parse_program_list(lexer_t *l, int *worked) {
+void *parse_program_list_impl(lexer_t *l, int *worked) {
   int rule_worked = 0;
-  size_t cap = 16;
-  size_t count = 0;
-  void **elems = malloc(sizeof(void *) * cap);
+  size_t base = list_stack.count;
   while (1) {
     lexer_t old = *l;
     void *elem = parse_decl(l, &rule_worked);
@@ -876,28 +1576,21 @@ void *parse_program_list(lexer_t *l, int *worked) {
       *l = old;
       break;
     }
-    if (count + 1 >= cap) {
-      cap += 16;
-      void **temp = realloc(elems, cap * sizeof(void *));
-      if (!temp) {
-        free(elems);
-        perror("Reallocation failed");
-        exit(1);
-      }
-      elems = temp;
-    }
-    elems[count++] = elem;
+    list_push(elem);
     old = *l;
   }
-  if (count + 1 >= cap) {
-    elems = realloc(elems, (count + 1) * sizeof(void *));
-  }
-  elems[count] = NULL;
-  *worked = count > 0;
-  return elems;
+  *worked = list_stack.count > base;
+  return list_pop(base);
+}
+void *parse_program_list(lexer_t *l, int *worked) {
+#ifdef PPARSER_MEMO
+  return memo_parse(l, worked, RULE_PROGRAM_LIST, parse_program_list_impl);
+#else
+  return parse_program_list_impl(l, worked);
+#endif
 }
 // RULE program
-void *parse_program(lexer_t *l, int *worked) {
+void *parse_program_impl(lexer_t *l, int *worked) {
   *worked = 0;
   int rule_worked = 0;
   void *rule_res = NULL;
@@ -910,9 +1603,16 @@ void *parse_program(lexer_t *l, int *worked) {
   }
   return NULL;
 }
+void *parse_program(lexer_t *l, int *worked) {
+#ifdef PPARSER_MEMO
+  return memo_parse(l, worked, RULE_PROGRAM, parse_program_impl);
+#else
+  return parse_program_impl(l, worked);
+#endif
+}
 
 // RULE tempelem
-void *parse_tempelem(lexer_t *l, int *worked) {
+void *parse_tempelem_impl(lexer_t *l, int *worked) {
   *worked = 0;
   int rule_worked = 0;
   void *rule_res = NULL;
@@ -925,45 +1625,43 @@ void *parse_tempelem(lexer_t *l, int *worked) {
   }
   return NULL;
 }
+void *parse_tempelem(lexer_t *l, int *worked) {
+#ifdef PPARSER_MEMO
+  return memo_parse(l, worked, RULE_TEMPELEM, parse_tempelem_impl);
+#else
+  return parse_tempelem_impl(l, worked);
+#endif
+}
 
-void *parse_templist(lexer_t *l, int *worked) {
+void *parse_templist_impl(lexer_t *l, int *worked) {
   int rule_worked = 0;
-  size_t cap = 16;
-  size_t count = 0;
-  void **elems = malloc(sizeof(void *) * cap);
+  size_t base = list_stack.count;
   while (1) {
     lexer_t old = *l;
     void *elem = parse_tempelem(l, &rule_worked);
     if (!rule_worked) {
       break;
     }
-    if (count + 1 >= cap) {
-      cap += 16;
-      void **temp = realloc(elems, cap * sizeof(void *));
-      if (!temp) {
-        free(elems);
-        perror("Reallocation failed");
-        exit(1);
-      }
-      elems = temp;
-    }
-    elems[count++] = elem;
+    list_push(elem);
     old = *l;
-    (void)parse_token_lexeme(l, &rule_worked, SV(","));
+    (void)parse_token_kind(l, &rule_worked, COMMA);
     if (!rule_worked) {
       *l = old;
       break;
     }
   }
-  if (count + 1 >= cap) {
-    elems = realloc(elems, (count + 1) * sizeof(void *));
-  }
-  elems[count] = NULL;
-  *worked = count > 0;
-  return elems;
+  *worked = list_stack.count > base;
+  return list_pop(base);
+}
+void *parse_templist(lexer_t *l, int *worked) {
+#ifdef PPARSER_MEMO
+  return memo_parse(l, worked, RULE_TEMPLIST, parse_templist_impl);
+#else
+  return parse_templist_impl(l, worked);
+#endif
 }
 // RULE template
-void *parse_template(lexer_t *l, int *worked) {
+void *parse_template_impl(lexer_t *l, int *worked) {
   *worked = 0;
   int rule_worked = 0;
   void *rule_res = NULL;
@@ -976,45 +1674,43 @@ void *parse_template(lexer_t *l, int *worked) {
   }
   return NULL;
 }
+void *parse_template(lexer_t *l, int *worked) {
+#ifdef PPARSER_MEMO
+  return memo_parse(l, worked, RULE_TEMPLATE, parse_template_impl);
+#else
+  return parse_template_impl(l, worked);
+#endif
+}
 
-void *parse_tlist(lexer_t *l, int *worked) {
+void *parse_tlist_impl(lexer_t *l, int *worked) {
   int rule_worked = 0;
-  size_t cap = 16;
-  size_t count = 0;
-  void **elems = malloc(sizeof(void *) * cap);
+  size_t base = list_stack.count;
   while (1) {
     lexer_t old = *l;
     void *elem = parse_type(l, &rule_worked);
     if (!rule_worked) {
       break;
     }
-    if (count + 1 >= cap) {
-      cap += 16;
-      void **temp = realloc(elems, cap * sizeof(void *));
-      if (!temp) {
-        free(elems);
-        perror("Reallocation failed");
-        exit(1);
-      }
-      elems = temp;
-    }
-    elems[count++] = elem;
+    list_push(elem);
     old = *l;
-    (void)parse_token_lexeme(l, &rule_worked, SV(","));
+    (void)parse_token_kind(l, &rule_worked, COMMA);
     if (!rule_worked) {
       *l = old;
       break;
     }
   }
-  if (count + 1 >= cap) {
-    elems = realloc(elems, (count + 1) * sizeof(void *));
-  }
-  elems[count] = NULL;
-  *worked = count > 0;
-  return elems;
+  *worked = list_stack.count > base;
+  return list_pop(base);
+}
+void *parse_tlist(lexer_t *l, int *worked) {
+#ifdef PPARSER_MEMO
+  return memo_parse(l, worked, RULE_TLIST, parse_tlist_impl);
+#else
+  return parse_tlist_impl(l, worked);
+#endif
 }
 // RULE inst_template
-void *parse_inst_template(lexer_t *l, int *worked) {
+void *parse_inst_template_impl(lexer_t *l, int *worked) {
   *worked = 0;
   int rule_worked = 0;
   void *rule_res = NULL;
@@ -1027,45 +1723,77 @@ void *parse_inst_template(lexer_t *l, int *worked) {
   }
   return NULL;
 }
+void *parse_inst_template(lexer_t *l, int *worked) {
+#ifdef PPARSER_MEMO
+  return memo_parse(l, worked, RULE_INST_TEMPLATE, parse_inst_template_impl);
+#else
+  return parse_inst_template_impl(l, worked);
+#endif
+}
 
 // RULE fundef_letless
-void *parse_fundef_letless(lexer_t *l, int *worked) {
+void *parse_fundef_letless_impl(lexer_t *l, int *worked) {
   *worked = 0;
   int rule_worked = 0;
   void *rule_res = NULL;
-  lexer_t rule_cpy = *l;
-  rule_res = parse_fundef_letless_c0(&rule_cpy, &rule_worked);
-  if (rule_worked) {
-    *worked = 1;
-    *l = rule_cpy;
-    return rule_res;
+  // Alternatives that can start with the next token
+  int viable;
+  switch (peek_kind(l)) {
+  case IDENTIFIER:
+    viable = 1 << 0 | 1 << 1 | 1 << 2 | 1 << 3;
+    break;
+  default:
+    return NULL;
+  }
+  lexer_t rule_cpy;
+  if (viable & (1 << 0)) {
+    rule_cpy = *l;
+    rule_res = parse_fundef_letless_c0(&rule_cpy, &rule_worked);
+    if (rule_worked) {
+      *worked = 1;
+      *l = rule_cpy;
+      return rule_res;
+    }
   }
-  rule_cpy = *l;
-  rule_res = parse_fundef_letless_c1(&rule_cpy, &rule_worked);
-  if (rule_worked) {
-    *worked = 1;
-    *l = rule_cpy;
-    return rule_res;
+  if (viable & (1 << 1)) {
+    rule_cpy = *l;
+    rule_res = parse_fundef_letless_c1(&rule_cpy, &rule_worked);
+    if (rule_worked) {
+      *worked = 1;
+      *l = rule_cpy;
+      return rule_res;
+    }
   }
-  rule_cpy = *l;
-  rule_res = parse_fundef_letless_c2(&rule_cpy, &rule_worked);
-  if (rule_worked) {
-    *worked = 1;
-    *l = rule_cpy;
-    return rule_res;
+  if (viable & (1 << 2)) {
+    rule_cpy = *l;
+    rule_res = parse_fundef_letless_c2(&rule_cpy, &rule_worked);
+    if (rule_worked) {
+      *worked = 1;
+      *l = rule_cpy;
+      return rule_res;
+    }
   }
-  rule_cpy = *l;
-  rule_res = parse_fundef_letless_c3(&rule_cpy, &rule_worked);
-  if (rule_worked) {
-    *worked = 1;
-    *l = rule_cpy;
-    return rule_res;
+  if (viable & (1 << 3)) {
+    rule_cpy = *l;
+    rule_res = parse_fundef_letless_c3(&rule_cpy, &rule_worked);
+    if (rule_worked) {
+      *worked = 1;
+      *l = rule_cpy;
+      return rule_res;
+    }
   }
   return NULL;
 }
+void *parse_fundef_letless(lexer_t *l, int *worked) {
+#ifdef PPARSER_MEMO
+  return memo_parse(l, worked, RULE_FUNDEF_LETLESS, parse_fundef_letless_impl);
+#else
+  return parse_fundef_letless_impl(l, worked);
+#endif
+}
 
 // RULE fundef
-void *parse_fundef(lexer_t *l, int *worked) {
+void *parse_fundef_impl(lexer_t *l, int *worked) {
   *worked = 0;
   int rule_worked = 0;
   void *rule_res = NULL;
@@ -1078,67 +1806,129 @@ void *parse_fundef(lexer_t *l, int *worked) {
   }
   return NULL;
 }
+void *parse_fundef(lexer_t *l, int *worked) {
+#ifdef PPARSER_MEMO
+  return memo_parse(l, worked, RULE_FUNDEF, parse_fundef_impl);
+#else
+  return parse_fundef_impl(l, worked);
+#endif
+}
 
 // RULE uop
-void *parse_uop(lexer_t *l, int *worked) {
+void *parse_uop_impl(lexer_t *l, int *worked) {
   *worked = 0;
   int rule_worked = 0;
   void *rule_res = NULL;
-  lexer_t rule_cpy = *l;
-  rule_res = parse_uop_c0(&rule_cpy, &rule_worked);
-  if (rule_worked) {
-    *worked = 1;
-    *l = rule_cpy;
-    return rule_res;
+  // Alternatives that can start with the next token
+  int viable;
+  switch (peek_kind(l)) {
+  case BIT_AND:
+    viable = 1 << 3;
+    break;
+  case NOT:
+    viable = 1 << 1;
+    break;
+  case MINUS:
+    viable = 1 << 0;
+    break;
+  case DEREF:
+    viable = 1 << 2;
+    break;
+  default:
+    return NULL;
+  }
+  lexer_t rule_cpy;
+  if (viable & (1 << 0)) {
+    rule_cpy = *l;
+    rule_res = parse_uop_c0(&rule_cpy, &rule_worked);
+    if (rule_worked) {
+      *worked = 1;
+      *l = rule_cpy;
+      return rule_res;
+    }
   }
-  rule_cpy = *l;
-  rule_res = parse_uop_c1(&rule_cpy, &rule_worked);
-  if (rule_worked) {
-    *worked = 1;
-    *l = rule_cpy;
-    return rule_res;
+  if (viable & (1 << 1)) {
+    rule_cpy = *l;
+    rule_res = parse_uop_c1(&rule_cpy, &rule_worked);
+    if (rule_worked) {
+      *worked = 1;
+      *l = rule_cpy;
+      return rule_res;
+    }
   }
-  rule_cpy = *l;
-  rule_res = parse_uop_c2(&rule_cpy, &rule_worked);
-  if (rule_worked) {
-    *worked = 1;
-    *l = rule_cpy;
-    return rule_res;
+  if (viable & (1 << 2)) {
+    rule_cpy = *l;
+    rule_res = parse_uop_c2(&rule_cpy, &rule_worked);
+    if (rule_worked) {
+      *worked = 1;
+      *l = rule_cpy;
+      return rule_res;
+    }
   }
-  rule_cpy = *l;
-  rule_res = parse_uop_c3(&rule_cpy, &rule_worked);
-  if (rule_worked) {
-    *worked = 1;
-    *l = rule_cpy;
-    return rule_res;
+  if (viable & (1 << 3)) {
+    rule_cpy = *l;
+    rule_res = parse_uop_c3(&rule_cpy, &rule_worked);
+    if (rule_worked) {
+      *worked = 1;
+      *l = rule_cpy;
+      return rule_res;
+    }
   }
   return NULL;
 }
+void *parse_uop(lexer_t *l, int *worked) {
+#ifdef PPARSER_MEMO
+  return memo_parse(l, worked, RULE_UOP, parse_uop_impl);
+#else
+  return parse_uop_impl(l, worked);
+#endif
+}
 
 // RULE vardef_letless
-void *parse_vardef_letless(lexer_t *l, int *worked) {
+void *parse_vardef_letless_impl(lexer_t *l, int *worked) {
   *worked = 0;
   int rule_worked = 0;
   void *rule_res = NULL;
-  lexer_t rule_cpy = *l;
-  rule_res = parse_vardef_letless_c0(&rule_cpy, &rule_worked);
-  if (rule_worked) {
-    *worked = 1;
-    *l = rule_cpy;
-    return rule_res;
+  // Alternatives that can start with the next token
+  int viable;
+  switch (peek_kind(l)) {
+  case IDENTIFIER:
+    viable = 1 << 0 | 1 << 1;
+    break;
+  default:
+    return NULL;
+  }
+  lexer_t rule_cpy;
+  if (viable & (1 << 0)) {
+    rule_cpy = *l;
+    rule_res = parse_vardef_letless_c0(&rule_cpy, &rule_worked);
+    if (rule_worked) {
+      *worked = 1;
+      *l = rule_cpy;
+      return rule_res;
+    }
   }
-  rule_cpy = *l;
-  rule_res = parse_vardef_letless_c1(&rule_cpy, &rule_worked);
-  if (rule_worked) {
-    *worked = 1;
-    *l = rule_cpy;
-    return rule_res;
+  if (viable & (1 << 1)) {
+    rule_cpy = *l;
+    rule_res = parse_vardef_letless_c1(&rule_cpy, &rule_worked);
+    if (rule_worked) {
+      *worked = 1;
+      *l = rule_cpy;
+      return rule_res;
+    }
   }
   return NULL;
 }
+void *parse_vardef_letless(lexer_t *l, int *worked) {
+#ifdef PPARSER_MEMO
+  return memo_parse(l, worked, RULE_VARDEF_LETLESS, parse_vardef_letless_impl);
+#else
+  return parse_vardef_letless_impl(l, worked);
+#endif
+}
 
 // RULE vardef
-void *parse_vardef(lexer_t *l, int *worked) {
+void *parse_vardef_impl(lexer_t *l, int *worked) {
   *worked = 0;
   int rule_worked = 0;
   void *rule_res = NULL;
@@ -1151,9 +1941,16 @@ void *parse_vardef(lexer_t *l, int *worked) {
   }
   return NULL;
 }
+void *parse_vardef(lexer_t *l, int *worked) {
+#ifdef PPARSER_MEMO
+  return memo_parse(l, worked, RULE_VARDEF, parse_vardef_impl);
+#else
+  return parse_vardef_impl(l, worked);
+#endif
+}
 
 // RULE ct_cte
-void *parse_ct_cte(lexer_t *l, int *worked) {
+void *parse_ct_cte_impl(lexer_t *l, int *worked) {
   *worked = 0;
   int rule_worked = 0;
   void *rule_res = NULL;
@@ -1166,206 +1963,362 @@ void *parse_ct_cte(lexer_t *l, int *worked) {
   }
   return NULL;
 }
+void *parse_ct_cte(lexer_t *l, int *worked) {
+#ifdef PPARSER_MEMO
+  return memo_parse(l, worked, RULE_CT_CTE, parse_ct_cte_impl);
+#else
+  return parse_ct_cte_impl(l, worked);
+#endif
+}
 
 // RULE access_spec
-void *parse_access_spec(lexer_t *l, int *worked) {
+void *parse_access_spec_impl(lexer_t *l, int *worked) {
   *worked = 0;
   int rule_worked = 0;
   void *rule_res = NULL;
-  lexer_t rule_cpy = *l;
-  rule_res = parse_access_spec_c0(&rule_cpy, &rule_worked);
-  if (rule_worked) {
-    *worked = 1;
-    *l = rule_cpy;
-    return rule_res;
+  // Alternatives that can start with the next token
+  int viable;
+  switch (peek_kind(l)) {
+  case KEY_PUBLIC:
+    viable = 1 << 0;
+    break;
+  case KEY_PRIVATE:
+    viable = 1 << 1;
+    break;
+  default:
+    return NULL;
+  }
+  lexer_t rule_cpy;
+  if (viable & (1 << 0)) {
+    rule_cpy = *l;
+    rule_res = parse_access_spec_c0(&rule_cpy, &rule_worked);
+    if (rule_worked) {
+      *worked = 1;
+      *l = rule_cpy;
+      return rule_res;
+    }
   }
-  rule_cpy = *l;
-  rule_res = parse_access_spec_c1(&rule_cpy, &rule_worked);
-  if (rule_worked) {
-    *worked = 1;
-    *l = rule_cpy;
-    return rule_res;
+  if (viable & (1 << 1)) {
+    rule_cpy = *l;
+    rule_res = parse_access_spec_c1(&rule_cpy, &rule_worked);
+    if (rule_worked) {
+      *worked = 1;
+      *l = rule_cpy;
+      return rule_res;
+    }
   }
   return NULL;
 }
+void *parse_access_spec(lexer_t *l, int *worked) {
+#ifdef PPARSER_MEMO
+  return memo_parse(l, worked, RULE_ACCESS_SPEC, parse_access_spec_impl);
+#else
+  return parse_access_spec_impl(l, worked);
+#endif
+}
 
 // RULE abstract_opt
-void *parse_abstract_opt(lexer_t *l, int *worked) {
+void *parse_abstract_opt_impl(lexer_t *l, int *worked) {
   *worked = 0;
   int rule_worked = 0;
   void *rule_res = NULL;
-  lexer_t rule_cpy = *l;
-  rule_res = parse_abstract_opt_c0(&rule_cpy, &rule_worked);
-  if (rule_worked) {
-    *worked = 1;
-    *l = rule_cpy;
-    return rule_res;
+  // Alternatives that can start with the next token
+  int viable;
+  switch (peek_kind(l)) {
+  case IDENTIFIER:
+    viable = 1 << 0 | 1 << 1;
+    break;
+  default:
+    viable = 1 << 1;
+    break;
+  }
+  lexer_t rule_cpy;
+  if (viable & (1 << 0)) {
+    rule_cpy = *l;
+    rule_res = parse_abstract_opt_c0(&rule_cpy, &rule_worked);
+    if (rule_worked) {
+      *worked = 1;
+      *l = rule_cpy;
+      return rule_res;
+    }
   }
-  rule_cpy = *l;
-  rule_res = parse_abstract_opt_c1(&rule_cpy, &rule_worked);
-  if (rule_worked) {
-    *worked = 1;
-    *l = rule_cpy;
-    return rule_res;
+  if (viable & (1 << 1)) {
+    rule_cpy = *l;
+    rule_res = parse_abstract_opt_c1(&rule_cpy, &rule_worked);
+    if (rule_worked) {
+      *worked = 1;
+      *l = rule_cpy;
+      return rule_res;
+    }
   }
   return NULL;
 }
+void *parse_abstract_opt(lexer_t *l, int *worked) {
+#ifdef PPARSER_MEMO
+  return memo_parse(l, worked, RULE_ABSTRACT_OPT, parse_abstract_opt_impl);
+#else
+  return parse_abstract_opt_impl(l, worked);
+#endif
+}
 
 // RULE static_opt
-void *parse_static_opt(lexer_t *l, int *worked) {
+void *parse_static_opt_impl(lexer_t *l, int *worked) {
   *worked = 0;
   int rule_worked = 0;
   void *rule_res = NULL;
-  lexer_t rule_cpy = *l;
-  rule_res = parse_static_opt_c0(&rule_cpy, &rule_worked);
-  if (rule_worked) {
-    *worked = 1;
-    *l = rule_cpy;
-    return rule_res;
+  // Alternatives that can start with the next token
+  int viable;
+  switch (peek_kind(l)) {
+  case IDENTIFIER:
+    viable = 1 << 0 | 1 << 1;
+    break;
+  default:
+    viable = 1 << 1;
+    break;
+  }
+  lexer_t rule_cpy;
+  if (viable & (1 << 0)) {
+    rule_cpy = *l;
+    rule_res = parse_static_opt_c0(&rule_cpy, &rule_worked);
+    if (rule_worked) {
+      *worked = 1;
+      *l = rule_cpy;
+      return rule_res;
+    }
   }
-  rule_cpy = *l;
-  rule_res = parse_static_opt_c1(&rule_cpy, &rule_worked);
-  if (rule_worked) {
-    *worked = 1;
-    *l = rule_cpy;
-    return rule_res;
+  if (viable & (1 << 1)) {
+    rule_cpy = *l;
+    rule_res = parse_static_opt_c1(&rule_cpy, &rule_worked);
+    if (rule_worked) {
+      *worked = 1;
+      *l = rule_cpy;
+      return rule_res;
+    }
   }
   return NULL;
 }
+void *parse_static_opt(lexer_t *l, int *worked) {
+#ifdef PPARSER_MEMO
+  return memo_parse(l, worked, RULE_STATIC_OPT, parse_static_opt_impl);
+#else
+  return parse_static_opt_impl(l, worked);
+#endif
+}
 
-void *parse_class_body(lexer_t *l, int *worked) {
+void *parse_class_body_impl(lexer_t *l, int *worked) {
   int rule_worked = 0;
-  size_t cap = 16;
-  size_t count = 0;
-  void **elems = malloc(sizeof(void *) * cap);
+  size_t base = list_stack.count;
   while (1) {
     lexer_t old = *l;
     void *elem = parse_class_body_item(l, &rule_worked);
     if (!rule_worked) {
       break;
     }
-    if (count + 1 >= cap) {
-      cap += 16;
-      void **temp = realloc(elems, cap * sizeof(void *));
-      if (!temp) {
-        free(elems);
-        perror("Reallocation failed");
-        exit(1);
-      }
-      elems = temp;
-    }
-    elems[count++] = elem;
+    list_push(elem);
     old = *l;
-    (void)parse_token_lexeme(l, &rule_worked, SV(","));
+    (void)parse_token_kind(l, &rule_worked, COMMA);
     if (!rule_worked) {
       *l = old;
       break;
     }
   }
-  if (count + 1 >= cap) {
-    elems = realloc(elems, (count + 1) * sizeof(void *));
-  }
-  elems[count] = NULL;
-  *worked = count > 0;
-  return elems;
+  *worked = list_stack.count > base;
+  return list_pop(base);
+}
+void *parse_class_body(lexer_t *l, int *worked) {
+#ifdef PPARSER_MEMO
+  return memo_parse(l, worked, RULE_CLASS_BODY, parse_class_body_impl);
+#else
+  return parse_class_body_impl(l, worked);
+#endif
 }
 // RULE class_constructor
-void *parse_class_constructor(lexer_t *l, int *worked) {
+void *parse_class_constructor_impl(lexer_t *l, int *worked) {
   *worked = 0;
   int rule_worked = 0;
   void *rule_res = NULL;
-  lexer_t rule_cpy = *l;
-  rule_res = parse_class_constructor_c0(&rule_cpy, &rule_worked);
-  if (rule_worked) {
-    *worked = 1;
-    *l = rule_cpy;
-    return rule_res;
+  // Alternatives that can start with the next token
+  int viable;
+  switch (peek_kind(l)) {
+  case IDENTIFIER:
+    viable = 1 << 0 | 1 << 1;
+    break;
+  default:
+    return NULL;
+  }
+  lexer_t rule_cpy;
+  if (viable & (1 << 0)) {
+    rule_cpy = *l;
+    rule_res = parse_class_constructor_c0(&rule_cpy, &rule_worked);
+    if (rule_worked) {
+      *worked = 1;
+      *l = rule_cpy;
+      return rule_res;
+    }
   }
-  rule_cpy = *l;
-  rule_res = parse_class_constructor_c1(&rule_cpy, &rule_worked);
-  if (rule_worked) {
-    *worked = 1;
-    *l = rule_cpy;
-    return rule_res;
+  if (viable & (1 << 1)) {
+    rule_cpy = *l;
+    rule_res = parse_class_constructor_c1(&rule_cpy, &rule_worked);
+    if (rule_worked) {
+      *worked = 1;
+      *l = rule_cpy;
+      return rule_res;
+    }
   }
   return NULL;
 }
+void *parse_class_constructor(lexer_t *l, int *worked) {
+#ifdef PPARSER_MEMO
+  return memo_parse(l, worked, RULE_CLASS_CONSTRUCTOR,
+                    parse_class_constructor_impl);
+#else
+  return parse_class_constructor_impl(l, worked);
+#endif
+}
 
 // RULE class_body_item
-void *parse_class_body_item(lexer_t *l, int *worked) {
+void *parse_class_body_item_impl(lexer_t *l, int *worked) {
   *worked = 0;
   int rule_worked = 0;
   void *rule_res = NULL;
-  lexer_t rule_cpy = *l;
-  rule_res = parse_class_body_item_c0(&rule_cpy, &rule_worked);
-  if (rule_worked) {
-    *worked = 1;
-    *l = rule_cpy;
-    return rule_res;
+  // Alternatives that can start with the next token
+  int viable;
+  switch (peek_kind(l)) {
+  case KEY_PUBLIC:
+  case KEY_PRIVATE:
+    viable = 1 << 0 | 1 << 1 | 1 << 2;
+    break;
+  default:
+    viable = 1 << 0 | 1 << 1;
+    break;
+  }
+  lexer_t rule_cpy;
+  if (viable & (1 << 0)) {
+    rule_cpy = *l;
+    rule_res = parse_class_body_item_c0(&rule_cpy, &rule_worked);
+    if (rule_worked) {
+      *worked = 1;
+      *l = rule_cpy;
+      return rule_res;
+    }
   }
-  rule_cpy = *l;
-  rule_res = parse_class_body_item_c1(&rule_cpy, &rule_worked);
-  if (rule_worked) {
-    *worked = 1;
-    *l = rule_cpy;
-    return rule_res;
+  if (viable & (1 << 1)) {
+    rule_cpy = *l;
+    rule_res = parse_class_body_item_c1(&rule_cpy, &rule_worked);
+    if (rule_worked) {
+      *worked = 1;
+      *l = rule_cpy;
+      return rule_res;
+    }
   }
-  rule_cpy = *l;
-  rule_res = parse_class_body_item_c2(&rule_cpy, &rule_worked);
-  if (rule_worked) {
-    *worked = 1;
-    *l = rule_cpy;
-    return rule_res;
+  if (viable & (1 << 2)) {
+    rule_cpy = *l;
+    rule_res = parse_class_body_item_c2(&rule_cpy, &rule_worked);
+    if (rule_worked) {
+      *worked = 1;
+      *l = rule_cpy;
+      return rule_res;
+    }
   }
   return NULL;
 }
+void *parse_class_body_item(lexer_t *l, int *worked) {
+#ifdef PPARSER_MEMO
+  return memo_parse(l, worked, RULE_CLASS_BODY_ITEM,
+                    parse_class_body_item_impl);
+#else
+  return parse_class_body_item_impl(l, worked);
+#endif
+}
 
 // RULE class_decl
-void *parse_class_decl(lexer_t *l, int *worked) {
+void *parse_class_decl_impl(lexer_t *l, int *worked) {
   *worked = 0;
   int rule_worked = 0;
   void *rule_res = NULL;
-  lexer_t rule_cpy = *l;
-  rule_res = parse_class_decl_c0(&rule_cpy, &rule_worked);
-  if (rule_worked) {
-    *worked = 1;
-    *l = rule_cpy;
-    return rule_res;
+  // Alternatives that can start with the next token
+  int viable;
+  switch (peek_kind(l)) {
+  case KEY_CLASS:
+    viable = 1 << 0 | 1 << 1;
+    break;
+  default:
+    return NULL;
+  }
+  lexer_t rule_cpy;
+  if (viable & (1 << 0)) {
+    rule_cpy = *l;
+    rule_res = parse_class_decl_c0(&rule_cpy, &rule_worked);
+    if (rule_worked) {
+      *worked = 1;
+      *l = rule_cpy;
+      return rule_res;
+    }
   }
-  rule_cpy = *l;
-  rule_res = parse_class_decl_c1(&rule_cpy, &rule_worked);
-  if (rule_worked) {
-    *worked = 1;
-    *l = rule_cpy;
-    return rule_res;
+  if (viable & (1 << 1)) {
+    rule_cpy = *l;
+    rule_res = parse_class_decl_c1(&rule_cpy, &rule_worked);
+    if (rule_worked) {
+      *worked = 1;
+      *l = rule_cpy;
+      return rule_res;
+    }
   }
   return NULL;
 }
+void *parse_class_decl(lexer_t *l, int *worked) {
+#ifdef PPARSER_MEMO
+  return memo_parse(l, worked, RULE_CLASS_DECL, parse_class_decl_impl);
+#else
+  return parse_class_decl_impl(l, worked);
+#endif
+}
 
 // RULE if_statement
-void *parse_if_statement(lexer_t *l, int *worked) {
+void *parse_if_statement_impl(lexer_t *l, int *worked) {
   *worked = 0;
   int rule_worked = 0;
   void *rule_res = NULL;
-  lexer_t rule_cpy = *l;
-  rule_res = parse_if_statement_c0(&rule_cpy, &rule_worked);
-  if (rule_worked) {
-    *worked = 1;
-    *l = rule_cpy;
-    return rule_res;
+  // Alternatives that can start with the next token
+  int viable;
+  switch (peek_kind(l)) {
+  case KEY_IF:
+    viable = 1 << 0 | 1 << 1;
+    break;
+  default:
+    return NULL;
+  }
+  lexer_t rule_cpy;
+  if (viable & (1 << 0)) {
+    rule_cpy = *l;
+    rule_res = parse_if_statement_c0(&rule_cpy, &rule_worked);
+    if (rule_worked) {
+      *worked = 1;
+      *l = rule_cpy;
+      return rule_res;
+    }
   }
-  rule_cpy = *l;
-  rule_res = parse_if_statement_c1(&rule_cpy, &rule_worked);
-  if (rule_worked) {
-    *worked = 1;
-    *l = rule_cpy;
-    return rule_res;
+  if (viable & (1 << 1)) {
+    rule_cpy = *l;
+    rule_res = parse_if_statement_c1(&rule_cpy, &rule_worked);
+    if (rule_worked) {
+      *worked = 1;
+      *l = rule_cpy;
+      return rule_res;
+    }
   }
   return NULL;
 }
+void *parse_if_statement(lexer_t *l, int *worked) {
+#ifdef PPARSER_MEMO
+  return memo_parse(l, worked, RULE_IF_STATEMENT, parse_if_statement_impl);
+#else
+  return parse_if_statement_impl(l, worked);
+#endif
+}
 
 // RULE while_stmt
-void *parse_while_stmt(lexer_t *l, int *worked) {
+void *parse_while_stmt_impl(lexer_t *l, int *worked) {
   *worked = 0;
   int rule_worked = 0;
   void *rule_res = NULL;
@@ -1378,9 +2331,16 @@ void *parse_while_stmt(lexer_t *l, int *worked) {
   }
   return NULL;
 }
+void *parse_while_stmt(lexer_t *l, int *worked) {
+#ifdef PPARSER_MEMO
+  return memo_parse(l, worked, RULE_WHILE_STMT, parse_while_stmt_impl);
+#else
+  return parse_while_stmt_impl(l, worked);
+#endif
+}
 
 // RULE assignement
-void *parse_assignement(lexer_t *l, int *worked) {
+void *parse_assignement_impl(lexer_t *l, int *worked) {
   *worked = 0;
   int rule_worked = 0;
   void *rule_res = NULL;
@@ -1393,31 +2353,59 @@ void *parse_assignement(lexer_t *l, int *worked) {
   }
   return NULL;
 }
+void *parse_assignement(lexer_t *l, int *worked) {
+#ifdef PPARSER_MEMO
+  return memo_parse(l, worked, RULE_ASSIGNEMENT, parse_assignement_impl);
+#else
+  return parse_assignement_impl(l, worked);
+#endif
+}
 
 // RULE return
-void *parse_return(lexer_t *l, int *worked) {
+void *parse_return_impl(lexer_t *l, int *worked) {
   *worked = 0;
   int rule_worked = 0;
   void *rule_res = NULL;
-  lexer_t rule_cpy = *l;
-  rule_res = parse_return_c0(&rule_cpy, &rule_worked);
-  if (rule_worked) {
-    *worked = 1;
-    *l = rule_cpy;
-    return rule_res;
+  // Alternatives that can start with the next token
+  int viable;
+  switch (peek_kind(l)) {
+  case KEY_RETURN:
+    viable = 1 << 0 | 1 << 1;
+    break;
+  default:
+    return NULL;
+  }
+  lexer_t rule_cpy;
+  if (viable & (1 << 0)) {
+    rule_cpy = *l;
+    rule_res = parse_return_c0(&rule_cpy, &rule_worked);
+    if (rule_worked) {
+      *worked = 1;
+      *l = rule_cpy;
+      return rule_res;
+    }
   }
-  rule_cpy = *l;
-  rule_res = parse_return_c1(&rule_cpy, &rule_worked);
-  if (rule_worked) {
-    *worked = 1;
-    *l = rule_cpy;
-    return rule_res;
+  if (viable & (1 << 1)) {
+    rule_cpy = *l;
+    rule_res = parse_return_c1(&rule_cpy, &rule_worked);
+    if (rule_worked) {
+      *worked = 1;
+      *l = rule_cpy;
+      return rule_res;
+    }
   }
   return NULL;
 }
+void *parse_return(lexer_t *l, int *worked) {
+#ifdef PPARSER_MEMO
+  return memo_parse(l, worked, RULE_RETURN, parse_return_impl);
+#else
+  return parse_return_impl(l, worked);
+#endif
+}
 
 // RULE include_dir
-void *parse_include_dir(lexer_t *l, int *worked) {
+void *parse_include_dir_impl(lexer_t *l, int *worked) {
   *worked = 0;
   int rule_worked = 0;
   void *rule_res = NULL;
@@ -1430,86 +2418,126 @@ void *parse_include_dir(lexer_t *l, int *worked) {
   }
   return NULL;
 }
+void *parse_include_dir(lexer_t *l, int *worked) {
+#ifdef PPARSER_MEMO
+  return memo_parse(l, worked, RULE_INCLUDE_DIR, parse_include_dir_impl);
+#else
+  return parse_include_dir_impl(l, worked);
+#endif
+}
 
 // RULE proto
-void *parse_proto(lexer_t *l, int *worked) {
+void *parse_proto_impl(lexer_t *l, int *worked) {
   *worked = 0;
   int rule_worked = 0;
   void *rule_res = NULL;
-  lexer_t rule_cpy = *l;
-  rule_res = parse_proto_c0(&rule_cpy, &rule_worked);
-  if (rule_worked) {
-    *worked = 1;
-    *l = rule_cpy;
-    return rule_res;
+  // Alternatives that can start with the next token
+  int viable;
+  switch (peek_kind(l)) {
+  case IDENTIFIER:
+    viable = 1 << 0 | 1 << 1;
+    break;
+  default:
+    return NULL;
+  }
+  lexer_t rule_cpy;
+  if (viable & (1 << 0)) {
+    rule_cpy = *l;
+    rule_res = parse_proto_c0(&rule_cpy, &rule_worked);
+    if (rule_worked) {
+      *worked = 1;
+      *l = rule_cpy;
+      return rule_res;
+    }
   }
-  rule_cpy = *l;
-  rule_res = parse_proto_c1(&rule_cpy, &rule_worked);
-  if (rule_worked) {
-    *worked = 1;
-    *l = rule_cpy;
-    return rule_res;
+  if (viable & (1 << 1)) {
+    rule_cpy = *l;
+    rule_res = parse_proto_c1(&rule_cpy, &rule_worked);
+    if (rule_worked) {
+      *worked = 1;
+      *l = rule_cpy;
+      return rule_res;
+    }
   }
   return NULL;
 }
+void *parse_proto(lexer_t *l, int *worked) {
+#ifdef PPARSER_MEMO
+  return memo_parse(l, worked, RULE_PROTO, parse_proto_impl);
+#else
+  return parse_proto_impl(l, worked);
+#endif
+}
 
-void *parse_proto_list(lexer_t *l, int *worked) {
+void *parse_proto_list_impl(lexer_t *l, int *worked) {
   int rule_worked = 0;
-  size_t cap = 16;
-  size_t count = 0;
-  void **elems = malloc(sizeof(void *) * cap);
+  size_t base = list_stack.count;
   while (1) {
     lexer_t old = *l;
     void *elem = parse_proto(l, &rule_worked);
     if (!rule_worked) {
       break;
     }
-    if (count + 1 >= cap) {
-      cap += 16;
-      void **temp = realloc(elems, cap * sizeof(void *));
-      if (!temp) {
-        free(elems);
-        perror("Reallocation failed");
-        exit(1);
-      }
-      elems = temp;
-    }
-    elems[count++] = elem;
+    list_push(elem);
     old = *l;
-    (void)parse_token_lexeme(l, &rule_worked, SV(","));
+    (void)parse_token_kind(l, &rule_worked, COMMA);
     if (!rule_worked) {
       *l = old;
       break;
     }
   }
-  if (count + 1 >= cap) {
-    elems = realloc(elems, (count + 1) * sizeof(void *));
-  }
-  elems[count] = NULL;
-  *worked = count > 0;
-  return elems;
+  *worked = list_stack.count > base;
+  return list_pop(base);
+}
+void *parse_proto_list(lexer_t *l, int *worked) {
+#ifdef PPARSER_MEMO
+  return memo_parse(l, worked, RULE_PROTO_LIST, parse_proto_list_impl);
+#else
+  return parse_proto_list_impl(l, worked);
+#endif
 }
 // RULE interface
-void *parse_interface(lexer_t *l, int *worked) {
+void *parse_interface_impl(lexer_t *l, int *worked) {
   *worked = 0;
   int rule_worked = 0;
   void *rule_res = NULL;
-  lexer_t rule_cpy = *l;
-  rule_res = parse_interface_c0(&rule_cpy, &rule_worked);
-  if (rule_worked) {
-    *worked = 1;
-    *l = rule_cpy;
-    return rule_res;
+  // Alternatives that can start with the next token
+  int viable;
+  switch (peek_kind(l)) {
+  case IDENTIFIER:
+    viable = 1 << 0 | 1 << 1;
+    break;
+  default:
+    return NULL;
+  }
+  lexer_t rule_cpy;
+  if (viable & (1 << 0)) {
+    rule_cpy = *l;
+    rule_res = parse_interface_c0(&rule_cpy, &rule_worked);
+    if (rule_worked) {
+      *worked = 1;
+      *l = rule_cpy;
+      return rule_res;
+    }
   }
-  rule_cpy = *l;
-  rule_res = parse_interface_c1(&rule_cpy, &rule_worked);
-  if (rule_worked) {
-    *worked = 1;
-    *l = rule_cpy;
-    return rule_res;
+  if (viable & (1 << 1)) {
+    rule_cpy = *l;
+    rule_res = parse_interface_c1(&rule_cpy, &rule_worked);
+    if (rule_worked) {
+      *worked = 1;
+      *l = rule_cpy;
+      return rule_res;
+    }
   }
   return NULL;
 }
+void *parse_interface(lexer_t *l, int *worked) {
+#ifdef PPARSER_MEMO
+  return memo_parse(l, worked, RULE_INTERFACE, parse_interface_impl);
+#else
+  return parse_interface_impl(l, worked);
+#endif
+}
 
 void *parse_identifier_c0(lexer_t *l, int *worked) {
   *worked = 0;
@@ -1520,7 +2548,6 @@ void *parse_identifier_c0(lexer_t *l, int *worked) {
 
   token_t *ptr = elem_0;
   ast_t *res = new_identifier(*ptr);
-  free(ptr);
   return res;
 }
 void *parse_intlit_c0(lexer_t *l, int *worked) {
@@ -1532,7 +2559,6 @@ void *parse_intlit_c0(lexer_t *l, int *worked) {
 
   token_t *ptr = elem_0;
   ast_t *res = new_intlit(*ptr);
-  free(ptr);
   return res;
 }
 void *parse_floatlit_c0(lexer_t *l, int *worked) {
@@ -1544,7 +2570,6 @@ void *parse_floatlit_c0(lexer_t *l, int *worked) {
 
   token_t *ptr = elem_0;
   ast_t *res = new_floatlit(*ptr);
-  free(ptr);
   return res;
 }
 void *parse_charlit_c0(lexer_t *l, int *worked) {
@@ -1556,7 +2581,6 @@ void *parse_charlit_c0(lexer_t *l, int *worked) {
 
   token_t *ptr = elem_0;
   ast_t *res = new_charlit(*ptr);
-  free(ptr);
   return res;
 }
 void *parse_stringlit_c0(lexer_t *l, int *worked) {
@@ -1568,12 +2592,11 @@ void *parse_stringlit_c0(lexer_t *l, int *worked) {
 
   token_t *ptr = elem_0;
   ast_t *res = new_stringlit(*ptr);
-  free(ptr);
   return res;
 }
 void *parse_boollit_c0(lexer_t *l, int *worked) {
   *worked = 0;
-  free(parse_token_lexeme(l, worked, SV("true")));
+  (void)parse_token_kind(l, worked, KEY_TRUE);
   if (!*worked) {
     return NULL;
   }
@@ -1581,7 +2604,7 @@ void *parse_boollit_c0(lexer_t *l, int *worked) {
 }
 void *parse_boollit_c1(lexer_t *l, int *worked) {
   *worked = 0;
-  free(parse_token_lexeme(l, worked, SV("false")));
+  (void)parse_token_kind(l, worked, KEY_FALSE);
   if (!*worked) {
     return NULL;
   }
@@ -1633,7 +2656,7 @@ void *parse_param_c0(lexer_t *l, int *worked) {
   if (!*worked) {
     return NULL;
   }
-  free(parse_token_lexeme(l, worked, SV(":")));
+  (void)parse_token_kind(l, worked, COLON);
   if (!*worked) {
     return NULL;
   }
@@ -1648,7 +2671,7 @@ void *parse_param_c0(lexer_t *l, int *worked) {
 }
 void *parse_size_dir_c0(lexer_t *l, int *worked) {
   *worked = 0;
-  free(parse_token_lexeme(l, worked, SV("@size")));
+  (void)parse_token_lexeme(l, worked, SV("@size"));
   if (!*worked) {
     return NULL;
   }
@@ -1661,7 +2684,7 @@ void *parse_size_dir_c0(lexer_t *l, int *worked) {
 }
 void *parse_cast_like_dir_c0(lexer_t *l, int *worked) {
   *worked = 0;
-  free(parse_token_lexeme(l, worked, SV("@as")));
+  (void)parse_token_lexeme(l, worked, SV("@as"));
   if (!*worked) {
     return NULL;
   }
@@ -1678,7 +2701,7 @@ void *parse_cast_like_dir_c0(lexer_t *l, int *worked) {
 }
 void *parse_cast_like_dir_c1(lexer_t *l, int *worked) {
   *worked = 0;
-  free(parse_token_lexeme(l, worked, SV("@new")));
+  (void)parse_token_lexeme(l, worked, SV("@new"));
   if (!*worked) {
     return NULL;
   }
@@ -1763,7 +2786,7 @@ void *parse_stmt_c0(lexer_t *l, int *worked) {
   if (!*worked) {
     return NULL;
   }
-  free(parse_token_lexeme(l, worked, SV(";")));
+  (void)parse_token_kind(l, worked, SEMICOLON);
   if (!*worked) {
     return NULL;
   }
@@ -1876,7 +2899,7 @@ void *parse_binop_c0(lexer_t *l, int *worked) {
 }
 void *parse_paren_c0(lexer_t *l, int *worked) {
   *worked = 0;
-  free(parse_token_lexeme(l, worked, SV("(")));
+  (void)parse_token_kind(l, worked, OPEN_PAR);
   if (!*worked) {
     return NULL;
   }
@@ -1884,7 +2907,7 @@ void *parse_paren_c0(lexer_t *l, int *worked) {
   if (!*worked) {
     return NULL;
   }
-  free(parse_token_lexeme(l, worked, SV(")")));
+  (void)parse_token_kind(l, worked, CLOSE_PAR);
   if (!*worked) {
     return NULL;
   }
@@ -1914,12 +2937,7 @@ void *parse_type_c0(lexer_t *l, int *worked) {
     count++;
   }
 
-  for (size_t i = 0; i < count; ++i) {
-    free(starlist[i]);
-  }
-  free(starlist);
   token_t tok = iden->as.identifier.tok;
-  free_ast(iden);
   return new_type(tok, count, true, templ);
 }
 void *parse_type_c1(lexer_t *l, int *worked) {
@@ -1939,12 +2957,7 @@ void *parse_type_c1(lexer_t *l, int *worked) {
   while (starlist[count]) {
     count++;
   }
-  for (size_t i = 0; i < count; ++i) {
-    free(starlist[i]);
-  }
-  free(starlist);
   token_t tok = iden->as.identifier.tok;
-  free_ast(iden);
   return new_type(tok, count, false, NULL);
 }
 void *parse_type_c2(lexer_t *l, int *worked) {
@@ -1961,7 +2974,6 @@ void *parse_type_c2(lexer_t *l, int *worked) {
   ast_t *iden = elem_0;
   ast_t *templ = elem_1;
   token_t tok = iden->as.identifier.tok;
-  free_ast(iden);
   return new_type(tok, 0, true, templ);
 }
 void *parse_type_c3(lexer_t *l, int *worked) {
@@ -1973,7 +2985,6 @@ void *parse_type_c3(lexer_t *l, int *worked) {
 
   ast_t *iden = elem_0;
   token_t tok = iden->as.identifier.tok;
-  free_ast(iden);
   return new_type(tok, 0, false, NULL);
 }
 void *parse_unary_c0(lexer_t *l, int *worked) {
@@ -1994,22 +3005,22 @@ void *parse_unary_c0(lexer_t *l, int *worked) {
 }
 void *parse_compound_c0(lexer_t *l, int *worked) {
   *worked = 0;
-  free(parse_token_lexeme(l, worked, SV("{")));
+  (void)parse_token_kind(l, worked, OPEN_BRA);
   if (!*worked) {
     return NULL;
   }
-  free(parse_token_lexeme(l, worked, SV("}")));
+  (void)parse_token_kind(l, worked, CLOSE_BRA);
   if (!*worked) {
     return NULL;
   }
 
-  ast_t **res = malloc(sizeof(ast_t *));
+  ast_t **res = ast_alloc(sizeof(ast_t *));
   *res = NULL;
   return new_compound(res);
 }
 void *parse_compound_c1(lexer_t *l, int *worked) {
   *worked = 0;
-  free(parse_token_lexeme(l, worked, SV("{")));
+  (void)parse_token_kind(l, worked, OPEN_BRA);
   if (!*worked) {
     return NULL;
   }
@@ -2017,7 +3028,7 @@ void *parse_compound_c1(lexer_t *l, int *worked) {
   if (!*worked) {
     return NULL;
   }
-  free(parse_token_lexeme(l, worked, SV("}")));
+  (void)parse_token_kind(l, worked, CLOSE_BRA);
   if (!*worked) {
     return NULL;
   }
@@ -2038,7 +3049,7 @@ void *parse_tempelem_c0(lexer_t *l, int *worked) {
   if (!*worked) {
     return NULL;
   }
-  free(parse_token_lexeme(l, worked, SV("impl")));
+  (void)parse_token_lexeme(l, worked, SV("impl"));
   if (!*worked) {
     return NULL;
   }
@@ -2051,7 +3062,7 @@ void *parse_tempelem_c0(lexer_t *l, int *worked) {
 }
 void *parse_template_c0(lexer_t *l, int *worked) {
   *worked = 0;
-  free(parse_token_lexeme(l, worked, SV("<")));
+  (void)parse_token_kind(l, worked, LT);
   if (!*worked) {
     return NULL;
   }
@@ -2059,7 +3070,7 @@ void *parse_template_c0(lexer_t *l, int *worked) {
   if (!*worked) {
     return NULL;
   }
-  free(parse_token_lexeme(l, worked, SV(">")));
+  (void)parse_token_kind(l, worked, GT);
   if (!*worked) {
     return NULL;
   }
@@ -2067,7 +3078,7 @@ void *parse_template_c0(lexer_t *l, int *worked) {
 }
 void *parse_inst_template_c0(lexer_t *l, int *worked) {
   *worked = 0;
-  free(parse_token_lexeme(l, worked, SV("<")));
+  (void)parse_token_kind(l, worked, LT);
   if (!*worked) {
     return NULL;
   }
@@ -2075,7 +3086,7 @@ void *parse_inst_template_c0(lexer_t *l, int *worked) {
   if (!*worked) {
     return NULL;
   }
-  free(parse_token_lexeme(l, worked, SV(">")));
+  (void)parse_token_kind(l, worked, GT);
   if (!*worked) {
     return NULL;
   }
@@ -2089,11 +3100,11 @@ void *parse_fundef_letless_c0(lexer_t *l, int *worked) {
   if (!*worked) {
     return NULL;
   }
-  free(parse_template(l, worked));
+  (void)parse_template(l, worked);
   if (!*worked) {
     return NULL;
   }
-  free(parse_token_lexeme(l, worked, SV("(")));
+  (void)parse_token_kind(l, worked, OPEN_PAR);
   if (!*worked) {
     return NULL;
   }
@@ -2101,11 +3112,11 @@ void *parse_fundef_letless_c0(lexer_t *l, int *worked) {
   if (!*worked) {
     return NULL;
   }
-  free(parse_token_lexeme(l, worked, SV(")")));
+  (void)parse_token_kind(l, worked, CLOSE_PAR);
   if (!*worked) {
     return NULL;
   }
-  free(parse_token_lexeme(l, worked, SV(":")));
+  (void)parse_token_kind(l, worked, COLON);
   if (!*worked) {
     return NULL;
   }
@@ -2113,7 +3124,7 @@ void *parse_fundef_letless_c0(lexer_t *l, int *worked) {
   if (!*worked) {
     return NULL;
   }
-  free(parse_token_lexeme(l, worked, SV("=>")));
+  (void)parse_token_kind(l, worked, BIG_ARROW);
   if (!*worked) {
     return NULL;
   }
@@ -2127,7 +3138,6 @@ void *parse_fundef_letless_c0(lexer_t *l, int *worked) {
   tmp_param_t **tmp_arglist = elem_3;
   ast_t *stmt_list = elem_8;
   token_t tok = id->as.identifier.tok;
-  free_ast(id);
   return new_fundef_from_parser(tok, tmp_arglist, stmt_list, type);
 }
 void *parse_fundef_letless_c1(lexer_t *l, int *worked) {
@@ -2136,19 +3146,19 @@ void *parse_fundef_letless_c1(lexer_t *l, int *worked) {
   if (!*worked) {
     return NULL;
   }
-  free(parse_template(l, worked));
+  (void)parse_template(l, worked);
   if (!*worked) {
     return NULL;
   }
-  free(parse_token_lexeme(l, worked, SV("(")));
+  (void)parse_token_kind(l, worked, OPEN_PAR);
   if (!*worked) {
     return NULL;
   }
-  free(parse_token_lexeme(l, worked, SV(")")));
+  (void)parse_token_kind(l, worked, CLOSE_PAR);
   if (!*worked) {
     return NULL;
   }
-  free(parse_token_lexeme(l, worked, SV(":")));
+  (void)parse_token_kind(l, worked, COLON);
   if (!*worked) {
     return NULL;
   }
@@ -2156,7 +3166,7 @@ void *parse_fundef_letless_c1(lexer_t *l, int *worked) {
   if (!*worked) {
     return NULL;
   }
-  free(parse_token_lexeme(l, worked, SV("=>")));
+  (void)parse_token_kind(l, worked, BIG_ARROW);
   if (!*worked) {
     return NULL;
   }
@@ -2167,11 +3177,10 @@ void *parse_fundef_letless_c1(lexer_t *l, int *worked) {
 
   ast_t *id = elem_0;
   ast_t *type = elem_5;
-  tmp_param_t **tmp_arglist = malloc(sizeof(void *));
+  tmp_param_t **tmp_arglist = ast_alloc(sizeof(void *));
   tmp_arglist[0] = NULL;
   ast_t *stmt_list = elem_7;
   token_t tok = id->as.identifier.tok;
-  free_ast(id);
   return new_fundef_from_parser(tok, tmp_arglist, stmt_list, type);
 }
 void *parse_fundef_letless_c2(lexer_t *l, int *worked) {
@@ -2180,7 +3189,7 @@ void *parse_fundef_letless_c2(lexer_t *l, int *worked) {
   if (!*worked) {
     return NULL;
   }
-  free(parse_token_lexeme(l, worked, SV("(")));
+  (void)parse_token_kind(l, worked, OPEN_PAR);
   if (!*worked) {
     return NULL;
   }
@@ -2188,11 +3197,11 @@ void *parse_fundef_letless_c2(lexer_t *l, int *worked) {
   if (!*worked) {
     return NULL;
   }
-  free(parse_token_lexeme(l, worked, SV(")")));
+  (void)parse_token_kind(l, worked, CLOSE_PAR);
   if (!*worked) {
     return NULL;
   }
-  free(parse_token_lexeme(l, worked, SV(":")));
+  (void)parse_token_kind(l, worked, COLON);
   if (!*worked) {
     return NULL;
   }
@@ -2200,7 +3209,7 @@ void *parse_fundef_letless_c2(lexer_t *l, int *worked) {
   if (!*worked) {
     return NULL;
   }
-  free(parse_token_lexeme(l, worked, SV("=>")));
+  (void)parse_token_kind(l, worked, BIG_ARROW);
   if (!*worked) {
     return NULL;
   }
@@ -2214,7 +3223,6 @@ void *parse_fundef_letless_c2(lexer_t *l, int *worked) {
   tmp_param_t **tmp_arglist = elem_2;
   ast_t *stmt_list = elem_7;
   token_t tok = id->as.identifier.tok;
-  free_ast(id);
   return new_fundef_from_parser(tok, tmp_arglist, stmt_list, type);
 }
 void *parse_fundef_letless_c3(lexer_t *l, int *worked) {
@@ -2223,15 +3231,15 @@ void *parse_fundef_letless_c3(lexer_t *l, int *worked) {
   if (!*worked) {
     return NULL;
   }
-  free(parse_token_lexeme(l, worked, SV("(")));
+  (void)parse_token_kind(l, worked, OPEN_PAR);
   if (!*worked) {
     return NULL;
   }
-  free(parse_token_lexeme(l, worked, SV(")")));
+  (void)parse_token_kind(l, worked, CLOSE_PAR);
   if (!*worked) {
     return NULL;
   }
-  free(parse_token_lexeme(l, worked, SV(":")));
+  (void)parse_token_kind(l, worked, COLON);
   if (!*worked) {
     return NULL;
   }
@@ -2239,7 +3247,7 @@ void *parse_fundef_letless_c3(lexer_t *l, int *worked) {
   if (!*worked) {
     return NULL;
   }
-  free(parse_token_lexeme(l, worked, SV("=>")));
+  (void)parse_token_kind(l, worked, BIG_ARROW);
   if (!*worked) {
     return NULL;
   }
@@ -2250,16 +3258,15 @@ void *parse_fundef_letless_c3(lexer_t *l, int *worked) {
 
   ast_t *id = elem_0;
   ast_t *type = elem_4;
-  tmp_param_t **tmp_arglist = malloc(sizeof(void *));
+  tmp_param_t **tmp_arglist = ast_alloc(sizeof(void *));
   tmp_arglist[0] = NULL;
   ast_t *stmt_list = elem_6;
   token_t tok = id->as.identifier.tok;
-  free_ast(id);
   return new_fundef_from_parser(tok, tmp_arglist, stmt_list, type);
 }
 void *parse_fundef_c0(lexer_t *l, int *worked) {
   *worked = 0;
-  free(parse_token_lexeme(l, worked, SV("let")));
+  (void)parse_token_kind(l, worked, KEY_LET);
   if (!*worked) {
     return NULL;
   }
@@ -2271,7 +3278,7 @@ void *parse_fundef_c0(lexer_t *l, int *worked) {
 }
 void *parse_uop_c0(lexer_t *l, int *worked) {
   *worked = 0;
-  void *elem_0 = parse_token_lexeme(l, worked, SV("-"));
+  void *elem_0 = parse_token_kind(l, worked, MINUS);
   if (!*worked) {
     return NULL;
   }
@@ -2279,7 +3286,7 @@ void *parse_uop_c0(lexer_t *l, int *worked) {
 }
 void *parse_uop_c1(lexer_t *l, int *worked) {
   *worked = 0;
-  void *elem_0 = parse_token_lexeme(l, worked, SV("!"));
+  void *elem_0 = parse_token_kind(l, worked, NOT);
   if (!*worked) {
     return NULL;
   }
@@ -2287,7 +3294,7 @@ void *parse_uop_c1(lexer_t *l, int *worked) {
 }
 void *parse_uop_c2(lexer_t *l, int *worked) {
   *worked = 0;
-  void *elem_0 = parse_token_lexeme(l, worked, SV("$"));
+  void *elem_0 = parse_token_kind(l, worked, DEREF);
   if (!*worked) {
     return NULL;
   }
@@ -2295,7 +3302,7 @@ void *parse_uop_c2(lexer_t *l, int *worked) {
 }
 void *parse_uop_c3(lexer_t *l, int *worked) {
   *worked = 0;
-  void *elem_0 = parse_token_lexeme(l, worked, SV("&"));
+  void *elem_0 = parse_token_kind(l, worked, BIT_AND);
   if (!*worked) {
     return NULL;
   }
@@ -2307,7 +3314,7 @@ void *parse_vardef_letless_c0(lexer_t *l, int *worked) {
   if (!*worked) {
     return NULL;
   }
-  free(parse_token_lexeme(l, worked, SV(":")));
+  (void)parse_token_kind(l, worked, COLON);
   if (!*worked) {
     return NULL;
   }
@@ -2315,7 +3322,7 @@ void *parse_vardef_letless_c0(lexer_t *l, int *worked) {
   if (!*worked) {
     return NULL;
   }
-  free(parse_token_lexeme(l, worked, SV("=>")));
+  (void)parse_token_kind(l, worked, BIG_ARROW);
   if (!*worked) {
     return NULL;
   }
@@ -2326,7 +3333,6 @@ void *parse_vardef_letless_c0(lexer_t *l, int *worked) {
 
   ast_t *iden = elem_0;
   token_t tok = iden->as.identifier.tok;
-  free(iden);
   return new_vardef(tok, elem_2, elem_4);
 }
 void *parse_vardef_letless_c1(lexer_t *l, int *worked) {
@@ -2335,7 +3341,7 @@ void *parse_vardef_letless_c1(lexer_t *l, int *worked) {
   if (!*worked) {
     return NULL;
   }
-  free(parse_token_lexeme(l, worked, SV(":")));
+  (void)parse_token_kind(l, worked, COLON);
   if (!*worked) {
     return NULL;
   }
@@ -2346,12 +3352,11 @@ void *parse_vardef_letless_c1(lexer_t *l, int *worked) {
 
   ast_t *iden = elem_0;
   token_t tok = iden->as.identifier.tok;
-  free(iden);
   return new_vardef(tok, elem_2, NULL);
 }
 void *parse_vardef_c0(lexer_t *l, int *worked) {
   *worked = 0;
-  free(parse_token_lexeme(l, worked, SV("let")));
+  (void)parse_token_kind(l, worked, KEY_LET);
   if (!*worked) {
     return NULL;
   }
@@ -2359,7 +3364,7 @@ void *parse_vardef_c0(lexer_t *l, int *worked) {
   if (!*worked) {
     return NULL;
   }
-  free(parse_token_lexeme(l, worked, SV(";")));
+  (void)parse_token_kind(l, worked, SEMICOLON);
   if (!*worked) {
     return NULL;
   }
@@ -2367,7 +3372,7 @@ void *parse_vardef_c0(lexer_t *l, int *worked) {
 }
 void *parse_ct_cte_c0(lexer_t *l, int *worked) {
   *worked = 0;
-  free(parse_token_lexeme(l, worked, SV("@const")));
+  (void)parse_token_lexeme(l, worked, SV("@const"));
   if (!*worked) {
     return NULL;
   }
@@ -2379,20 +3384,19 @@ void *parse_ct_cte_c0(lexer_t *l, int *worked) {
   if (!*worked) {
     return NULL;
   }
-  free(parse_token_lexeme(l, worked, SV(";")));
+  (void)parse_token_kind(l, worked, SEMICOLON);
   if (!*worked) {
     return NULL;
   }
 
   token_t *iden_ptr = elem_1;
   token_t iden = *iden_ptr;
-  free(iden_ptr);
   ast_t *expr = elem_2;
   return new_ct_cte(iden, expr);
 }
 void *parse_access_spec_c0(lexer_t *l, int *worked) {
   *worked = 0;
-  void *elem_0 = parse_token_lexeme(l, worked, SV("public"));
+  void *elem_0 = parse_token_kind(l, worked, KEY_PUBLIC);
   if (!*worked) {
     return NULL;
   }
@@ -2400,7 +3404,7 @@ void *parse_access_spec_c0(lexer_t *l, int *worked) {
 }
 void *parse_access_spec_c1(lexer_t *l, int *worked) {
   *worked = 0;
-  void *elem_0 = parse_token_lexeme(l, worked, SV("private"));
+  void *elem_0 = parse_token_kind(l, worked, KEY_PRIVATE);
   if (!*worked) {
     return NULL;
   }
@@ -2444,7 +3448,7 @@ void *parse_class_constructor_c0(lexer_t *l, int *worked) {
   if (!*worked) {
     return NULL;
   }
-  free(parse_token_lexeme(l, worked, SV("(")));
+  (void)parse_token_kind(l, worked, OPEN_PAR);
   if (!*worked) {
     return NULL;
   }
@@ -2452,11 +3456,11 @@ void *parse_class_constructor_c0(lexer_t *l, int *worked) {
   if (!*worked) {
     return NULL;
   }
-  free(parse_token_lexeme(l, worked, SV(")")));
+  (void)parse_token_kind(l, worked, CLOSE_PAR);
   if (!*worked) {
     return NULL;
   }
-  free(parse_token_lexeme(l, worked, SV("=>")));
+  (void)parse_token_kind(l, worked, BIG_ARROW);
   if (!*worked) {
     return NULL;
   }
@@ -2469,7 +3473,6 @@ void *parse_class_constructor_c0(lexer_t *l, int *worked) {
   tmp_param_t **tmp_arglist = elem_2;
   ast_t *stmt_list = elem_5;
   token_t tok = id->as.identifier.tok;
-  free_ast(id);
   return new_fundef_from_parser(tok, tmp_arglist, stmt_list, NULL);
 }
 void *parse_class_constructor_c1(lexer_t *l, int *worked) {
@@ -2478,15 +3481,15 @@ void *parse_class_constructor_c1(lexer_t *l, int *worked) {
   if (!*worked) {
     return NULL;
   }
-  free(parse_token_lexeme(l, worked, SV("(")));
+  (void)parse_token_kind(l, worked, OPEN_PAR);
   if (!*worked) {
     return NULL;
   }
-  free(parse_token_lexeme(l, worked, SV(")")));
+  (void)parse_token_kind(l, worked, CLOSE_PAR);
   if (!*worked) {
     return NULL;
   }
-  free(parse_token_lexeme(l, worked, SV("=>")));
+  (void)parse_token_kind(l, worked, BIG_ARROW);
   if (!*worked) {
     return NULL;
   }
@@ -2496,11 +3499,10 @@ void *parse_class_constructor_c1(lexer_t *l, int *worked) {
   }
 
   ast_t *id = elem_0;
-  tmp_param_t **tmp_arglist = malloc(sizeof(void *));
+  tmp_param_t **tmp_arglist = ast_alloc(sizeof(void *));
   tmp_arglist[0] = NULL;
   ast_t *stmt_list = elem_4;
   token_t tok = id->as.identifier.tok;
-  free_ast(id);
   return new_fundef_from_parser(tok, tmp_arglist, stmt_list, NULL);
 }
 void *parse_class_body_item_c0(lexer_t *l, int *worked) {
@@ -2526,9 +3528,6 @@ void *parse_class_body_item_c0(lexer_t *l, int *worked) {
   token_t access_spec = *access_spec_ptr;
   uintptr_t abstract_opt = (uintptr_t)elem_0;
   uintptr_t static_opt = (uintptr_t)elem_2;
-  free(access_spec_ptr);
-  free(elem_0);
-  free(elem_2);
   ast_t *fundef = elem_3;
   return new_method(fundef, access_spec, abstract_opt != 0, static_opt != 0);
 }
@@ -2555,9 +3554,6 @@ void *parse_class_body_item_c1(lexer_t *l, int *worked) {
   token_t access_spec = *access_spec_ptr;
   uintptr_t abstract_opt = (uintptr_t)elem_0;
   uintptr_t static_opt = (uintptr_t)elem_2;
-  free(access_spec_ptr);
-  free(elem_0);
-  free(elem_2);
   ast_t *fundef = elem_3;
   return new_method(fundef, access_spec, abstract_opt != 0, static_opt != 0);
 }
@@ -2578,16 +3574,14 @@ void *parse_class_body_item_c2(lexer_t *l, int *worked) {
 
   token_t *access_spec_ptr = elem_0;
   token_t access_spec = *access_spec_ptr;
-  free(access_spec_ptr);
   ast_t *var = elem_2;
   uintptr_t static_opt = (uintptr_t)elem_1;
   int is_static = static_opt != 0;
-  free((void *)static_opt);
   return new_member(var, access_spec, is_static);
 }
 void *parse_class_decl_c0(lexer_t *l, int *worked) {
   *worked = 0;
-  free(parse_token_lexeme(l, worked, SV("class")));
+  (void)parse_token_kind(l, worked, KEY_CLASS);
   if (!*worked) {
     return NULL;
   }
@@ -2599,11 +3593,11 @@ void *parse_class_decl_c0(lexer_t *l, int *worked) {
   if (!*worked) {
     return NULL;
   }
-  free(parse_token_lexeme(l, worked, SV("=>")));
+  (void)parse_token_kind(l, worked, BIG_ARROW);
   if (!*worked) {
     return NULL;
   }
-  free(parse_token_lexeme(l, worked, SV("{")));
+  (void)parse_token_kind(l, worked, OPEN_BRA);
   if (!*worked) {
     return NULL;
   }
@@ -2611,7 +3605,7 @@ void *parse_class_decl_c0(lexer_t *l, int *worked) {
   if (!*worked) {
     return NULL;
   }
-  free(parse_token_lexeme(l, worked, SV("}")));
+  (void)parse_token_kind(l, worked, CLOSE_BRA);
   if (!*worked) {
     return NULL;
   }
@@ -2619,7 +3613,6 @@ void *parse_class_decl_c0(lexer_t *l, int *worked) {
   ast_t *temp = elem_1;
   ast_t *iden = elem_2;
   token_t name = iden->as.identifier.tok;
-  free_ast(iden);
   ast_t **body = elem_5;
   size_t count = 0;
   while (body[count]) {
@@ -2629,7 +3622,7 @@ void *parse_class_decl_c0(lexer_t *l, int *worked) {
 }
 void *parse_class_decl_c1(lexer_t *l, int *worked) {
   *worked = 0;
-  free(parse_token_lexeme(l, worked, SV("class")));
+  (void)parse_token_kind(l, worked, KEY_CLASS);
   if (!*worked) {
     return NULL;
   }
@@ -2637,11 +3630,11 @@ void *parse_class_decl_c1(lexer_t *l, int *worked) {
   if (!*worked) {
     return NULL;
   }
-  free(parse_token_lexeme(l, worked, SV("=>")));
+  (void)parse_token_kind(l, worked, BIG_ARROW);
   if (!*worked) {
     return NULL;
   }
-  free(parse_token_lexeme(l, worked, SV("{")));
+  (void)parse_token_kind(l, worked, OPEN_BRA);
   if (!*worked) {
     return NULL;
   }
@@ -2649,14 +3642,13 @@ void *parse_class_decl_c1(lexer_t *l, int *worked) {
   if (!*worked) {
     return NULL;
   }
-  free(parse_token_lexeme(l, worked, SV("}")));
+  (void)parse_token_kind(l, worked, CLOSE_BRA);
   if (!*worked) {
     return NULL;
   }
 
   ast_t *iden = elem_1;
   token_t name = iden->as.identifier.tok;
-  free_ast(iden);
   ast_t **body = elem_4;
   size_t count = 0;
   while (body[count]) {
@@ -2666,7 +3658,7 @@ void *parse_class_decl_c1(lexer_t *l, int *worked) {
 }
 void *parse_if_statement_c0(lexer_t *l, int *worked) {
   *worked = 0;
-  free(parse_token_lexeme(l, worked, SV("if")));
+  (void)parse_token_kind(l, worked, KEY_IF);
   if (!*worked) {
     return NULL;
   }
@@ -2674,7 +3666,7 @@ void *parse_if_statement_c0(lexer_t *l, int *worked) {
   if (!*worked) {
     return NULL;
   }
-  free(parse_token_lexeme(l, worked, SV("=>")));
+  (void)parse_token_kind(l, worked, BIG_ARROW);
   if (!*worked) {
     return NULL;
   }
@@ -2682,7 +3674,7 @@ void *parse_if_statement_c0(lexer_t *l, int *worked) {
   if (!*worked) {
     return NULL;
   }
-  free(parse_token_lexeme(l, worked, SV("else")));
+  (void)parse_token_kind(l, worked, KEY_ELSE);
   if (!*worked) {
     return NULL;
   }
@@ -2698,7 +3690,7 @@ void *parse_if_statement_c0(lexer_t *l, int *worked) {
 }
 void *parse_if_statement_c1(lexer_t *l, int *worked) {
   *worked = 0;
-  free(parse_token_lexeme(l, worked, SV("if")));
+  (void)parse_token_kind(l, worked, KEY_IF);
   if (!*worked) {
     return NULL;
   }
@@ -2706,7 +3698,7 @@ void *parse_if_statement_c1(lexer_t *l, int *worked) {
   if (!*worked) {
     return NULL;
   }
-  free(parse_token_lexeme(l, worked, SV("=>")));
+  (void)parse_token_kind(l, worked, BIG_ARROW);
   if (!*worked) {
     return NULL;
   }
@@ -2721,7 +3713,7 @@ void *parse_if_statement_c1(lexer_t *l, int *worked) {
 }
 void *parse_while_stmt_c0(lexer_t *l, int *worked) {
   *worked = 0;
-  free(parse_token_lexeme(l, worked, SV("while")));
+  (void)parse_token_kind(l, worked, KEY_WHILE);
   if (!*worked) {
     return NULL;
   }
@@ -2729,7 +3721,7 @@ void *parse_while_stmt_c0(lexer_t *l, int *worked) {
   if (!*worked) {
     return NULL;
   }
-  free(parse_token_lexeme(l, worked, SV("=>")));
+  (void)parse_token_kind(l, worked, BIG_ARROW);
   if (!*worked) {
     return NULL;
   }
@@ -2746,7 +3738,7 @@ void *parse_assignement_c0(lexer_t *l, int *worked) {
   if (!*worked) {
     return NULL;
   }
-  free(parse_token_lexeme(l, worked, SV("=>")));
+  (void)parse_token_kind(l, worked, BIG_ARROW);
   if (!*worked) {
     return NULL;
   }
@@ -2754,7 +3746,7 @@ void *parse_assignement_c0(lexer_t *l, int *worked) {
   if (!*worked) {
     return NULL;
   }
-  free(parse_token_lexeme(l, worked, SV(";")));
+  (void)parse_token_kind(l, worked, SEMICOLON);
   if (!*worked) {
     return NULL;
   }
@@ -2763,7 +3755,7 @@ void *parse_assignement_c0(lexer_t *l, int *worked) {
 }
 void *parse_return_c0(lexer_t *l, int *worked) {
   *worked = 0;
-  free(parse_token_lexeme(l, worked, SV("return")));
+  (void)parse_token_kind(l, worked, KEY_RETURN);
   if (!*worked) {
     return NULL;
   }
@@ -2771,7 +3763,7 @@ void *parse_return_c0(lexer_t *l, int *worked) {
   if (!*worked) {
     return NULL;
   }
-  free(parse_token_lexeme(l, worked, SV(";")));
+  (void)parse_token_kind(l, worked, SEMICOLON);
   if (!*worked) {
     return NULL;
   }
@@ -2780,11 +3772,11 @@ void *parse_return_c0(lexer_t *l, int *worked) {
 }
 void *parse_return_c1(lexer_t *l, int *worked) {
   *worked = 0;
-  free(parse_token_lexeme(l, worked, SV("return")));
+  (void)parse_token_kind(l, worked, KEY_RETURN);
   if (!*worked) {
     return NULL;
   }
-  free(parse_token_lexeme(l, worked, SV(";")));
+  (void)parse_token_kind(l, worked, SEMICOLON);
   if (!*worked) {
     return NULL;
   }
@@ -2792,7 +3784,7 @@ void *parse_return_c1(lexer_t *l, int *worked) {
 }
 void *parse_include_dir_c0(lexer_t *l, int *worked) {
   *worked = 0;
-  free(parse_token_lexeme(l, worked, SV("@include")));
+  (void)parse_token_lexeme(l, worked, SV("@include"));
   if (!*worked) {
     return NULL;
   }
@@ -2808,7 +3800,7 @@ void *parse_proto_c0(lexer_t *l, int *worked) {
   if (!*worked) {
     return NULL;
   }
-  free(parse_token_lexeme(l, worked, SV("(")));
+  (void)parse_token_kind(l, worked, OPEN_PAR);
   if (!*worked) {
     return NULL;
   }
@@ -2816,11 +3808,11 @@ void *parse_proto_c0(lexer_t *l, int *worked) {
   if (!*worked) {
     return NULL;
   }
-  free(parse_token_lexeme(l, worked, SV(")")));
+  (void)parse_token_kind(l, worked, CLOSE_PAR);
   if (!*worked) {
     return NULL;
   }
-  free(parse_token_lexeme(l, worked, SV(":")));
+  (void)parse_token_kind(l, worked, COLON);
   if (!*worked) {
     return NULL;
   }
@@ -2833,7 +3825,6 @@ void *parse_proto_c0(lexer_t *l, int *worked) {
   ast_t *type = elem_5;
   tmp_param_t **tmp_arglist = elem_2;
   token_t tok = id->as.identifier.tok;
-  free_ast(id);
   return new_fundef_from_parser(tok, tmp_arglist, NULL, type);
 }
 void *parse_proto_c1(lexer_t *l, int *worked) {
@@ -2842,15 +3833,15 @@ void *parse_proto_c1(lexer_t *l, int *worked) {
   if (!*worked) {
     return NULL;
   }
-  free(parse_token_lexeme(l, worked, SV("(")));
+  (void)parse_token_kind(l, worked, OPEN_PAR);
   if (!*worked) {
     return NULL;
   }
-  free(parse_token_lexeme(l, worked, SV(")")));
+  (void)parse_token_kind(l, worked, CLOSE_PAR);
   if (!*worked) {
     return NULL;
   }
-  free(parse_token_lexeme(l, worked, SV(":")));
+  (void)parse_token_kind(l, worked, COLON);
   if (!*worked) {
     return NULL;
   }
@@ -2859,17 +3850,16 @@ void *parse_proto_c1(lexer_t *l, int *worked) {
     return NULL;
   }
 
-  tmp_param_t **tmp_arglist = malloc(sizeof(void *));
+  tmp_param_t **tmp_arglist = ast_alloc(sizeof(void *));
   tmp_arglist[0] = NULL;
   ast_t *id = elem_0;
   ast_t *type = elem_4;
   token_t tok = id->as.identifier.tok;
-  free_ast(id);
   return new_fundef_from_parser(tok, tmp_arglist, NULL, type);
 }
 void *parse_interface_c0(lexer_t *l, int *worked) {
   *worked = 0;
-  free(parse_token_lexeme(l, worked, SV("interface")));
+  (void)parse_token_lexeme(l, worked, SV("interface"));
   if (!*worked) {
     return NULL;
   }
@@ -2881,11 +3871,11 @@ void *parse_interface_c0(lexer_t *l, int *worked) {
   if (!*worked) {
     return NULL;
   }
-  free(parse_token_lexeme(l, worked, SV("=>")));
+  (void)parse_token_kind(l, worked, BIG_ARROW);
   if (!*worked) {
     return NULL;
   }
-  free(parse_token_lexeme(l, worked, SV("{")));
+  (void)parse_token_kind(l, worked, OPEN_BRA);
   if (!*worked) {
     return NULL;
   }
@@ -2893,7 +3883,7 @@ void *parse_interface_c0(lexer_t *l, int *worked) {
   if (!*worked) {
     return NULL;
   }
-  free(parse_token_lexeme(l, worked, SV("}")));
+  (void)parse_token_kind(l, worked, CLOSE_BRA);
   if (!*worked) {
     return NULL;
   }
@@ -2902,8 +3892,6 @@ void *parse_interface_c0(lexer_t *l, int *worked) {
   ast_t *type_ptr = elem_2;
   token_t name = name_ptr->as.identifier.tok;
   token_t type = type_ptr->as.identifier.tok;
-  free_ast(name_ptr);
-  free_ast(type_ptr);
   ast_t **protos = elem_5;
   size_t protos_count = 0;
   while (protos[protos_count]) {
@@ -2913,7 +3901,7 @@ void *parse_interface_c0(lexer_t *l, int *worked) {
 }
 void *parse_interface_c1(lexer_t *l, int *worked) {
   *worked = 0;
-  free(parse_token_lexeme(l, worked, SV("interface")));
+  (void)parse_token_lexeme(l, worked, SV("interface"));
   if (!*worked) {
     return NULL;
   }
@@ -2925,15 +3913,15 @@ void *parse_interface_c1(lexer_t *l, int *worked) {
   if (!*worked) {
     return NULL;
   }
-  free(parse_token_lexeme(l, worked, SV("=>")));
+  (void)parse_token_kind(l, worked, BIG_ARROW);
   if (!*worked) {
     return NULL;
   }
-  free(parse_token_lexeme(l, worked, SV("{")));
+  (void)parse_token_kind(l, worked, OPEN_BRA);
   if (!*worked) {
     return NULL;
   }
-  free(parse_token_lexeme(l, worked, SV("}")));
+  (void)parse_token_kind(l, worked, CLOSE_BRA);
   if (!*worked) {
     return NULL;
   }
@@ -2942,9 +3930,7 @@ void *parse_interface_c1(lexer_t *l, int *worked) {
   ast_t *type_ptr = elem_2;
   token_t name = name_ptr->as.identifier.tok;
   token_t type = type_ptr->as.identifier.tok;
-  free_ast(name_ptr);
-  free_ast(type_ptr);
-  ast_t **protos = malloc(sizeof(void *));
+  ast_t **protos = ast_alloc(sizeof(void *));
   protos[0] = NULL;
   size_t protos_count = 0;
   return new_interface(type, name, protos, protos_count);